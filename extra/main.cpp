@@ -51,23 +51,32 @@ void printSemanticAnalysis(calpha::SemanticAnalyzer& analyzer, bool success) {
 
 // Args: 1. path/to/file.calpha
 //       2. path/to/output.alpha
+//       -O0    disable the IR passes and the peephole optimizer
 
 int main(int argc, char* argv[]) {
 
 #ifndef Debug
     if (argc < 3) {
-        std::cerr << "Usage: " << argv[0] << " <path/to/file.calpha>"  " <path/to/output.alpha>"<< std::endl;
+        std::cerr << "Usage: " << argv[0] << " <path/to/file.calpha>"  " <path/to/output.alpha> [-O0]"<< std::endl;
         return 1;
     }
 
     std::string filePath = argv[1];
     std::string outputPath = argv[2];
+    calpha::CodeGenOptions options;
+    for (int i = 3; i < argc; ++i) {
+        if (std::string(argv[i]) == "-O0") {
+            options.ir.enabled = false;
+            options.peephole.enabled = false;
+        }
+    }
     std::cout << "Compiling C-Alpha file: " << filePath << std::endl;
 #endif
 #ifdef Debug
 
     std::string filePath = "../alpha/lib/std/bitwise.calpha";
     std::string outputPath = "../alpha/out.alpha";
+    calpha::CodeGenOptions options;
 #endif
 
     // Convert paths to absolute
@@ -105,7 +114,7 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
-    calpha::CodeGenerator codeGen(&analyzer);
+    calpha::CodeGenerator codeGen(&analyzer, options);
     std::string alphaCode = codeGen.generate(program.get());
 
     // printSemanticAnalysis(analyzer, semanticSuccess);
@@ -0,0 +1,257 @@
+#ifndef CFG_HPP
+#define CFG_HPP
+
+#include "instruction.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace calpha {
+
+// Intermediate representation between code generation and Alpha_TUI text.
+// Instructions are the typed three-address form from instruction.hpp;
+// the control flow graph groups them into basic blocks with explicit
+// edges. Labels keep the qualified names of the code generator
+// (global::main, global::f::loop_1) until the emitter turns them into
+// Alpha_TUI labels.
+
+struct BasicBlock {
+    // Leading labels and trivia stay in `instructions`, so emitting the
+    // blocks in order reproduces the program
+    std::vector<Instruction> instructions;
+    std::vector<size_t> successors;
+    std::vector<size_t> predecessors;
+
+    // Labels naming the entry of the block
+    [[nodiscard]] std::vector<std::string> labels() const;
+    // Last significant instruction, or nullptr for a block of labels only
+    [[nodiscard]] const Instruction *terminator() const;
+    // Control can continue with the next block in layout order
+    [[nodiscard]] bool fallsThrough() const;
+};
+
+// Registers a "call" or "return" passes along. The caller keeps nothing
+// else in registers across a call, so no other register is live there. The
+// defaults assume every register convention the code generator uses.
+struct CallingConvention {
+    int argumentRegisters{7}; // "call" reads a1..a<argumentRegisters>
+    bool returnValueInRegister{true}; // "return" reads a0
+};
+
+// Whole-program control flow graph. Calls stay inside their block and fall
+// through; the call target is recorded as an entry instead, since every
+// "return" leaves the graph. Jumps to labels outside the program ("END")
+// end the program.
+class ControlFlowGraph {
+  private:
+    std::vector<BasicBlock> blocks; // In layout order
+    std::unordered_map<std::string, size_t> labelBlocks;
+    std::unordered_set<std::string> callTargets;
+    // Memory cells that only p(n) operands naming them read or write; no
+    // pointer refers to them, so stores through p(aN) and syscalls leave
+    // them alone
+    std::unordered_set<int64_t> directCells;
+    CallingConvention convention;
+
+  public:
+    ControlFlowGraph() = default;
+    explicit ControlFlowGraph(const std::vector<Instruction> &program);
+
+    // Recomputes labels and edges after instructions changed. Passes that
+    // add or remove jumps, labels or blocks have to call this.
+    void rebuildEdges();
+
+    [[nodiscard]] std::vector<BasicBlock> &getBlocks() {
+        return blocks;
+    }
+    [[nodiscard]] const std::vector<BasicBlock> &getBlocks() const {
+        return blocks;
+    }
+    [[nodiscard]] std::optional<size_t>
+    findBlock(const std::string &label) const;
+    void setDirectCells(std::unordered_set<int64_t> cells) {
+        directCells = std::move(cells);
+    }
+    [[nodiscard]] bool isDirectCell(int64_t address) const {
+        return directCells.contains(address);
+    }
+    void setCallingConvention(CallingConvention value) {
+        convention = value;
+    }
+    [[nodiscard]] const CallingConvention &getCallingConvention() const {
+        return convention;
+    }
+    // True if some "call" targets one of the block's labels
+    [[nodiscard]] bool isCallTarget(size_t block) const;
+    // Control may enter the block other than through its predecessors: it
+    // is the first block, holds the program entry global::main, is a call
+    // target or has no predecessors
+    [[nodiscard]] bool isEntry(size_t block) const;
+
+    // Blocks reachable from `entry` through jumps, fall-through and calls
+    [[nodiscard]] std::vector<bool>
+    reachableFrom(const std::string &entry) const;
+
+    // Instructions of all blocks in layout order
+    [[nodiscard]] std::vector<Instruction> flatten() const;
+};
+
+// ============================================================================
+// Analyses
+// ============================================================================
+
+// Registers a0..a7 as a bit set
+using RegisterSet = uint8_t;
+
+[[nodiscard]] constexpr RegisterSet registerBit(int64_t reg) {
+    return static_cast<RegisterSet>(1U << reg);
+}
+
+// Registers the instruction reads or writes. Calls and returns read the
+// registers the convention passes to the callee or back to the caller.
+[[nodiscard]] RegisterSet registersRead(const Instruction &instr,
+                                        const CallingConvention &convention);
+[[nodiscard]] RegisterSet registersWritten(const Instruction &instr);
+
+struct RegisterLiveness {
+    std::vector<RegisterSet> liveIn;  // Per block, at its first instruction
+    std::vector<RegisterSet> liveOut; // Per block, after its terminator
+};
+
+[[nodiscard]] RegisterLiveness
+computeRegisterLiveness(const ControlFlowGraph &cfg);
+
+// dominators[b][d] is true if every path from an entry to block b passes
+// through block d (see ControlFlowGraph::isEntry)
+[[nodiscard]] std::vector<std::vector<bool>>
+computeDominators(const ControlFlowGraph &cfg);
+
+// Natural loop: the header and all blocks that reach a back edge to it
+// without passing the header
+struct Loop {
+    size_t header;
+    std::vector<size_t> blocks; // Sorted, includes the header
+    std::unordered_set<size_t> members;
+
+    [[nodiscard]] bool contains(size_t block) const {
+        return members.contains(block);
+    }
+};
+
+// Loops of the graph, inner loops before the loops containing them
+[[nodiscard]] std::vector<Loop>
+findLoops(const ControlFlowGraph &cfg,
+          const std::vector<std::vector<bool>> &dominators);
+
+// Static single assignment form of the values the passes can track: the
+// registers a0..a7 (variables 0..7) and the direct memory cells (variables
+// from kRegisterVariables on). The instructions stay as they are; every
+// read and write of a variable is annotated with the SSA name it uses or
+// defines, and phis are recorded per block. Entering the graph at an entry
+// defines every variable with an unknown value.
+struct SsaForm {
+    using Name = size_t;
+    static constexpr int kRegisterVariables = 8;
+    static constexpr Name kUndefined = 0; // No definition reaches the use
+    // Predecessor of an entry standing for control entering from outside
+    static constexpr size_t kOutside = SIZE_MAX;
+
+    enum class DefinitionKind { UNDEFINED, ENTRY, PHI, INSTRUCTION };
+
+    struct Definition {
+        DefinitionKind kind;
+        int variable;
+        size_t block; // Unused for ENTRY and UNDEFINED
+        size_t index; // Phi or instruction index within the block
+    };
+
+    struct Phi {
+        Name name;
+        int variable;
+        // One name per predecessor (and per kOutside for entries)
+        std::vector<std::pair<size_t, Name>> operands;
+    };
+
+    struct Access {
+        int variable;
+        Name name;
+    };
+
+    // Names an instruction reads and writes. A call defines every register
+    // and the cells the called code stores.
+    struct InstructionNames {
+        std::vector<Access> uses;
+        std::vector<Access> defs;
+    };
+
+    std::map<int64_t, int> cellVariables; // Direct cell -> variable
+    std::vector<Definition> definitions;  // Indexed by name
+    std::vector<std::vector<Phi>> phis;   // Per block
+    // Per block, per instruction of BasicBlock::instructions
+    std::vector<std::vector<InstructionNames>> instructions;
+    std::vector<bool> reachable; // Per block, from some entry
+
+    // Variable the operand reads: the register of aN and p(aN), the
+    // variable of a direct cell p(n); -1 otherwise
+    [[nodiscard]] int variableOf(const Operand &operand) const;
+    // Name of `variable` the instruction reads, kUndefined if it reads none
+    [[nodiscard]] Name nameUsed(size_t block, size_t index,
+                                int variable) const;
+};
+
+[[nodiscard]] SsaForm buildSsaForm(const ControlFlowGraph &cfg);
+
+// ============================================================================
+// Passes
+// ============================================================================
+
+struct IrOptions {
+    bool enabled{true};
+    // Names of passes from IrPassManager::getPassNames() to skip
+    std::unordered_set<std::string> disabledPasses;
+};
+
+// A transformation of the control flow graph; returns true on a change
+struct IrPass {
+    std::string name;
+    std::function<bool(ControlFlowGraph &cfg)> run;
+};
+
+// Runs the passes in table order, each once
+class IrPassManager {
+  private:
+    IrOptions options;
+    std::vector<IrPass> passes;
+    std::map<std::string, int> statistics; // pass name -> changed runs
+
+    static std::vector<IrPass> createDefaultPasses();
+
+  public:
+    explicit IrPassManager(IrOptions options = {});
+
+    void run(ControlFlowGraph &cfg);
+
+    [[nodiscard]] std::vector<std::string> getPassNames() const;
+    [[nodiscard]] const std::map<std::string, int> &getStatistics() const {
+        return statistics;
+    }
+};
+
+// Alpha_TUI spelling of a qualified label: the global:: scope is dropped
+// and nested scopes are joined by "_"
+[[nodiscard]] std::string alphaLabelName(const std::string &qualified);
+
+// Emits the graph as an Alpha_TUI program with plain labels
+[[nodiscard]] std::vector<Instruction>
+emitAlphaProgram(const ControlFlowGraph &cfg);
+
+} // namespace calpha
+
+#endif // CFG_HPP
@@ -1,12 +1,18 @@
 #ifndef CODEGEN_HPP
 #define CODEGEN_HPP
 
+#include "cfg.hpp"
 #include "parser.hpp"
+#include "peephole.hpp"
 #include "semantic.hpp"
+#include <algorithm>
+#include <functional>
 #include <iostream>
+#include <iterator>
 #include <memory>
+#include <optional>
 #include <ranges>
-#include <sstream>
+#include <set>
 #include <stack>
 #include <string>
 #include <unordered_map>
@@ -18,7 +24,7 @@ namespace calpha {
 
 class RegisterAllocator {
   private:
-    std::unordered_set<int> availableRegisters;
+    std::set<int> availableRegisters; // Lowest index is handed out first
     std::unordered_map<std::string, int> variableToRegister;
 
   public:
@@ -31,6 +37,7 @@ class RegisterAllocator {
     [[nodiscard]] int getVariableRegister(const std::string &variableName) const;
     [[nodiscard]] static std::string getRegisterName(int registerIndex);
     [[nodiscard]] bool hasAvailableRegister() const;
+    [[nodiscard]] int getAvailableRegisterCount() const;
     void clearAll();
 };
 
@@ -38,6 +45,8 @@ class RegisterAllocator {
 class MemoryManager {
   private:
     int nextMemoryAddress{1};
+    // Highest address ever handed out; scopes reuse memory below it
+    int highestMemoryAddress{0};
 
     // Scope stack for variable management using FQDNs
     std::vector<std::unordered_map<std::string, int>> scopeStack;
@@ -45,6 +54,10 @@ class MemoryManager {
     // Track the memory high-water mark for each scope
     std::vector<int> scopeMemoryStart;
 
+    // Cells handed out by allocateArray; code may reach them through
+    // computed addresses
+    std::unordered_set<int> arrayCells;
+
     // Layout member offsets (global)
     std::unordered_map<std::string, std::unordered_map<std::string, int>>
         layoutMemberOffsets;
@@ -77,6 +90,20 @@ class MemoryManager {
         return nextMemoryAddress;
     }
 
+    [[nodiscard]] int getHighestMemoryAddress() const {
+        return highestMemoryAddress;
+    }
+
+    void setHighestMemoryAddress(int address) {
+        highestMemoryAddress = address;
+    }
+
+    // Place the following allocations of the current scope at `address`;
+    // popScope() still returns to where the scope started
+    void setNextMemoryAddress(int address) {
+        nextMemoryAddress = address;
+    }
+
     // Scope management
     void pushScope(const std::string &scopeName) {
         scopeStack.emplace_back();
@@ -99,6 +126,38 @@ class MemoryManager {
         currentScopePath.pop_back();
     }
 
+    // Scopes above the global one, set aside so that lookups skip them.
+    // Their variables keep their memory; scopes pushed meanwhile allocate
+    // above it.
+    struct HiddenScopes {
+        std::vector<std::unordered_map<std::string, int>> scopes;
+        std::vector<int> memoryStarts;
+        std::vector<std::string> path;
+    };
+
+    HiddenScopes hideLocalScopes() {
+        HiddenScopes hidden;
+        hidden.scopes.assign(std::make_move_iterator(scopeStack.begin() + 1),
+                             std::make_move_iterator(scopeStack.end()));
+        hidden.memoryStarts.assign(scopeMemoryStart.begin() + 1,
+                                   scopeMemoryStart.end());
+        hidden.path.assign(currentScopePath.begin() + 1,
+                           currentScopePath.end());
+        scopeStack.resize(1);
+        scopeMemoryStart.resize(1);
+        currentScopePath.resize(1);
+        return hidden;
+    }
+
+    void restoreLocalScopes(HiddenScopes hidden) {
+        std::ranges::move(hidden.scopes, std::back_inserter(scopeStack));
+        scopeMemoryStart.insert(scopeMemoryStart.end(),
+                                hidden.memoryStarts.begin(),
+                                hidden.memoryStarts.end());
+        currentScopePath.insert(currentScopePath.end(), hidden.path.begin(),
+                                hidden.path.end());
+    }
+
     // Variable memory management with FQDN support
     int allocateMemory(const std::string &fqdn, int size = 1) {
         if (hasVariableInCurrentScope(fqdn)) {
@@ -110,15 +169,42 @@ class MemoryManager {
         const int address = nextMemoryAddress;
         scopeStack.back()[fqdn] = address;
         nextMemoryAddress += size;
+        highestMemoryAddress =
+            std::max(highestMemoryAddress, nextMemoryAddress - 1);
         return address;
     }
 
-    int allocateArray(const int size) {
+    // Map a variable to a cell reserved earlier (see reserveMemory)
+    void bindMemory(const std::string &fqdn, int address) {
+        if (hasVariableInCurrentScope(fqdn)) {
+            throw std::runtime_error(
+                "Variable '" + fqdn +
+                "' already has memory allocated in current scope");
+        }
+        scopeStack.back()[fqdn] = address;
+    }
+
+    // Set aside `size` cells of the current scope without naming them
+    int reserveMemory(const int size) {
         const int address = nextMemoryAddress;
         nextMemoryAddress += size;
+        highestMemoryAddress =
+            std::max(highestMemoryAddress, nextMemoryAddress - 1);
+        return address;
+    }
+
+    int allocateArray(const int size) {
+        const int address = reserveMemory(size);
+        for (int cell = address; cell < address + size; ++cell) {
+            arrayCells.insert(cell);
+        }
         return address;
     }
 
+    [[nodiscard]] const std::unordered_set<int> &getArrayCells() const {
+        return arrayCells;
+    }
+
     [[nodiscard]] int getVariableAddress(const std::string &fqdn) const {
         // Search from current scope upwards
         for (const auto &it : std::ranges::reverse_view(scopeStack)) {
@@ -166,9 +252,11 @@ class MemoryManager {
 
     void clearAll() {
         nextMemoryAddress = 1;
+        highestMemoryAddress = 0;
         scopeStack.clear();
         scopeMemoryStart.clear();
         layoutMemberOffsets.clear();
+        arrayCells.clear();
         currentScopePath.clear();
         // Reinitialize global scope
         scopeStack.emplace_back();
@@ -189,10 +277,110 @@ class LabelGenerator {
     void reset();
 };
 
+// Knobs for the code generator and the passes run on its output
+struct CodeGenOptions {
+    // Passes over the control flow graph of the generated program; the
+    // peephole optimizer runs on the emitted Alpha_TUI afterwards
+    IrOptions ir;
+    PeepholeOptions peephole;
+    // Target accepts "&", "|" and "^" in Alpha_TUI expressions. Without it
+    // bitwise operators are lowered to arithmetic or a runtime routine.
+    bool nativeBitwise{false};
+    // Evaluate call-free expression trees in a0-a7 instead of on the stack
+    bool registerExpressions{true};
+    // Let the instruction selector use variables and dereferenced pointers
+    // as p(n) / p(aN) operands and store results straight into memory
+    // (p(i) := p(i) + 1) instead of loading every value into a register
+    bool memoryOperands{true};
+    // Only emit functions reachable from main through the call graph
+    bool eliminateDeadFunctions{true};
+    // Test while conditions at the bottom of the loop behind a single guard
+    bool rotateLoops{true};
+    // Place function frames by the call graph so that only functions that
+    // can be active together get disjoint memory. Calls inside a recursive
+    // cycle save the caller's frame on the stack.
+    bool overlayFrames{true};
+    // Let scalar locals whose live ranges never overlap share a frame cell
+    bool shareVariableSlots{true};
+    // Calling convention. With registerCalls the first seven arguments are
+    // passed in a1..a7 (further ones on the stack as before) and the
+    // result comes back in a0; without it every argument and the result go
+    // through the stack. All registers are caller-saved: nothing is kept in
+    // a register across a call. main keeps the stack convention because
+    // its result is the program's exit value.
+    bool registerCalls{true};
+    // Turn `ret f(...)` into a jump to f instead of a call and a return
+    bool tailCalls{true};
+    // Store each distinct string literal once, before main runs, instead of
+    // at every evaluation
+    bool poolStrings{true};
+    // Block fills and copies (array zeroing, layout copies) of more cells
+    // than this run as a loop instead of one store per cell
+    int blockUnrollLimit{16};
+    // Skip zeroing arrays whose elements are all stored right after the
+    // allocation
+    bool elideFilledArrayZeroing{true};
+    // Layout instances hold only their members. With false, the original
+    // format keeps each instance's own address in an extra first cell.
+    bool compactLayouts{true};
+    // Substitute bodies of small call-free functions at their call sites.
+    // inlineCostLimit bounds the number of AST nodes in an inlined body.
+    bool inlineFunctions{true};
+    int inlineCostLimit{24};
+};
+
+// Code of one function, generated separately so that functions main
+// never reaches can be left out of the program
+struct FunctionCode {
+    std::string label;
+    std::vector<Instruction> code;
+    std::unordered_set<std::string> callees;
+    std::unordered_set<TokenType> bitwiseOperations;
+    int frameBase;            // First memory cell of the function's frame
+    int highestMemoryAddress; // Last cell used by the frame
+    int staticDataSize;       // Cells of arrays outside the frame
+    std::set<std::string> stringLiterals; // Pooled literals the code uses
+    std::unordered_set<int> scalarCells;  // See CodeGenerator::scalarCells
+    std::unordered_set<int> exposedCells;
+};
+
+// Static memory of one function frame and its recursive component (calls
+// within the same component re-enter a live frame)
+struct FrameLayout {
+    int base;
+    int size;
+    int component;
+};
+
+// Instruction selection: instructions needed to deliver a value to the
+// instruction using it, per operand form. kNoTile marks forms the value can
+// not take.
+struct TileCosts {
+    static constexpr int kNoTile = 1 << 20;
+    int immediate{kNoTile}; // A constant
+    int memory{kNoTile};    // p(n), or p(aN) with the address in aN
+    int reg{kNoTile};       // A register holding the value
+};
+
+// Operand chosen by the selector: `fixed` (an immediate or p(n)) when no
+// register is involved, otherwise aN or, if indirect, p(aN)
+struct SelectedOperand {
+    Operand fixed;
+    int reg{-1};
+    bool indirect{false};
+
+    [[nodiscard]] Operand toOperand() const;
+};
+
 // Main code generator class
 class CodeGenerator {
   private:
-    std::ostringstream output;
+    // Arguments passed in a1..a7 under CodeGenOptions::registerCalls
+    static constexpr int argumentRegisterCount = 7;
+
+    CodeGenOptions options;
+    // Code of the globals, or of the function being generated
+    std::vector<Instruction> output;
     RegisterAllocator registerAllocator;
     MemoryManager memoryManager;
     LabelGenerator labelGenerator;
@@ -210,14 +398,78 @@ class CodeGenerator {
     std::string currentFunction;
     std::unordered_map<std::string, int> functionParameterCounts;
 
+    // Operators that need the table-driven bitwise runtime routine
+    std::unordered_set<TokenType> bitwiseRuntimeOperations;
+
+    // Call graph: functions in output order and the calls of the function
+    // currently being generated
+    std::vector<FunctionCode> functionCodes;
+    std::unordered_set<std::string> currentCallees;
+    std::string currentFunctionLabel;
+
+    // Frame placement computed by a layout pass over the whole program
+    std::unordered_map<std::string, FrameLayout> frameLayouts;
+    // String literals, each stored once and initialized before main runs
+    std::unordered_map<std::string, int> stringPool;
+    std::set<std::string> currentStringLiterals;
+    // Literals the program may write through keep their per-evaluation
+    // stores: a pooled literal would carry the writes into its next use
+    std::unordered_set<std::string> writtenStringLiterals;
+    [[nodiscard]] static std::unordered_set<std::string>
+    findWrittenStringLiterals(const Program *program);
+    // Arrays of functions, placed above the string pool and below the frames
+    int staticDataBase{0};
+    int staticDataSize{0};
+    std::unordered_set<std::string> discardedFunctions;
+
+    // Frame cells of the current function's parameters and scalar locals,
+    // keyed by their Parameter / VariableDeclaration node
+    std::unordered_map<const ASTNode *, int> variableSlots;
+
+    // Layout variables that own their member cells and are copied by value
+    std::unordered_set<std::string> layoutValueVariables;
+    // Cells per layout instance, computed once per layout
+    std::unordered_map<std::string, int> layoutSizes;
+
+    // Allocations whose elements are all written before any is read
+    std::unordered_set<const ArrayAllocation *> filledAllocations;
+
+    // Cells of scalar variables and parameters, and cells whose address the
+    // program takes, of the code being generated (globals or one function).
+    // Scalar cells no pointer can reach are only accessed as p(n), which
+    // the graph passes rely on (ControlFlowGraph::directCells).
+    std::unordered_set<int> scalarCells;
+    std::unordered_set<int> exposedCells;
+    // Cells of the globals and the linked functions below `runtimeBase`
+    // (where the runtime tables start) outside the string pool
+    [[nodiscard]] std::unordered_set<int64_t>
+    collectDirectCells(const std::unordered_set<std::string> &reachable,
+                       const std::set<std::string> &literals,
+                       int runtimeBase) const;
+
+    // Inlining: declarations small enough to substitute at call sites (by
+    // label) and the end labels of the bodies currently being inlined
+    std::unordered_map<std::string, const FunctionDeclaration *>
+        inlineCandidates;
+    std::vector<std::string> inlineReturnLabels;
+
     // Variable type tracking for layout member access using FQDNs
     std::unordered_map<std::string, std::string>
         variableLayoutTypes; // FQDN -> Layout FQDN
 
     // Helper methods
-    void emit(const std::string &instruction);
+    void emit(Instruction instruction, const std::string &comment = "");
+    void emitAssign(Operand destination, Operand source,
+                    const std::string &comment = "");
+    void emitBinary(Operand destination, Operand lhs, AlphaOperator operation,
+                    Operand rhs, const std::string &comment = "");
+    void emitJump(const std::string &target, const std::string &comment = "");
+    void emitConditionalJump(Operand lhs, AlphaOperator operation, Operand rhs,
+                             const std::string &target,
+                             const std::string &comment = "");
     void emitComment(const std::string &comment);
     void emitLabel(const std::string &label);
+    void emitBlankLine();
 
     // FQDN helper methods
     std::string getVariableFQDN(const std::string &name);
@@ -232,7 +484,7 @@ class CodeGenerator {
     void pushRegisterToStack(int registerIndex,
                              const std::string &comment = "");
     void popStackToRegister(int registerIndex, const std::string &comment = "");
-    void emitStackOperation(const std::string &operation,
+    void emitStackOperation(AlphaOperator operation,
                             const std::string &comment = "");
 
     // Memory operations with FQDN support
@@ -246,11 +498,44 @@ class CodeGenerator {
     // Expression evaluation
     void generateExpression(const Expression *expr);
     void generateBinaryExpression(const BinaryExpression *binExpr);
+    void generateBitwiseExpression(const BinaryExpression *binExpr);
+    void generateLogicalExpression(const BinaryExpression *binExpr);
+    void generateMaskOperation(int64_t modulus);
+    void generateBitwiseRuntime(int tableBase);
+    [[nodiscard]] std::vector<TokenType> getBitwiseRuntimeOperations() const;
+    [[nodiscard]] std::vector<Instruction>
+    generateBitwiseTables(int tableBase) const;
+    static std::string getBitwiseRuntimeLabel(TokenType operation);
+    static bool isBooleanExpression(const Expression *expr);
     void generateUnaryExpression(const UnaryExpression *unExpr);
     void generateIdentifier(const Identifier *iden);
     void generateLiteral(const Literal *lit);
     void generateStringLiteral(const StringLiteral *stringLit);
+    int internString(const std::string &value);
+    [[nodiscard]] std::vector<Instruction>
+    generateStringPool(const std::set<std::string> &literals) const;
     void generateFunctionCall(const FunctionCall *funcCall);
+    std::string resolveFunctionLabel(const FunctionCall *funcCall) const;
+    bool tryGenerateTailCall(const FunctionCall *funcCall);
+    void generateArgumentRegisters(
+        const std::vector<std::unique_ptr<Expression>> &arguments,
+        size_t count, int firstRegister);
+    bool usesRegisterCalls(const std::string &functionLabel) const;
+    static bool containsCall(const Expression *expr);
+    static bool
+    anySubexpression(const Expression *expr,
+                     const std::function<bool(const Expression *)> &predicate);
+    void markFilledAllocation(
+        const std::vector<std::unique_ptr<Statement>> &statements,
+        size_t index);
+    void generateBlockFill(int destination, int size, int64_t value);
+    void generateBlockCopy(int destination, int size);
+    void generateLayoutCopy(const Expression *source,
+                            const std::string &varFQDN,
+                            const std::string &layoutName);
+    void generateInlineCall(const FunctionCall *funcCall,
+                            const FunctionDeclaration *funcDecl);
+    static int getInlineCost(const ASTNode *node);
     void generateArrayAccess(const ArrayAccess *arrayAccess);
     void generateMemberAccess(const MemberAccess *memberAccess);
 
@@ -259,6 +544,46 @@ class CodeGenerator {
     void generateTypeCast(const TypeCast *typeCast);
     void generateLayoutInitialization(const LayoutInitialization *layoutInit);
 
+    // Register-based evaluation of call-free expression trees. Registers are
+    // ordered by Sethi-Ullman numbering and only live inside one tree, so
+    // calls and syscalls (which clobber a0-a7) never see them.
+    bool isRegisterExpression(const Expression *expr);
+    int getRegisterNeed(const Expression *expr);
+    int getOperandNeed(const Expression *expr, bool allowImmediate);
+    int getBinaryRegisterNeed(const Expression *left, const Expression *right);
+    int generateRegisterExpression(const Expression *expr);
+    std::pair<SelectedOperand, SelectedOperand>
+    generateRegisterOperands(const Expression *left, const Expression *right);
+    static bool isImmediateOperand(const Expression *expr);
+
+    // Instruction selection over register expressions: labelTiles costs
+    // every operand form of a node (memoized per statement in tileCosts),
+    // the generate functions emit the cheapest cover
+    std::unordered_map<const Expression *, TileCosts> tileCosts;
+    TileCosts labelTiles(const Expression *expr);
+    TileCosts computeTileCosts(const Expression *expr);
+    int getOperandCost(const Expression *expr, bool allowImmediate);
+    bool swapsOperands(const BinaryExpression *binExpr);
+    static bool isCommutativeOperator(TokenType operation);
+    static const Expression *skipTransparentNodes(const Expression *expr);
+    SelectedOperand selectOperand(const Expression *expr, bool allowImmediate);
+    SelectedOperand generateMemoryOperand(const Expression *expr);
+    int takeResultRegister(const SelectedOperand &lhs,
+                           const SelectedOperand &rhs);
+    void releaseOperand(const SelectedOperand &operand);
+    static AlphaOperator getArithmeticOperator(TokenType operation);
+    // Emits `destination := value` as one instruction where the value's
+    // tiles allow it; false if the value is not a register expression
+    bool generateSelectedStore(Operand destination,
+                               const Expression *value,
+                               const std::string &comment);
+    int getArrayElementSize(const ArrayAccess *arrayAccess);
+    std::string getArrayElementLayout(const ArrayAccess *arrayAccess);
+    bool pointsToLayout(const Expression *expr);
+    std::optional<int> getStaticMemberAddress(const MemberAccess *memberAccess,
+                                              std::string &memberLayout);
+    Operand variableOperand(const std::string &varFQDN);
+
     // Statement generation
     void generateStatement(const Statement *stmt);
     void generateVariableDeclaration(const VariableDeclaration *varDecl);
@@ -273,25 +598,63 @@ class CodeGenerator {
     void
     generateNamespaceDeclaration(const NamespaceDeclaration *namespaceDecl);
 
+    // Dead function elimination
+    [[nodiscard]] std::unordered_set<std::string>
+    findReachableFunctions(const std::string &entryLabel) const;
+    // Code of the functions in output order, reachable ones only
+    [[nodiscard]] std::vector<Instruction>
+    linkFunctions(const std::unordered_set<std::string> &reachable) const;
+
+    // Static frame overlay
+    void computeFrameLayouts(int globalHighestAddress);
+    int allocateStaticData(int size);
+    void generateFrameSave(const FrameLayout &frame);
+    void generateFrameRestore(const FrameLayout &frame);
+
+    // Slot sharing: returns the number of cells needed and fills
+    // variableSlots with cell indices relative to the first of them
+    int assignVariableSlots(const FunctionDeclaration *funcDecl);
+    int allocateVariable(const ASTNode *declaration, const std::string &fqdn);
+
     // Type and layout management
     void setupLayoutMembers(
         const std::string &layoutName,
         const std::vector<std::unique_ptr<LayoutMember>> &members);
     int calculateLayoutSize(const std::string &layoutName);
+    int layoutHeaderCells() const;
+
+    // Constant folding: value of an expression built only from literals,
+    // and the operand left over when a binary node is an identity (x + 0,
+    // x * 1, ...)
+    static std::optional<int64_t> tryFoldConstant(const Expression *expr);
+    static const Expression *getIdentityOperand(const BinaryExpression *binExpr);
 
     // Utility methods
-    static std::string getOperatorInstruction(TokenType operation);
+    static AlphaOperator getOperatorInstruction(TokenType operation);
     static bool isComparisonOperator(TokenType operation);
     void generateComparison(TokenType operation, const std::string &trueLabel,
                             const std::string &falseLabel);
     void generateComparisonResult(TokenType operation);
 
+    // Condition lowering: jumps to `target` when the condition evaluates to
+    // `jumpWhen` and falls through otherwise, without materializing 0/1
+    static AlphaOperator getComparisonOperator(TokenType operation);
+    static TokenType invertComparison(TokenType operation);
+    static TokenType swapComparison(TokenType operation);
+    void generateConditionalJump(const Expression *condition,
+                                 const std::string &target, bool jumpWhen);
+
     // Utility to get layout name from AST type (handles pointers)
     std::string extractLayoutName(const Type *astType) const;
 
   public:
-    explicit CodeGenerator(SemanticAnalyzer *analyzer)
-        : semanticAnalyzer(analyzer) {
+    explicit CodeGenerator(SemanticAnalyzer *analyzer,
+                           CodeGenOptions options = {})
+        : options(std::move(options)), semanticAnalyzer(analyzer) {
+        if (this->options.registerCalls) {
+            this->options.peephole.argumentRegisters = argumentRegisterCount;
+            this->options.peephole.returnValueInRegister = true;
+        }
     }
 
     std::string generate(const Program *program);
@@ -0,0 +1,253 @@
+#ifndef INSTRUCTION_HPP
+#define INSTRUCTION_HPP
+
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace calpha {
+
+// Structured form of a single Alpha_TUI instruction. The code generator
+// lowers the AST into this form and encodes it as Alpha_TUI text once at the
+// end; the virtual machine and the peephole optimizer decode text into it.
+
+enum class OperandKind {
+    NONE,
+    REGISTER,        // aN (a is an alias for a0)
+    IMMEDIATE,       // integer constant
+    MEMORY,          // p(N)
+    MEMORY_INDIRECT  // p(aN)
+};
+
+struct Operand {
+    OperandKind kind{OperandKind::NONE};
+    int64_t value{0}; // Register index, constant or memory address
+
+    static Operand reg(int index) {
+        return {OperandKind::REGISTER, index};
+    }
+    static Operand imm(int64_t constant) {
+        return {OperandKind::IMMEDIATE, constant};
+    }
+    static Operand mem(int64_t address) {
+        return {OperandKind::MEMORY, address};
+    }
+    static Operand indirect(int registerIndex) {
+        return {OperandKind::MEMORY_INDIRECT, registerIndex};
+    }
+
+    [[nodiscard]] bool isNone() const {
+        return kind == OperandKind::NONE;
+    }
+    [[nodiscard]] bool isRegister(int index = -1) const {
+        return kind == OperandKind::REGISTER && (index < 0 || value == index);
+    }
+    [[nodiscard]] bool isImmediate() const {
+        return kind == OperandKind::IMMEDIATE;
+    }
+    [[nodiscard]] bool isMemory() const {
+        return kind == OperandKind::MEMORY ||
+               kind == OperandKind::MEMORY_INDIRECT;
+    }
+
+    [[nodiscard]] std::string toString() const;
+
+    bool operator==(const Operand &other) const = default;
+};
+
+enum class AlphaOperator {
+    NONE,
+    // Arithmetic and bitwise
+    ADD,
+    SUB,
+    MUL,
+    DIV,
+    MOD,
+    AND,
+    OR,
+    XOR,
+    NOT, // unary ~
+    // Comparison (only valid in conditional jumps)
+    EQ,
+    NE,
+    LT,
+    LE,
+    GT,
+    GE
+};
+
+enum class InstructionKind {
+    BLANK,     // Empty line (kept so formatting survives round trips)
+    COMMENT,   // Comment-only line
+    LABEL,     // name:
+    ASSIGN,    // dst := lhs
+    BINARY,    // dst := lhs op rhs
+    UNARY,     // dst := op lhs
+    PUSH,      // push [lhs]        (defaults to a0)
+    POP,       // pop [dst]         (defaults to a0)
+    STACK_OP,  // stack+ stack- stack* stack/ stack%
+    CALL,      // call label
+    RETURN,    // return
+    GOTO,      // goto label
+    IF_GOTO,   // if lhs op rhs then goto label
+    SYSCALL,   // syscall
+    NOP        // nop
+};
+
+struct Instruction {
+    InstructionKind kind{InstructionKind::BLANK};
+    AlphaOperator op{AlphaOperator::NONE};
+    Operand dst;
+    Operand lhs;
+    Operand rhs;
+    std::string label;   // Label name, call or jump target
+    std::string comment; // Trailing comment without the leading "//"
+
+    static Instruction makeLabel(std::string name) {
+        Instruction instr;
+        instr.kind = InstructionKind::LABEL;
+        instr.label = std::move(name);
+        return instr;
+    }
+    static Instruction makeComment(std::string text) {
+        Instruction instr;
+        instr.kind = InstructionKind::COMMENT;
+        instr.comment = std::move(text);
+        return instr;
+    }
+    static Instruction makeAssign(Operand dst, Operand src) {
+        Instruction instr;
+        instr.kind = InstructionKind::ASSIGN;
+        instr.dst = dst;
+        instr.lhs = src;
+        return instr;
+    }
+    static Instruction makeBinary(Operand dst, Operand lhs, AlphaOperator op,
+                                  Operand rhs) {
+        Instruction instr;
+        instr.kind = InstructionKind::BINARY;
+        instr.dst = dst;
+        instr.lhs = lhs;
+        instr.op = op;
+        instr.rhs = rhs;
+        return instr;
+    }
+    static Instruction makeUnary(Operand dst, AlphaOperator op, Operand src) {
+        Instruction instr;
+        instr.kind = InstructionKind::UNARY;
+        instr.dst = dst;
+        instr.op = op;
+        instr.lhs = src;
+        return instr;
+    }
+    static Instruction makePush(Operand src = Operand::reg(0)) {
+        Instruction instr;
+        instr.kind = InstructionKind::PUSH;
+        instr.lhs = src;
+        return instr;
+    }
+    static Instruction makePop(Operand dst = Operand::reg(0)) {
+        Instruction instr;
+        instr.kind = InstructionKind::POP;
+        instr.dst = dst;
+        return instr;
+    }
+    static Instruction makeStackOperation(AlphaOperator op) {
+        Instruction instr;
+        instr.kind = InstructionKind::STACK_OP;
+        instr.op = op;
+        return instr;
+    }
+    // RETURN, SYSCALL or NOP
+    static Instruction make(InstructionKind kind) {
+        Instruction instr;
+        instr.kind = kind;
+        return instr;
+    }
+    static Instruction makeJump(InstructionKind kind, std::string target) {
+        Instruction instr;
+        instr.kind = kind;
+        instr.label = std::move(target);
+        return instr;
+    }
+    static Instruction makeConditionalJump(Operand lhs, AlphaOperator op,
+                                           Operand rhs, std::string target) {
+        Instruction instr;
+        instr.kind = InstructionKind::IF_GOTO;
+        instr.lhs = lhs;
+        instr.op = op;
+        instr.rhs = rhs;
+        instr.label = std::move(target);
+        return instr;
+    }
+
+    // Lines that carry no semantics at all (blank lines and comments)
+    [[nodiscard]] bool isTrivia() const {
+        return kind == InstructionKind::BLANK ||
+               kind == InstructionKind::COMMENT;
+    }
+    [[nodiscard]] bool isJump() const {
+        return kind == InstructionKind::GOTO ||
+               kind == InstructionKind::IF_GOTO;
+    }
+    // Instructions after which control never falls through
+    [[nodiscard]] bool endsBlock() const {
+        return kind == InstructionKind::GOTO ||
+               kind == InstructionKind::RETURN;
+    }
+
+    // Register effects of the instruction itself. Calls and returns are
+    // not modelled here; their effect depends on the calling convention.
+    [[nodiscard]] bool readsRegister(int reg) const;
+    [[nodiscard]] bool writesRegister(int reg) const;
+
+    // Renders the instruction (and its comment) as one line of Alpha_TUI
+    [[nodiscard]] std::string toString() const;
+};
+
+class AlphaSyntaxError final : public std::exception {
+  private:
+    std::string message;
+
+  public:
+    AlphaSyntaxError(const std::string &msg, int line)
+        : message("line " + std::to_string(line) + ": " + msg) {
+    }
+
+    [[nodiscard]] const char *what() const noexcept override {
+        return message.c_str();
+    }
+};
+
+// Operator helpers shared by the decoder, the VM and the optimizers
+[[nodiscard]] std::string alphaOperatorToString(AlphaOperator op);
+[[nodiscard]] bool isAlphaComparison(AlphaOperator op);
+// a op b  <=>  !(a inverted b)
+[[nodiscard]] AlphaOperator invertAlphaComparison(AlphaOperator op);
+// a op b  <=>  b swapped a
+[[nodiscard]] AlphaOperator swapAlphaComparison(AlphaOperator op);
+
+// Value of `lhs op rhs` as the virtual machine computes it (64-bit two's
+// complement); nullopt for a division by zero, which faults at run time, and
+// for operators that are not binary arithmetic
+[[nodiscard]] std::optional<int64_t>
+foldAlphaOperation(AlphaOperator op, int64_t lhs, int64_t rhs);
+[[nodiscard]] bool foldAlphaComparison(AlphaOperator op, int64_t lhs,
+                                       int64_t rhs);
+
+// Decodes one line of Alpha_TUI; throws AlphaSyntaxError on malformed input
+[[nodiscard]] Instruction decodeInstruction(const std::string &line,
+                                            int lineNumber = 0);
+// Decodes a whole program, one instruction per source line
+[[nodiscard]] std::vector<Instruction>
+decodeAlphaProgram(const std::string &source);
+// Renders a decoded program back into Alpha_TUI text
+[[nodiscard]] std::string
+encodeAlphaProgram(const std::vector<Instruction> &program);
+
+} // namespace calpha
+
+#endif // INSTRUCTION_HPP
@@ -0,0 +1,40 @@
+#ifndef IR_PASSES_HPP
+#define IR_PASSES_HPP
+
+#include "cfg.hpp"
+
+namespace calpha {
+
+// Passes of IrPassManager::createDefaultPasses(). Each returns true if it
+// changed the graph.
+
+// Sparse conditional constant propagation over the SSA form: registers
+// and direct cells with a known constant value become immediates, branches
+// with a constant condition become jumps or disappear, and blocks no
+// executable edge reaches are removed
+bool propagateConstants(ControlFlowGraph &cfg);
+
+// Reuses values registers already hold: recomputed expressions and member
+// addresses become copies, and loads no store in between may have changed
+// read the register instead
+bool eliminateCommonSubexpressions(ControlFlowGraph &cfg);
+
+// Moves register computations whose operands do not change inside a loop
+// into a preheader that runs once before the loop
+bool hoistLoopInvariants(ControlFlowGraph &cfg);
+
+// Replaces base + i and i * c, where the memory cell i is stepped by a
+// constant once per iteration, by a register that is stepped alongside i
+bool reduceInductionStrength(ControlFlowGraph &cfg);
+
+// Removes the blocks the program entry global::main can not reach, such as
+// code after a return and functions no reachable code calls
+bool removeUnreachableBlocks(ControlFlowGraph &cfg);
+
+// Removes computations into registers and direct cells that nothing reads
+// before they are overwritten or the program ends
+bool eliminateDeadStores(ControlFlowGraph &cfg);
+
+} // namespace calpha
+
+#endif // IR_PASSES_HPP
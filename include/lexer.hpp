@@ -40,6 +40,8 @@ enum class TokenType {
     BITWISE_OR,  // |
     BITWISE_XOR, // ^
     BITWISE_NOT, // ~
+    LOGICAL_AND, // &&
+    LOGICAL_OR,  // ||
     ASSIGN,      // =
 
     // Pointer operators
@@ -211,8 +211,14 @@ class BinaryExpression : public Expression {
         case TokenType::GREATER_EQUAL:
             return ">=";
         case TokenType::BITWISE_AND:
-            return "&&";
+            return "&";
         case TokenType::BITWISE_OR:
+            return "|";
+        case TokenType::BITWISE_XOR:
+            return "^";
+        case TokenType::LOGICAL_AND:
+            return "&&";
+        case TokenType::LOGICAL_OR:
             return "||";
         default:
             return "?";
@@ -0,0 +1,92 @@
+#ifndef PEEPHOLE_HPP
+#define PEEPHOLE_HPP
+
+#include "instruction.hpp"
+#include <functional>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace calpha {
+
+struct PeepholeOptions {
+    bool enabled{true};
+    // Upper bound for optimize() sweeps; each sweep runs every rule once
+    int maxPasses{16};
+    // Names of rules from PeepholeOptimizer::getRuleNames() to skip
+    std::unordered_set<std::string> disabledRules;
+
+    // Calling convention facts used by the register liveness queries.
+    // Registers a1..a<argumentRegisters> are read by "call"; a0 is read by
+    // "return" when returnValueInRegister is set.
+    int argumentRegisters{0};
+    bool returnValueInRegister{false};
+};
+
+class PeepholeOptimizer;
+
+// What a rule sees besides its window: the whole program and liveness
+// queries on it
+class PeepholeContext {
+  private:
+    const std::vector<Instruction> &program;
+    const PeepholeOptions &options;
+    std::unordered_map<std::string, size_t> labelIndex;
+    std::unordered_map<std::string, int> labelReferences;
+
+  public:
+    PeepholeContext(const std::vector<Instruction> &program,
+                    const PeepholeOptions &options);
+
+    // True if every path starting at instruction `from` overwrites register
+    // `reg` before reading it. Answers false when unsure.
+    [[nodiscard]] bool isRegisterDead(size_t from, int reg) const;
+    // The same for the paths starting at `label`
+    [[nodiscard]] bool isRegisterDeadAt(const std::string &label,
+                                        int reg) const;
+    // Labels that directly follow instruction `index` (ignoring trivia)
+    [[nodiscard]] std::vector<std::string> labelsAfter(size_t index) const;
+    [[nodiscard]] bool isLabelReferenced(const std::string &label) const;
+};
+
+// A rewrite over a window of consecutive significant (non-trivia)
+// instructions. On a match the rule fills `replacement`, which takes the
+// place of the whole window.
+struct PeepholeRule {
+    std::string name;
+    size_t windowSize;
+    std::function<bool(const PeepholeContext &context,
+                       const std::vector<const Instruction *> &window,
+                       size_t windowEnd, std::vector<Instruction> &replacement)>
+        rewrite;
+};
+
+// Window-based peephole optimizer over decoded Alpha_TUI programs.
+// Rules are tried in table order at every position until a sweep makes no
+// change (or maxPasses is reached).
+class PeepholeOptimizer {
+  private:
+    PeepholeOptions options;
+    std::vector<PeepholeRule> rules;
+    std::map<std::string, int> statistics; // rule name -> applications
+
+    static std::vector<PeepholeRule> createDefaultRules();
+    bool runPass(std::vector<Instruction> &program);
+
+  public:
+    explicit PeepholeOptimizer(PeepholeOptions options = {});
+
+    void optimize(std::vector<Instruction> &program);
+    [[nodiscard]] std::string optimize(const std::string &alphaCode);
+
+    [[nodiscard]] std::vector<std::string> getRuleNames() const;
+    [[nodiscard]] const std::map<std::string, int> &getStatistics() const {
+        return statistics;
+    }
+};
+
+} // namespace calpha
+
+#endif // PEEPHOLE_HPP
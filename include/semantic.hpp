@@ -2,6 +2,8 @@
 #define SEMANTIC_HPP
 
 #include "parser.hpp"
+#include <algorithm>
+#include <iterator>
 #include <memory>
 #include <stack>
 #include <unordered_map>
@@ -417,6 +419,22 @@ class SymbolTable {
         }
     }
 
+    // Takes the scopes above the global one off the stack, so that lookups
+    // see only scopes pushed afterwards and the globals
+    std::vector<std::unique_ptr<Scope>> hideLocalScopes() {
+        std::vector<std::unique_ptr<Scope>> hidden;
+        if (scopes.size() > 1) {
+            hidden.assign(std::make_move_iterator(scopes.begin() + 1),
+                          std::make_move_iterator(scopes.end()));
+            scopes.resize(1);
+        }
+        return hidden;
+    }
+
+    void restoreLocalScopes(std::vector<std::unique_ptr<Scope>> hidden) {
+        std::ranges::move(hidden, std::back_inserter(scopes));
+    }
+
     void addSymbol(std::unique_ptr<Symbol> symbol) {
         if (!scopes.empty()) {
             symbol->fqdn = buildFQDN(symbol->name);
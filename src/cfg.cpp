@@ -0,0 +1,680 @@
+#include "cfg.hpp"
+#include "ir_passes.hpp"
+#include <algorithm>
+#include <ranges>
+#include <utility>
+
+namespace calpha {
+
+// ============================================================================
+// BasicBlock Implementation
+// ============================================================================
+
+std::vector<std::string> BasicBlock::labels() const {
+    std::vector<std::string> names;
+    for (const auto &instr : instructions) {
+        if (instr.isTrivia())
+            continue;
+        if (instr.kind != InstructionKind::LABEL)
+            break;
+        names.push_back(instr.label);
+    }
+    return names;
+}
+
+const Instruction *BasicBlock::terminator() const {
+    for (const auto &instr : std::ranges::reverse_view(instructions)) {
+        if (instr.isTrivia())
+            continue;
+        return instr.kind == InstructionKind::LABEL ? nullptr : &instr;
+    }
+    return nullptr;
+}
+
+bool BasicBlock::fallsThrough() const {
+    const Instruction *last = terminator();
+    return last == nullptr || !last->endsBlock();
+}
+
+// ============================================================================
+// ControlFlowGraph Implementation
+// ============================================================================
+
+ControlFlowGraph::ControlFlowGraph(const std::vector<Instruction> &program) {
+    // A block starts at the first label after code and right after every
+    // jump or return
+    bool hasCode = false;
+    bool afterBranch = false;
+    blocks.emplace_back();
+    for (const auto &instr : program) {
+        const bool startsBlock =
+            afterBranch ||
+            (instr.kind == InstructionKind::LABEL && hasCode);
+        if (startsBlock) {
+            blocks.emplace_back();
+            hasCode = false;
+            afterBranch = false;
+        }
+        blocks.back().instructions.push_back(instr);
+        if (!instr.isTrivia() && instr.kind != InstructionKind::LABEL)
+            hasCode = true;
+        if (instr.isJump() || instr.kind == InstructionKind::RETURN)
+            afterBranch = true;
+    }
+    rebuildEdges();
+}
+
+void ControlFlowGraph::rebuildEdges() {
+    labelBlocks.clear();
+    callTargets.clear();
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        blocks[i].successors.clear();
+        blocks[i].predecessors.clear();
+        for (const auto &instr : blocks[i].instructions) {
+            if (instr.kind == InstructionKind::LABEL)
+                labelBlocks[instr.label] = i;
+            else if (instr.kind == InstructionKind::CALL)
+                callTargets.insert(instr.label);
+        }
+    }
+
+    auto addEdge = [&](size_t from, size_t to) {
+        auto &successors = blocks[from].successors;
+        if (std::ranges::find(successors, to) != successors.end())
+            return;
+        successors.push_back(to);
+        blocks[to].predecessors.push_back(from);
+    };
+
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        const Instruction *last = blocks[i].terminator();
+        if (last != nullptr && last->isJump()) {
+            if (auto target = findBlock(last->label))
+                addEdge(i, *target);
+        }
+        if (blocks[i].fallsThrough() && i + 1 < blocks.size())
+            addEdge(i, i + 1);
+    }
+}
+
+std::optional<size_t>
+ControlFlowGraph::findBlock(const std::string &label) const {
+    auto it = labelBlocks.find(label);
+    if (it == labelBlocks.end())
+        return std::nullopt;
+    return it->second;
+}
+
+bool ControlFlowGraph::isCallTarget(size_t block) const {
+    return std::ranges::any_of(blocks[block].labels(),
+                               [&](const std::string &label) {
+                                   return callTargets.contains(label);
+                               });
+}
+
+bool ControlFlowGraph::isEntry(size_t block) const {
+    if (block == 0 || blocks[block].predecessors.empty() || isCallTarget(block))
+        return true;
+    const auto names = blocks[block].labels();
+    return std::ranges::find(names, "global::main") != names.end();
+}
+
+std::vector<bool>
+ControlFlowGraph::reachableFrom(const std::string &entry) const {
+    std::vector<bool> reachable(blocks.size(), false);
+    std::vector<size_t> worklist;
+    auto visit = [&](const std::string &label) {
+        if (auto block = findBlock(label); block && !reachable[*block]) {
+            reachable[*block] = true;
+            worklist.push_back(*block);
+        }
+    };
+
+    visit(entry);
+    while (!worklist.empty()) {
+        size_t index = worklist.back();
+        worklist.pop_back();
+        for (const auto &instr : blocks[index].instructions) {
+            if (instr.kind == InstructionKind::CALL)
+                visit(instr.label);
+        }
+        for (size_t successor : blocks[index].successors) {
+            if (!reachable[successor]) {
+                reachable[successor] = true;
+                worklist.push_back(successor);
+            }
+        }
+    }
+    return reachable;
+}
+
+std::vector<Instruction> ControlFlowGraph::flatten() const {
+    std::vector<Instruction> program;
+    for (const auto &block : blocks) {
+        program.insert(program.end(), block.instructions.begin(),
+                       block.instructions.end());
+    }
+    return program;
+}
+
+// ============================================================================
+// Analyses
+// ============================================================================
+
+RegisterSet registersRead(const Instruction &instr,
+                          const CallingConvention &convention) {
+    RegisterSet set = 0;
+    if (instr.kind == InstructionKind::CALL) {
+        for (int reg = 1; reg <= convention.argumentRegisters; ++reg) {
+            set |= registerBit(reg);
+        }
+        return set;
+    }
+    if (instr.kind == InstructionKind::RETURN)
+        return convention.returnValueInRegister ? registerBit(0) : 0;
+    for (int reg = 0; reg < 8; ++reg) {
+        if (instr.readsRegister(reg))
+            set |= registerBit(reg);
+    }
+    return set;
+}
+
+RegisterSet registersWritten(const Instruction &instr) {
+    RegisterSet set = 0;
+    for (int reg = 0; reg < 8; ++reg) {
+        if (instr.writesRegister(reg))
+            set |= registerBit(reg);
+    }
+    return set;
+}
+
+RegisterLiveness computeRegisterLiveness(const ControlFlowGraph &cfg) {
+    const auto &blocks = cfg.getBlocks();
+    RegisterLiveness liveness{std::vector<RegisterSet>(blocks.size(), 0),
+                              std::vector<RegisterSet>(blocks.size(), 0)};
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = blocks.size(); i-- > 0;) {
+            RegisterSet live = 0;
+            for (size_t successor : blocks[i].successors) {
+                live |= liveness.liveIn[successor];
+            }
+            liveness.liveOut[i] = live;
+            for (const auto &instr :
+                 std::ranges::reverse_view(blocks[i].instructions)) {
+                live = static_cast<RegisterSet>(
+                    (live & ~registersWritten(instr)) |
+                    registersRead(instr, cfg.getCallingConvention()));
+            }
+            if (live != liveness.liveIn[i]) {
+                liveness.liveIn[i] = live;
+                changed = true;
+            }
+        }
+    }
+    return liveness;
+}
+
+std::vector<std::vector<bool>>
+computeDominators(const ControlFlowGraph &cfg) {
+    const auto &blocks = cfg.getBlocks();
+    const size_t count = blocks.size();
+    std::vector<std::vector<bool>> dominators(count);
+    for (size_t i = 0; i < count; ++i) {
+        if (cfg.isEntry(i)) {
+            dominators[i].assign(count, false);
+            dominators[i][i] = true;
+        } else {
+            dominators[i].assign(count, true);
+        }
+    }
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = 0; i < count; ++i) {
+            if (cfg.isEntry(i))
+                continue;
+            std::vector<bool> meet(count, true);
+            for (size_t predecessor : blocks[i].predecessors) {
+                for (size_t d = 0; d < count; ++d) {
+                    meet[d] = meet[d] && dominators[predecessor][d];
+                }
+            }
+            meet[i] = true;
+            if (meet != dominators[i]) {
+                dominators[i] = std::move(meet);
+                changed = true;
+            }
+        }
+    }
+    return dominators;
+}
+
+std::vector<Loop> findLoops(const ControlFlowGraph &cfg,
+                            const std::vector<std::vector<bool>> &dominators) {
+    const auto &blocks = cfg.getBlocks();
+    std::map<size_t, Loop> loopsByHeader;
+    for (size_t latch = 0; latch < blocks.size(); ++latch) {
+        for (size_t header : blocks[latch].successors) {
+            if (!dominators[latch][header])
+                continue;
+            Loop &loop = loopsByHeader[header];
+            loop.header = header;
+            loop.members.insert(header);
+            // Walk backwards from the latch up to the header
+            std::vector<size_t> worklist{latch};
+            while (!worklist.empty()) {
+                size_t block = worklist.back();
+                worklist.pop_back();
+                if (!loop.members.insert(block).second)
+                    continue;
+                for (size_t predecessor : blocks[block].predecessors) {
+                    worklist.push_back(predecessor);
+                }
+            }
+        }
+    }
+
+    std::vector<Loop> loops;
+    for (auto &[header, loop] : loopsByHeader) {
+        loop.blocks.assign(loop.members.begin(), loop.members.end());
+        std::ranges::sort(loop.blocks);
+        loops.push_back(std::move(loop));
+    }
+    std::ranges::stable_sort(loops, {}, [](const Loop &loop) {
+        return loop.blocks.size();
+    });
+    return loops;
+}
+
+// ============================================================================
+// Static single assignment form
+// ============================================================================
+
+int SsaForm::variableOf(const Operand &operand) const {
+    if (operand.kind == OperandKind::REGISTER ||
+        operand.kind == OperandKind::MEMORY_INDIRECT)
+        return static_cast<int>(operand.value);
+    if (operand.kind == OperandKind::MEMORY) {
+        auto it = cellVariables.find(operand.value);
+        if (it != cellVariables.end())
+            return it->second;
+    }
+    return -1;
+}
+
+SsaForm::Name SsaForm::nameUsed(size_t block, size_t index,
+                                int variable) const {
+    for (const auto &use : instructions[block][index].uses) {
+        if (use.variable == variable)
+            return use.name;
+    }
+    return kUndefined;
+}
+
+namespace {
+
+class SsaBuilder {
+  private:
+    const ControlFlowGraph &cfg;
+    const std::vector<BasicBlock> &blocks;
+    SsaForm &ssa;
+    int variableCount{SsaForm::kRegisterVariables};
+    std::map<std::string, std::vector<int>> calleeStores;
+    std::vector<size_t> idom;
+    std::vector<std::vector<size_t>> children;
+    std::vector<std::vector<SsaForm::Name>> stacks; // Per variable
+
+    SsaForm::Name define(SsaForm::DefinitionKind kind, int variable,
+                         size_t block, size_t index) {
+        ssa.definitions.push_back({kind, variable, block, index});
+        return ssa.definitions.size() - 1;
+    }
+
+    // Direct cells the code reachable from a call target stores
+    const std::vector<int> &storedByCall(const std::string &target) {
+        auto [it, inserted] = calleeStores.try_emplace(target);
+        if (!inserted)
+            return it->second;
+        std::vector<int> stored;
+        const auto reached = cfg.reachableFrom(target);
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            if (!reached[i])
+                continue;
+            for (const auto &instr : blocks[i].instructions) {
+                const int variable = instr.dst.kind == OperandKind::MEMORY
+                                         ? ssa.variableOf(instr.dst)
+                                         : -1;
+                if (variable >= 0 &&
+                    std::ranges::find(stored, variable) == stored.end())
+                    stored.push_back(variable);
+            }
+        }
+        it->second = std::move(stored);
+        return it->second;
+    }
+
+    std::vector<int> usedVariables(const Instruction &instr) const {
+        std::vector<int> used;
+        const RegisterSet read =
+            registersRead(instr, cfg.getCallingConvention());
+        for (int reg = 0; reg < SsaForm::kRegisterVariables; ++reg) {
+            if ((read & registerBit(reg)) != 0)
+                used.push_back(reg);
+        }
+        for (const Operand *operand : {&instr.lhs, &instr.rhs}) {
+            const int variable = operand->kind == OperandKind::MEMORY
+                                     ? ssa.variableOf(*operand)
+                                     : -1;
+            if (variable >= 0 &&
+                std::ranges::find(used, variable) == used.end())
+                used.push_back(variable);
+        }
+        return used;
+    }
+
+    std::vector<int> definedVariables(const Instruction &instr) {
+        std::vector<int> defined;
+        if (instr.kind == InstructionKind::CALL) {
+            for (int reg = 0; reg < SsaForm::kRegisterVariables; ++reg) {
+                defined.push_back(reg);
+            }
+            const auto &stored = storedByCall(instr.label);
+            defined.insert(defined.end(), stored.begin(), stored.end());
+            return defined;
+        }
+        const RegisterSet written = registersWritten(instr);
+        for (int reg = 0; reg < SsaForm::kRegisterVariables; ++reg) {
+            if ((written & registerBit(reg)) != 0)
+                defined.push_back(reg);
+        }
+        if (instr.dst.kind == OperandKind::MEMORY) {
+            const int variable = ssa.variableOf(instr.dst);
+            if (variable >= 0)
+                defined.push_back(variable);
+        }
+        return defined;
+    }
+
+    void collectCells() {
+        for (const auto &block : blocks) {
+            for (const auto &instr : block.instructions) {
+                for (const Operand *operand :
+                     {&instr.dst, &instr.lhs, &instr.rhs}) {
+                    if (operand->kind == OperandKind::MEMORY &&
+                        cfg.isDirectCell(operand->value) &&
+                        !ssa.cellVariables.contains(operand->value))
+                        ssa.cellVariables[operand->value] = variableCount++;
+                }
+            }
+        }
+    }
+
+    void markReachable() {
+        ssa.reachable.assign(blocks.size(), false);
+        std::vector<size_t> worklist;
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            if (cfg.isEntry(i)) {
+                ssa.reachable[i] = true;
+                worklist.push_back(i);
+            }
+        }
+        while (!worklist.empty()) {
+            const size_t block = worklist.back();
+            worklist.pop_back();
+            for (size_t successor : blocks[block].successors) {
+                if (!ssa.reachable[successor]) {
+                    ssa.reachable[successor] = true;
+                    worklist.push_back(successor);
+                }
+            }
+        }
+    }
+
+    // The immediate dominator is the strict dominator with the most
+    // dominators of its own. Entries and blocks reached from more than one
+    // entry have none (kOutside) and root their own trees.
+    void buildDominatorTree() {
+        const auto dominators = computeDominators(cfg);
+        const size_t count = blocks.size();
+        std::vector<size_t> depth(count, 0);
+        for (size_t i = 0; i < count; ++i) {
+            depth[i] = static_cast<size_t>(std::ranges::count(dominators[i],
+                                                              true));
+        }
+        idom.assign(count, SsaForm::kOutside);
+        children.assign(count, {});
+        for (size_t i = 0; i < count; ++i) {
+            if (!ssa.reachable[i] || cfg.isEntry(i))
+                continue;
+            for (size_t d = 0; d < count; ++d) {
+                if (d != i && dominators[i][d] &&
+                    (idom[i] == SsaForm::kOutside || depth[d] > depth[idom[i]]))
+                    idom[i] = d;
+            }
+            if (idom[i] != SsaForm::kOutside)
+                children[idom[i]].push_back(i);
+        }
+    }
+
+    // Phis go into the iterated dominance frontier of every definition
+    void placePhis() {
+        const size_t count = blocks.size();
+        std::vector<std::vector<size_t>> frontier(count);
+        for (size_t i = 0; i < count; ++i) {
+            if (!ssa.reachable[i])
+                continue;
+            const size_t incoming = blocks[i].predecessors.size() +
+                                    (cfg.isEntry(i) ? 1 : 0);
+            if (incoming < 2)
+                continue;
+            for (size_t predecessor : blocks[i].predecessors) {
+                for (size_t runner = predecessor;
+                     runner != SsaForm::kOutside && runner != idom[i] &&
+                     ssa.reachable[runner];
+                     runner = idom[runner]) {
+                    auto &blocksOf = frontier[runner];
+                    if (std::ranges::find(blocksOf, i) == blocksOf.end())
+                        blocksOf.push_back(i);
+                }
+            }
+        }
+
+        std::vector<std::vector<size_t>> definingBlocks(variableCount);
+        for (size_t i = 0; i < count; ++i) {
+            if (!ssa.reachable[i])
+                continue;
+            for (const auto &instr : blocks[i].instructions) {
+                for (int variable : definedVariables(instr)) {
+                    auto &defining = definingBlocks[variable];
+                    if (defining.empty() || defining.back() != i)
+                        defining.push_back(i);
+                }
+            }
+        }
+
+        for (int variable = 0; variable < variableCount; ++variable) {
+            std::vector<bool> hasPhi(count, false);
+            std::vector<size_t> worklist = definingBlocks[variable];
+            while (!worklist.empty()) {
+                const size_t block = worklist.back();
+                worklist.pop_back();
+                for (size_t target : frontier[block]) {
+                    if (hasPhi[target])
+                        continue;
+                    hasPhi[target] = true;
+                    SsaForm::Phi phi{
+                        define(SsaForm::DefinitionKind::PHI, variable, target,
+                               ssa.phis[target].size()),
+                        variable,
+                        {}};
+                    for (size_t predecessor : blocks[target].predecessors) {
+                        phi.operands.emplace_back(predecessor,
+                                                  SsaForm::kUndefined);
+                    }
+                    if (cfg.isEntry(target))
+                        phi.operands.emplace_back(SsaForm::kOutside,
+                                                  SsaForm::kUndefined);
+                    ssa.phis[target].push_back(std::move(phi));
+                    worklist.push_back(target);
+                }
+            }
+        }
+    }
+
+    void rename(size_t block) {
+        std::vector<size_t> heights;
+        heights.reserve(stacks.size());
+        for (const auto &stack : stacks) {
+            heights.push_back(stack.size());
+        }
+
+        for (const auto &phi : ssa.phis[block]) {
+            stacks[phi.variable].push_back(phi.name);
+        }
+        const auto &code = blocks[block].instructions;
+        auto &names = ssa.instructions[block];
+        names.resize(code.size());
+        for (size_t i = 0; i < code.size(); ++i) {
+            for (int variable : usedVariables(code[i])) {
+                names[i].uses.push_back({variable, stacks[variable].back()});
+            }
+            for (int variable : definedVariables(code[i])) {
+                const SsaForm::Name name = define(
+                    SsaForm::DefinitionKind::INSTRUCTION, variable, block, i);
+                names[i].defs.push_back({variable, name});
+                stacks[variable].push_back(name);
+            }
+        }
+        for (size_t successor : blocks[block].successors) {
+            for (auto &phi : ssa.phis[successor]) {
+                for (auto &[predecessor, name] : phi.operands) {
+                    if (predecessor == block)
+                        name = stacks[phi.variable].back();
+                }
+            }
+        }
+        for (size_t child : children[block]) {
+            rename(child);
+        }
+
+        for (size_t variable = 0; variable < stacks.size(); ++variable) {
+            stacks[variable].resize(heights[variable]);
+        }
+    }
+
+  public:
+    SsaBuilder(const ControlFlowGraph &cfg, SsaForm &ssa)
+        : cfg(cfg), blocks(cfg.getBlocks()), ssa(ssa) {
+    }
+
+    void build() {
+        collectCells();
+        markReachable();
+        buildDominatorTree();
+        ssa.definitions.push_back(
+            {SsaForm::DefinitionKind::UNDEFINED, -1, 0, 0});
+        ssa.phis.assign(blocks.size(), {});
+        ssa.instructions.assign(blocks.size(), {});
+        placePhis();
+
+        // Every variable starts with the value it has on entry
+        stacks.resize(variableCount);
+        for (int variable = 0; variable < variableCount; ++variable) {
+            stacks[variable].push_back(
+                define(SsaForm::DefinitionKind::ENTRY, variable, 0, 0));
+        }
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            if (!ssa.reachable[i] || idom[i] != SsaForm::kOutside)
+                continue;
+            if (cfg.isEntry(i)) {
+                for (auto &phi : ssa.phis[i]) {
+                    phi.operands.back().second = stacks[phi.variable].front();
+                }
+            }
+            rename(i);
+        }
+    }
+};
+
+} // namespace
+
+SsaForm buildSsaForm(const ControlFlowGraph &cfg) {
+    SsaForm ssa;
+    SsaBuilder(cfg, ssa).build();
+    return ssa;
+}
+
+// ============================================================================
+// IrPassManager Implementation
+// ============================================================================
+
+std::vector<IrPass> IrPassManager::createDefaultPasses() {
+    return {
+        {"unreachable-code", removeUnreachableBlocks},
+        {"constant-propagation", propagateConstants},
+        {"common-subexpressions", eliminateCommonSubexpressions},
+        {"loop-invariant-code-motion", hoistLoopInvariants},
+        {"strength-reduction", reduceInductionStrength},
+        {"dead-stores", eliminateDeadStores},
+    };
+}
+
+IrPassManager::IrPassManager(IrOptions options)
+    : options(std::move(options)), passes(createDefaultPasses()) {
+}
+
+void IrPassManager::run(ControlFlowGraph &cfg) {
+    if (!options.enabled)
+        return;
+    for (const auto &pass : passes) {
+        if (options.disabledPasses.contains(pass.name))
+            continue;
+        if (pass.run(cfg)) {
+            statistics[pass.name]++;
+            cfg.rebuildEdges();
+        }
+    }
+}
+
+std::vector<std::string> IrPassManager::getPassNames() const {
+    std::vector<std::string> names;
+    for (const auto &pass : passes) {
+        names.push_back(pass.name);
+    }
+    return names;
+}
+
+// ============================================================================
+// Alpha_TUI Emission
+// ============================================================================
+
+std::string alphaLabelName(const std::string &qualified) {
+    std::string name = qualified;
+    size_t pos = 0;
+    while ((pos = name.find("global::", pos)) != std::string::npos) {
+        name.erase(pos, 8);
+    }
+    pos = 0;
+    while ((pos = name.find("::", pos)) != std::string::npos) {
+        name.replace(pos, 2, "_");
+        pos += 1;
+    }
+    return name;
+}
+
+std::vector<Instruction> emitAlphaProgram(const ControlFlowGraph &cfg) {
+    std::vector<Instruction> program = cfg.flatten();
+    for (auto &instr : program) {
+        if (!instr.label.empty())
+            instr.label = alphaLabelName(instr.label);
+        // Comments name functions and variables the same way
+        if (!instr.comment.empty())
+            instr.comment = alphaLabelName(instr.comment);
+    }
+    return program;
+}
+
+} // namespace calpha
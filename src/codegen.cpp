@@ -1,9 +1,21 @@
 #include <codegen.hpp>
+#include <functional>
 #include <iostream>
+#include <limits>
 #include <stdexcept>
 
 namespace calpha {
 
+namespace {
+
+// Registers the stack-based lowering works in
+const Operand a0 = Operand::reg(0);
+const Operand a1 = Operand::reg(1);
+const Operand a2 = Operand::reg(2);
+const Operand a3 = Operand::reg(3);
+
+} // namespace
+
 // ============================================================================
 // RegisterAllocator Implementation
 // ============================================================================
@@ -82,6 +94,10 @@ bool RegisterAllocator::hasAvailableRegister() const {
     return !availableRegisters.empty();
 }
 
+int RegisterAllocator::getAvailableRegisterCount() const {
+    return static_cast<int>(availableRegisters.size());
+}
+
 void RegisterAllocator::clearAll() {
     availableRegisters.clear();
     variableToRegister.clear();
@@ -110,7 +126,6 @@ void LabelGenerator::reset() {
 
 std::string CodeGenerator::generate(const Program *program) {
     output.clear();
-    output.str("");
 
     // Check for main function
     bool hasMainFunction = false;
@@ -143,62 +158,181 @@ std::string CodeGenerator::generate(const Program *program) {
         throw CodeGeneratorError("Entry Point fn int main() not found!");
     }
 
+    // Layout pass: generate once to learn every function's frame size and
+    // callees, then place the frames and generate again
+    frameLayouts.clear();
+    discardedFunctions.clear();
+    stringPool.clear();
+    if (options.poolStrings)
+        writtenStringLiterals = findWrittenStringLiterals(program);
+    if (options.overlayFrames) {
+        for (const auto &statement : program->statements) {
+            generateStatement(statement.get());
+        }
+        // Static data of functions main never reaches is not placed
+        std::unordered_set<std::string> reachable =
+            findReachableFunctions("global::main");
+        std::unordered_set<std::string> discarded;
+        std::set<std::string> literals = currentStringLiterals;
+        int staticDataCells = 0;
+        for (const auto &function : functionCodes) {
+            if (options.eliminateDeadFunctions &&
+                !reachable.contains(function.label)) {
+                discarded.insert(function.label);
+            } else {
+                staticDataCells += function.staticDataSize;
+                literals.insert(function.stringLiterals.begin(),
+                                function.stringLiterals.end());
+            }
+        }
+        // The string pool sits right above the globals
+        const int globalHighestAddress = memoryManager.getHighestMemoryAddress();
+        int poolEnd = globalHighestAddress + 1;
+        for (const auto &literal : literals) {
+            stringPool[literal] = poolEnd;
+            poolEnd += static_cast<int>(literal.size()) + 1;
+        }
+        computeFrameLayouts(poolEnd - 1 + staticDataCells);
+        reset();
+        staticDataBase = poolEnd;
+        discardedFunctions = std::move(discarded);
+    }
+
     emitComment("Generated by C-Alpha Compiler");
     emitComment("Target: Alpha_TUI Assembly");
-    emit("");
+    emitBlankLine();
 
     // Generate code for all statements
+    const auto globalStart = static_cast<std::ptrdiff_t>(output.size());
     for (const auto &statement : program->statements) {
         generateStatement(statement.get());
     }
+    const auto globalEnd = static_cast<std::ptrdiff_t>(output.size());
 
-    // Get the highest memory address used after all code generation
-    int highestAddress = memoryManager.getNextMemoryAddress() - 1;
+    // Keep the functions main can reach, together with the runtime routines
+    // and memory they need
+    std::unordered_set<std::string> reachable;
+    if (options.eliminateDeadFunctions) {
+        reachable = findReachableFunctions("global::main");
+    } else {
+        for (const auto &function : functionCodes) {
+            reachable.insert(function.label);
+        }
+    }
+    int maxAddress = std::max(memoryManager.getHighestMemoryAddress(),
+                              staticDataBase + staticDataSize - 1);
+    std::set<std::string> literals = currentStringLiterals;
+    for (const auto &function : functionCodes) {
+        if (!reachable.contains(function.label))
+            continue;
+        bitwiseRuntimeOperations.insert(function.bitwiseOperations.begin(),
+                                        function.bitwiseOperations.end());
+        literals.insert(function.stringLiterals.begin(),
+                        function.stringLiterals.end());
+        maxAddress = std::max(maxAddress, function.highestMemoryAddress);
+    }
+    for (const auto &literal : literals) {
+        maxAddress = std::max(maxAddress, stringPool.at(literal) +
+                                              static_cast<int>(literal.size()));
+    }
 
-    // Convert the output to a string
-    std::string generatedCode = output.str();
+    // Add program termination
+    emitBlankLine();
+    emitComment("Program termination");
+    emitJump("END");
+
+    // Runtime routines and their data live above all variables
+    std::vector<Instruction> prologue = generateStringPool(literals);
+    const int runtimeBase = maxAddress + 1;
+    if (!bitwiseRuntimeOperations.empty()) {
+        const int tableBase = runtimeBase;
+        generateBitwiseRuntime(tableBase);
+        std::ranges::move(generateBitwiseTables(tableBase),
+                          std::back_inserter(prologue));
+        maxAddress += 256 * static_cast<int>(bitwiseRuntimeOperations.size());
+    }
 
-    // find line that ONLY contains "main:"
-    size_t mainLabelPos = generatedCode.find("\nglobal::main:\n");
-    if (mainLabelPos == std::string::npos) {
+    // Execution starts at main, so the code of the global declarations
+    // (their initializers) runs in main's prologue instead of before it
+    prologue.insert(prologue.end(), output.begin() + globalStart,
+                    output.begin() + globalEnd);
+    Instruction highestAddress = Instruction::makeAssign(
+        Operand::mem(0), Operand::imm(maxAddress));
+    highestAddress.comment =
+        " Highest memory address used: " + std::to_string(maxAddress);
+    prologue.insert(prologue.begin(), highestAddress);
+
+    // Link the lowered code into one program. Labels keep their qualified
+    // names until emission.
+    std::vector<Instruction> code(output.begin(), output.begin() + globalStart);
+    std::ranges::move(linkFunctions(reachable), std::back_inserter(code));
+    code.insert(code.end(), output.begin() + globalEnd, output.end());
+    auto mainLabel = std::ranges::find_if(code, [](const Instruction &i) {
+        return i.kind == InstructionKind::LABEL && i.label == "global::main";
+    });
+    if (mainLabel == code.end()) {
         throw CodeGeneratorError(
             "Main function label not found in generated code");
     }
+    code.insert(mainLabel + 1, prologue.begin(), prologue.end());
+
+    // The peephole optimizer first folds the stack traffic of the
+    // generator into register code for the graph passes, then cleans up
+    // after them
+    PeepholeOptimizer peephole(options.peephole);
+    peephole.optimize(code);
+
+    ControlFlowGraph cfg(code);
+    cfg.setDirectCells(collectDirectCells(reachable, literals, runtimeBase));
+    cfg.setCallingConvention({options.peephole.argumentRegisters,
+                              options.peephole.returnValueInRegister});
+    IrPassManager passes(options.ir);
+    passes.run(cfg);
+    code = emitAlphaProgram(cfg);
+    if (!passes.getStatistics().empty())
+        peephole.optimize(code);
 
-    size_t maxAddress = memoryManager.getNextMemoryAddress() - 1;
-
-    generatedCode.insert(mainLabelPos + 15,
-                         "\n p(0) := " + std::to_string(maxAddress) +
-                             " // Highest memory address used: " +
-                             std::to_string(maxAddress) + "\n");
+    semanticAnalyzer->printSymbolTable();
 
-    generatedCode.replace(mainLabelPos, 15, "main:          ");
+    return encodeAlphaProgram(code);
+}
 
-    // Replace all global with ""
-    size_t pos = 0;
-    while ((pos = generatedCode.find("global::", pos)) != std::string::npos) {
-        generatedCode.replace(pos, 8, "");
-        pos += 1; // Move past the newly replaced character
+std::unordered_set<int64_t> CodeGenerator::collectDirectCells(
+    const std::unordered_set<std::string> &reachable,
+    const std::set<std::string> &literals, int runtimeBase) const {
+    // Functions that are not linked may have used cells the string pool
+    // or the runtime tables occupy now
+    std::unordered_set<int> scalars = scalarCells;
+    std::unordered_set<int> exposed = exposedCells;
+    for (const auto &function : functionCodes) {
+        if (!reachable.contains(function.label))
+            continue;
+        scalars.insert(function.scalarCells.begin(),
+                       function.scalarCells.end());
+        exposed.insert(function.exposedCells.begin(),
+                       function.exposedCells.end());
     }
-
-    // Replace all :: with __
-    pos = 0;
-    while ((pos = generatedCode.find("::", pos)) != std::string::npos) {
-        generatedCode.replace(pos, 2, "_");
-        pos += 1; // Move past the newly replaced character
+    for (const auto &literal : literals) {
+        const int start = stringPool.at(literal);
+        for (int cell = start;
+             cell <= start + static_cast<int>(literal.size()); ++cell) {
+            exposed.insert(cell);
+        }
     }
 
-    semanticAnalyzer->printSymbolTable();
-
-    // Add program termination
-    generatedCode += "\n// Program termination\ngoto END\n";
-
-    return generatedCode;
+    // A cell may hold a scalar in one scope or frame and an array or layout
+    // in another; it is direct only if no use exposes it
+    std::unordered_set<int64_t> cells;
+    for (int cell : scalars) {
+        if (cell < runtimeBase && !exposed.contains(cell) &&
+            !memoryManager.getArrayCells().contains(cell))
+            cells.insert(cell);
+    }
+    return cells;
 }
 
 void CodeGenerator::reset() {
     output.clear();
-    output.str("");
     registerAllocator.clearAll();
     memoryManager.clearAll();
     labelGenerator.reset();
@@ -209,21 +343,64 @@ void CodeGenerator::reset() {
     breakLabels.clear();
     continueLabels.clear();
     currentFunction.clear();
+    functionCodes.clear();
+    currentCallees.clear();
+    currentFunctionLabel.clear();
+    staticDataBase = 0;
+    staticDataSize = 0;
+    inlineCandidates.clear();
+    inlineReturnLabels.clear();
+    bitwiseRuntimeOperations.clear();
+    currentStringLiterals.clear();
+    layoutValueVariables.clear();
+    layoutSizes.clear();
+    scalarCells.clear();
+    exposedCells.clear();
+    tileCosts.clear();
     functionParameterCounts.clear();
     variableLayoutTypes.clear();
 }
 
 // Helper methods
-void CodeGenerator::emit(const std::string &instruction) {
-    output << instruction << '\n';
+void CodeGenerator::emit(Instruction instruction, const std::string &comment) {
+    if (!comment.empty())
+        instruction.comment = " " + comment;
+    output.push_back(std::move(instruction));
+}
+
+void CodeGenerator::emitAssign(Operand destination, Operand source,
+                               const std::string &comment) {
+    emit(Instruction::makeAssign(destination, source), comment);
+}
+
+void CodeGenerator::emitBinary(Operand destination, Operand lhs,
+                               AlphaOperator operation, Operand rhs,
+                               const std::string &comment) {
+    emit(Instruction::makeBinary(destination, lhs, operation, rhs), comment);
+}
+
+void CodeGenerator::emitJump(const std::string &target,
+                             const std::string &comment) {
+    emit(Instruction::makeJump(InstructionKind::GOTO, target), comment);
+}
+
+void CodeGenerator::emitConditionalJump(Operand lhs, AlphaOperator operation,
+                                        Operand rhs, const std::string &target,
+                                        const std::string &comment) {
+    emit(Instruction::makeConditionalJump(lhs, operation, rhs, target),
+         comment);
 }
 
 void CodeGenerator::emitComment(const std::string &comment) {
-    output << "// " << comment << '\n';
+    output.push_back(Instruction::makeComment(" " + comment));
 }
 
 void CodeGenerator::emitLabel(const std::string &label) {
-    output << label << ":" << '\n';
+    output.push_back(Instruction::makeLabel(label));
+}
+
+void CodeGenerator::emitBlankLine() {
+    output.emplace_back();
 }
 
 // ============================================================================
@@ -231,7 +408,7 @@ void CodeGenerator::emitLabel(const std::string &label) {
 // ============================================================================
 
 void CodeGenerator::pushToStack(const std::string &comment) {
-    emit("push" + (comment.empty() ? "" : " // " + comment));
+    emit(Instruction::makePush(), comment);
     stackDepth++;
     emitComment("DEBUG: Stack depth after push: " + std::to_string(stackDepth));
     if (!comment.empty()) {
@@ -247,7 +424,7 @@ void CodeGenerator::popFromStack(const std::string &comment) {
         // throw CodeGeneratorError("Stack underflow: trying to pop from empty
         // stack");
     }
-    emit("pop" + (comment.empty() ? "" : " // " + comment));
+    emit(Instruction::makePop(), comment);
     stackDepth--;
     emitComment("DEBUG: Stack depth after pop: " + std::to_string(stackDepth));
     if (!stackComments.empty()) {
@@ -255,20 +432,20 @@ void CodeGenerator::popFromStack(const std::string &comment) {
     }
 }
 
-void CodeGenerator::emitStackOperation(const std::string &operation,
+void CodeGenerator::emitStackOperation(AlphaOperator operation,
                                        const std::string &comment) {
     // Stack operations like stack+, stack-, stack*, stack/, stack% consume 2
     // values and push 1 result Net effect is -1 on stack depth
-    emit(operation + (comment.empty() ? "" : " // " + comment));
+    const Instruction instruction = Instruction::makeStackOperation(operation);
+    emit(instruction, comment);
     stackDepth--;
-    emitComment("DEBUG: Stack depth after " + operation + ": " +
+    emitComment("DEBUG: Stack depth after " + instruction.toString() + ": " +
                 std::to_string(stackDepth));
 }
 
 void CodeGenerator::pushRegisterToStack(int registerIndex,
                                         const std::string &comment) {
-    std::string regName = registerAllocator.getRegisterName(registerIndex);
-    emit("push " + regName + (comment.empty() ? "" : " // " + comment));
+    emit(Instruction::makePush(Operand::reg(registerIndex)), comment);
     stackDepth++;
     if (!comment.empty()) {
         stackComments.push(comment);
@@ -280,8 +457,7 @@ void CodeGenerator::popStackToRegister(int registerIndex,
     if (stackDepth <= 0) {
         throw CodeGeneratorError("Stack underflow: trying to pop to register");
     }
-    std::string regName = registerAllocator.getRegisterName(registerIndex);
-    emit("pop " + regName + (comment.empty() ? "" : " // " + comment));
+    emit(Instruction::makePop(Operand::reg(registerIndex)), comment);
     stackDepth--;
     if (!stackComments.empty()) {
         stackComments.pop();
@@ -370,21 +546,21 @@ std::string CodeGenerator::getVariableLayoutType(const std::string &varFQDN) {
 void CodeGenerator::loadFromMemory(int registerIndex,
                                    const std::string &varFQDN) {
     int address = memoryManager.getVariableAddress(varFQDN);
-    emit("a" + std::to_string(registerIndex) + " := p(" +
-         std::to_string(address) + ") // Load " + varFQDN);
+    emitAssign(Operand::reg(registerIndex), Operand::mem(address),
+               "Load " + varFQDN);
 }
 
 void CodeGenerator::storeToMemory(const std::string &varFQDN,
                                   int registerIndex) {
     int address = memoryManager.getVariableAddress(varFQDN);
-    emit("p(" + std::to_string(address) + ") := a" +
-         std::to_string(registerIndex) + " // Store " + varFQDN);
+    emitAssign(Operand::mem(address), Operand::reg(registerIndex),
+               "Store " + varFQDN);
 }
 
 void CodeGenerator::loadFromMemoryToStack(const std::string &varFQDN,
                                           const std::string &comment) {
     int address = memoryManager.getVariableAddress(varFQDN);
-    emit("a0 := p(" + std::to_string(address) + ") // Load " + varFQDN);
+    emitAssign(a0, Operand::mem(address), "Load " + varFQDN);
     pushToStack(comment.empty() ? "Load " + varFQDN : comment);
 }
 
@@ -392,7 +568,7 @@ void CodeGenerator::storeFromStackToMemory(const std::string &varFQDN,
                                            const std::string &comment) {
     int address = memoryManager.getVariableAddress(varFQDN);
     popFromStack(comment.empty() ? "Store " + varFQDN : comment);
-    emit("p(" + std::to_string(address) + ") := a0 // Store " + varFQDN);
+    emitAssign(Operand::mem(address), a0, "Store " + varFQDN);
 }
 
 // ============================================================================
@@ -400,6 +576,7 @@ void CodeGenerator::storeFromStackToMemory(const std::string &varFQDN,
 // ============================================================================
 
 void CodeGenerator::generateStatement(const Statement *stmt) {
+    tileCosts.clear();
     if (stmt == nullptr)
         return;
 
@@ -465,7 +642,7 @@ void CodeGenerator::generateNamespaceDeclaration(
     if (semanticAnalyzer != nullptr)
         semanticAnalyzer->getSymbolTable().popScope();
 
-    emit("");
+    emitBlankLine();
 }
 
 // Update variable declaration to use FQDNs
@@ -473,6 +650,7 @@ void CodeGenerator::generateVariableDeclaration(
     const VariableDeclaration *varDecl) {
     std::string varFQDN = getVariableFQDN(varDecl->name);
     std::cout << "Variable declaration: " << varFQDN << '\n';
+    std::string layoutName;
     // Track layout type if applicable by inspecting the symbol's semantic type
     if (semanticAnalyzer != nullptr) {
         Symbol *varSymbol =
@@ -481,7 +659,8 @@ void CodeGenerator::generateVariableDeclaration(
         if ((varSymbol != nullptr) && varSymbol->type) {
             const SemanticType *currentType = varSymbol->type.get();
             // Handle pointers to layouts
-            if (currentType->isPointer()) {
+            const bool isPointer = currentType->isPointer();
+            if (isPointer) {
                 const auto *ptrType =
                     static_cast<const PointerSemanticType *>(currentType);
                 currentType = ptrType->pointsTo.get();
@@ -492,24 +671,28 @@ void CodeGenerator::generateVariableDeclaration(
                     static_cast<const LayoutSemanticType *>(currentType);
                 trackVariableLayout(varFQDN, layoutType->layoutName);
                 std::cout << "Layout type: " << layoutType->layoutName << '\n';
-                // Get all members of the layout
-                for (const auto &member : layoutType->members) {
-                    std::cout
-                        << "Member FQDN: " << varFQDN + "::" + member->name
-                        << '\n';
-                    std::cout << "Member: " << member->name << '\n';
-                    std::cout << "Member type: " << member->type->toString()
-                              << '\n';
-                    std::cout << "Invoking memoryManager.allocateMemory("
-                              << varFQDN + "::" + member->name << ")" << '\n';
-                    memoryManager.allocateMemory(varFQDN + "::" + member->name);
-                }
+                if (!isPointer)
+                    layoutName = layoutType->layoutName;
             }
         }
     }
 
     // Allocate memory
-    int address = memoryManager.allocateMemory(varFQDN);
+    int address = allocateVariable(varDecl, varFQDN);
+    if (layoutName.empty())
+        scalarCells.insert(address);
+    else
+        exposedCells.insert(address);
+
+    // A layout variable holds its base address; the members follow it
+    if (!layoutName.empty()) {
+        memoryManager.allocateArray(calculateLayoutSize(layoutName) - 1);
+        layoutValueVariables.insert(varFQDN);
+        if (!varDecl->initializer && !options.compactLayouts) {
+            emitAssign(Operand::mem(address), Operand::imm(address),
+                       "Store base address for layout " + layoutName);
+        }
+    }
 
     // Generate initialization code if present
     if (varDecl->initializer) {
@@ -525,7 +708,8 @@ void CodeGenerator::generateVariableDeclaration(
                 int baseAddress = memoryManager.getVariableAddress(varFQDN);
 
                 // Store base address at base address
-                emit("p(" + std::to_string(baseAddress) + ") := " + std::to_string(baseAddress) + " // Store base address for layout " + layoutFQDN);
+                if (!options.compactLayouts)
+                    emitAssign(Operand::mem(baseAddress), Operand::imm(baseAddress), "Store base address for layout " + layoutFQDN);
 
                 // Get layout type information to determine member types
                 Symbol *layoutSymbol = semanticAnalyzer->getSymbolTable().findSymbol(layoutFQDN);
@@ -534,7 +718,7 @@ void CodeGenerator::generateVariableDeclaration(
                     layoutType = static_cast<const LayoutSemanticType *>(layoutSymbol->type.get());
                 }
                 
-                int currentOffset = 1; // Start after base address
+                int currentOffset = layoutHeaderCells(); // Start after base address
                 for (size_t i = 0; i < layoutInit->values.size(); ++i) {
                     generateExpression(layoutInit->values[i].get());
                     popFromStack("Get layout member value " + std::to_string(i));
@@ -552,18 +736,15 @@ void CodeGenerator::generateVariableDeclaration(
                             
                             // For layout members, we need to copy the entire layout
                             // The value on stack should be the base address of the source layout
-                            emit("a1 := a0 // Source layout base address");
-                            
-                            // Copy each member of the nested layout from source to destination
                             int memberLayoutSize = calculateLayoutSize(memberLayoutType->layoutName);
-                            for (int j = 1; j < memberLayoutSize; ++j) { // Start from 1, skip base address
-                                emit("a1 := a0 + " + std::to_string(j) + " // Move to source member ");
-                                emit("a2 := p(a1) // Load source member " + std::to_string(j));
-                                emit("p(" + std::to_string(memberAddress + j) + ") := a2 // Store nested layout member " + std::to_string(j));
-                            }
+                            const int header = layoutHeaderCells();
+                            if (header > 0)
+                                emitBinary(a0, a0, AlphaOperator::ADD, Operand::imm(header), "First source member");
+                            generateBlockCopy(memberAddress + header, memberLayoutSize - header);
                             
                             // Store the base address of the nested layout
-                            emit("p(" + std::to_string(memberAddress) + ") := " + std::to_string(memberAddress) + " // Store nested layout base");
+                            if (!options.compactLayouts)
+                                emitAssign(Operand::mem(memberAddress), Operand::imm(memberAddress), "Store nested layout base");
                             
                             // Update offset to account for nested layout size
                             currentOffset += memberLayoutSize;
@@ -572,7 +753,7 @@ void CodeGenerator::generateVariableDeclaration(
                     }
                     
                     // For primitive members, just store the value
-                    emit("p(" + std::to_string(memberAddress) + ") := a0 // Store member " + std::to_string(i));
+                    emitAssign(Operand::mem(memberAddress), a0, "Store member " + std::to_string(i));
                     
                     // Update offset for next member
                     currentOffset += 1;
@@ -582,13 +763,36 @@ void CodeGenerator::generateVariableDeclaration(
                 generateExpression(varDecl->initializer.get());
                 storeFromStackToMemory(varFQDN, "Initialize " + varDecl->name);
             }
-        } else {
+        } else if (!layoutName.empty()) {
+            if (!options.compactLayouts) {
+                emitAssign(Operand::mem(address), Operand::imm(address),
+                           "Store base address for layout " + layoutName);
+            }
+            generateLayoutCopy(varDecl->initializer.get(), varFQDN, layoutName);
+        } else if (!generateSelectedStore(variableOperand(varFQDN),
+                                          varDecl->initializer.get(),
+                                          "Initialize " + varDecl->name)) {
             generateExpression(varDecl->initializer.get());
             storeFromStackToMemory(varFQDN, "Initialize " + varDecl->name);
         }
     }
 }
 
+// Layout values are copied member by member into the variable's own cells,
+// so the variable never aliases the source (a callee's frame, for one)
+void CodeGenerator::generateLayoutCopy(const Expression *source,
+                                       const std::string &varFQDN,
+                                       const std::string &layoutName) {
+    generateExpression(source);
+    popFromStack("Source layout base address");
+    const int header = layoutHeaderCells();
+    if (header > 0)
+        emitBinary(a0, a0, AlphaOperator::ADD, Operand::imm(header),
+                   "First source member");
+    generateBlockCopy(memoryManager.getVariableAddress(varFQDN) + header,
+                      calculateLayoutSize(layoutName) - header);
+}
+
 void CodeGenerator::generateAssignment(const Assignment *assignment) {
     emitComment("Assignment");
     
@@ -613,10 +817,10 @@ void CodeGenerator::generateAssignment(const Assignment *assignment) {
                 popFromStack("Get layout member value " + std::to_string(i));
                 
                 // Calculate member address: base + member offset
-                int memberOffset = i + 1; // Members start at offset 1 (0 is base)
+                int memberOffset = i + layoutHeaderCells();
                 int memberAddress = baseAddress + memberOffset;
                 
-                emit("p(" + std::to_string(memberAddress) + ") := a0 // Store member " + std::to_string(i));
+                emitAssign(Operand::mem(memberAddress), a0, "Store member " + std::to_string(i));
             }
             return;
         } else {
@@ -624,6 +828,67 @@ void CodeGenerator::generateAssignment(const Assignment *assignment) {
         }
     }
     
+    if (assignment->target->nodeType == NodeType::IDENTIFIER) {
+        const auto *id =
+            static_cast<const Identifier *>(assignment->target.get());
+        std::string varFQDN = getVariableFQDN(id->name);
+        if (layoutValueVariables.contains(varFQDN)) {
+            emitComment("Layout copy into " + id->name);
+            generateLayoutCopy(assignment->value.get(), varFQDN,
+                               getVariableLayoutType(varFQDN));
+            return;
+        }
+    }
+
+    if (assignment->target->nodeType == NodeType::IDENTIFIER) {
+        const auto *id =
+            static_cast<const Identifier *>(assignment->target.get());
+        std::string varFQDN = getVariableFQDN(id->name);
+        if (memoryManager.hasVariable(varFQDN) &&
+            generateSelectedStore(variableOperand(varFQDN),
+                                  assignment->value.get(),
+                                  "Assign to " + id->name)) {
+            emitBlankLine();
+            return;
+        }
+    } else if (assignment->target->nodeType == NodeType::ARRAY_ACCESS) {
+        const auto *arrayAccess =
+            static_cast<const ArrayAccess *>(assignment->target.get());
+        if (options.registerExpressions && options.memoryOperands &&
+            isRegisterExpression(arrayAccess->array.get()) &&
+            isRegisterExpression(arrayAccess->index.get()) &&
+            isRegisterExpression(assignment->value.get())) {
+            // p(a + i) := value, with the element address in a register
+            emitComment("Array access assignment");
+            auto [array, index] = generateRegisterOperands(
+                arrayAccess->array.get(), arrayAccess->index.get());
+            const int address = takeResultRegister(array, index);
+            emitBinary(Operand::reg(address), array.toOperand(),
+                       AlphaOperator::ADD, index.toOperand(),
+                       "Calculate element address");
+            generateSelectedStore(Operand::indirect(address),
+                                  assignment->value.get(),
+                                  "Store value in array element");
+            registerAllocator.deallocateRegister(address);
+            emitBlankLine();
+            return;
+        }
+    } else if (assignment->target->nodeType == NodeType::MEMBER_ACCESS) {
+        std::string memberLayout;
+        auto address = getStaticMemberAddress(
+            static_cast<const MemberAccess *>(assignment->target.get()),
+            memberLayout);
+        if (address && memberLayout.empty() &&
+            generateSelectedStore(
+                Operand::mem(*address), assignment->value.get(),
+                "Store value in member " +
+                    static_cast<const MemberAccess *>(assignment->target.get())
+                        ->memberName)) {
+            emitBlankLine();
+            return;
+        }
+    }
+
     generateExpression(assignment->value.get()); // value on stack
 
     if (assignment->target->nodeType == NodeType::IDENTIFIER) {
@@ -636,6 +901,15 @@ void CodeGenerator::generateAssignment(const Assignment *assignment) {
             static_cast<const MemberAccess *>(assignment->target.get());
         emitComment("Member access assignment");
 
+        std::string memberLayout;
+        if (auto address = getStaticMemberAddress(memberAccess, memberLayout)) {
+            popFromStack("Get assignment value");
+            emitAssign(Operand::mem(*address), a0,
+                       "Store value in member " + memberAccess->memberName);
+            emitBlankLine();
+            return;
+        }
+
         // Determine the layout type first, then generate the object expression
         std::string layoutFQDN;
         std::string objDescription;
@@ -788,12 +1062,13 @@ void CodeGenerator::generateAssignment(const Assignment *assignment) {
 
             // Calculate member address: object base address + member offset
             popFromStack("Get object base address"); // → Error stackunderflow
-            emit("a1 := a0 + " + std::to_string(memberOffset) + 
-                 " // Calculate member address (" + objDescription + "." + 
-                 memberAccess->memberName + ")");
+            emitBinary(a1, a0, AlphaOperator::ADD, Operand::imm(memberOffset),
+                       "Calculate member address (" + objDescription + "." +
+                           memberAccess->memberName + ")");
             
             popFromStack("Get assignment value");
-            emit("p(a1) := a0 // Store value in member " + memberAccess->memberName);
+            emitAssign(Operand::indirect(1), a0,
+                       "Store value in member " + memberAccess->memberName);
         } else {
             emitComment("Warning: Could not determine layout type for " + objDescription);
             popFromStack("Discard object address");
@@ -807,14 +1082,15 @@ void CodeGenerator::generateAssignment(const Assignment *assignment) {
         generateExpression(arrayAccess->array.get());
         generateExpression(arrayAccess->index.get());
         popFromStack("Get index");
-        emit("a1 := a0 // Store index in a1");
+        emitAssign(a1, a0, "Store index in a1");
         popFromStack("Get array base address");
-        emit("a2 := a0 + a1 // Calculate element address (base + index)");
+        emitBinary(a2, a0, AlphaOperator::ADD, a1,
+                   "Calculate element address (base + index)");
         popFromStack("Get assignment value");
-        emit("p(a2) := a0 // Store value in array element");
+        emitAssign(Operand::indirect(2), a0, "Store value in array element");
     }
 
-    emit("");
+    emitBlankLine();
 }
 
 void CodeGenerator::generateExpressionStatement(
@@ -823,7 +1099,7 @@ void CodeGenerator::generateExpressionStatement(
     generateExpression(exprStmt->expression.get());
     // Pop the result since iter's not used
     popFromStack("Discard expression result");
-    emit("");
+    emitBlankLine();
 }
 
 void CodeGenerator::generateLayoutDeclaration(
@@ -831,7 +1107,7 @@ void CodeGenerator::generateLayoutDeclaration(
     emitComment("Layout declaration: " + layoutDecl->name);
     emitComment("DEBUG: Processing layout declaration for " + layoutDecl->name);
     setupLayoutMembers(layoutDecl->name, layoutDecl->members);
-    emit("");
+    emitBlankLine();
 }
 
 // ============================================================================
@@ -842,6 +1118,35 @@ void CodeGenerator::generateExpression(const Expression *expr) {
     if (expr == nullptr)
         return;
 
+    if (expr->nodeType != NodeType::LITERAL) {
+        if (auto value = tryFoldConstant(expr)) {
+            emitAssign(a0, Operand::imm(*value), "Folded constant");
+            pushToStack("Constant value");
+            return;
+        }
+    }
+    if (expr->nodeType == NodeType::BINARY_EXPRESSION) {
+        const auto *binExpr = static_cast<const BinaryExpression *>(expr);
+        if (const Expression *operand = getIdentityOperand(binExpr)) {
+            generateExpression(operand);
+            return;
+        }
+    }
+
+    // Operator trees without calls are evaluated in registers; the result
+    // still goes to the stack like every other expression
+    if (options.registerExpressions &&
+        (expr->nodeType == NodeType::BINARY_EXPRESSION ||
+         expr->nodeType == NodeType::UNARY_EXPRESSION ||
+         expr->nodeType == NodeType::TYPE_CAST ||
+         expr->nodeType == NodeType::ARRAY_ACCESS) &&
+        isRegisterExpression(expr)) {
+        const int reg = generateRegisterExpression(expr);
+        pushRegisterToStack(reg, "Expression result");
+        registerAllocator.deallocateRegister(reg);
+        return;
+    }
+
     switch (expr->nodeType) {
     case NodeType::LITERAL:
         generateLiteral(dynamic_cast<const Literal *>(expr));
@@ -882,7 +1187,7 @@ void CodeGenerator::generateExpression(const Expression *expr) {
         break;
     default:
         emitComment("Warning: Unhandled expression type");
-        emit("a0 := 0");
+        emitAssign(a0, Operand::imm(0));
         pushToStack("Default value for unhandled expression");
         break;
     }
@@ -907,13 +1212,8 @@ void CodeGenerator::generateTypeCast(const TypeCast *typeCast) {
         // Just emit a warning if casting between different sizes
         if (basicTargetType->baseType == TokenType::CHAR) {
             emitComment("Warning: Possible data loss when casting to char");
-            // Use BITWISE_AND with 255 to mask to char size
-            emit("a0 := 255 // Load mask for char size");
-            pushToStack("Mask to stack");
-            emit(
-                "call namespace_bit_BITWISE_AND // Mask to char size (8 bits)");
-            pushToStack(
-                "cast result"); // Use pushToStack to properly track stack depth
+            // Keep the low 8 bits
+            generateMaskOperation(256);
         } else {
             // For int, we don't need to do anything special
             // The value is already the right size
@@ -933,15 +1233,15 @@ void CodeGenerator::generateLiteral(const Literal *literal) {
         if (!value.empty()) {
             char c = value[0];
             int asciiValue = static_cast<int>(static_cast<unsigned char>(c));
-            emit("a0 := " + std::to_string(asciiValue));
+            emitAssign(a0, Operand::imm(asciiValue));
             pushToStack("Character literal");
         } else {
             // Empty character literal, default to 0
-            emit("a0 := 0");
+            emitAssign(a0, Operand::imm(0));
             pushToStack("Empty character literal");
         }
     } else {
-        emit("a0 := " + value);
+        emitAssign(a0, Operand::imm(tryFoldConstant(literal).value_or(0)));
         pushToStack("Literal value" + literal->value);
     }
 }
@@ -950,10 +1250,17 @@ void CodeGenerator::generateStringLiteral(const StringLiteral *stringLit) {
     std::string value = stringLit->value;
     int stringLength = value.length();
 
+    if (options.poolStrings && !writtenStringLiterals.contains(value)) {
+        emitAssign(a0, Operand::imm(internString(value)),
+                   "Pooled string address");
+        pushToStack(" string array address");
+        return;
+    }
+
     // emitComment("String literal: \"" + stringLit->value + "\"");
 
     // Allocate memory for the string as a character array + null terminator
-    int baseAddress = memoryManager.allocateArray(stringLength + 1);
+    int baseAddress = allocateStaticData(stringLength + 1);
 
     // Initialize each character in the array
     for (int i = 0; i < stringLength; i++) {
@@ -991,20 +1298,283 @@ void CodeGenerator::generateStringLiteral(const StringLiteral *stringLit) {
             break;
         }
 
-        emit("p(" + std::to_string(baseAddress + i) +
-             ") := " + std::to_string(asciiValue) + " // <char alloc>");
+        emitAssign(Operand::mem(baseAddress + i), Operand::imm(asciiValue),
+                   "<char alloc>");
     }
 
     // Add null terminator at the end
-    emit("p(" + std::to_string(baseAddress + stringLength) +
-         ") := 0 // Null terminator");
+    emitAssign(Operand::mem(baseAddress + stringLength), Operand::imm(0),
+               "Null terminator");
 
     // Push the base address of the string array onto the stack
-    emit("a0 := " + std::to_string(baseAddress) +
-         " // Base address of string array");
+    emitAssign(a0, Operand::imm(baseAddress),
+               "Base address of string array");
     pushToStack(" string array address");
 }
 
+// Address of a pooled literal. Without frame overlay the pool grows as
+// literals are met; with it generate() places the literals of reachable
+// code before the final pass, and anything else belongs to code that is
+// dropped (or to the layout pass itself).
+int CodeGenerator::internString(const std::string &value) {
+    currentStringLiterals.insert(value);
+    if (auto pooled = stringPool.find(value); pooled != stringPool.end())
+        return pooled->second;
+    if (options.overlayFrames)
+        return staticDataBase;
+
+    const int address =
+        memoryManager.allocateArray(static_cast<int>(value.size()) + 1);
+    stringPool[value] = address;
+    return address;
+}
+
+std::vector<Instruction>
+CodeGenerator::generateStringPool(const std::set<std::string> &literals) const {
+    std::vector<Instruction> pool;
+    for (const auto &literal : literals) {
+        int address = stringPool.at(literal);
+        pool.push_back(Instruction::makeComment(
+            " String pool: " + std::to_string(literal.size()) + " characters"));
+        for (char c : literal) {
+            pool.push_back(Instruction::makeAssign(
+                Operand::mem(address++),
+                Operand::imm(static_cast<unsigned char>(c))));
+        }
+        Instruction terminator = Instruction::makeAssign(
+            Operand::mem(address), Operand::imm(0));
+        terminator.comment = " Null terminator";
+        pool.push_back(std::move(terminator));
+    }
+    return pool;
+}
+
+// Literals a store may reach. Pointers are tracked by name only: every
+// variable, parameter and function result named alike shares one set of
+// literals it may point to. A literal is written through when it reaches
+// the base of an element or member store, the buffer of a syscall that is
+// not a write or exit, or escapes to memory (stored into an element or
+// member, or the variable holding it has its address taken).
+std::unordered_set<std::string>
+CodeGenerator::findWrittenStringLiterals(const Program *program) {
+    using Literals = std::unordered_set<std::string>;
+
+    struct Analysis {
+        std::unordered_multimap<std::string, const FunctionDeclaration *>
+            functions;
+        std::unordered_map<std::string, Literals> variables;
+        std::unordered_map<std::string, Literals> results;
+        Literals written;
+        std::string function;
+        bool changed{false};
+
+        static std::string baseName(const std::string &name) {
+            const size_t dot = name.rfind('.');
+            return dot == std::string::npos ? name : name.substr(dot + 1);
+        }
+
+        void add(Literals &into, const Literals &literals) {
+            for (const auto &literal : literals)
+                changed |= into.insert(literal).second;
+        }
+
+        void collectFunctions(const Statement *stmt) {
+            if (stmt->nodeType == NodeType::FUNCTION_DECLARATION) {
+                const auto *funcDecl =
+                    static_cast<const FunctionDeclaration *>(stmt);
+                functions.emplace(funcDecl->name, funcDecl);
+            } else if (stmt->nodeType == NodeType::NAMESPACE_DECLARATION) {
+                for (const auto &inner :
+                     static_cast<const NamespaceDeclaration *>(stmt)
+                         ->statements)
+                    collectFunctions(inner.get());
+            }
+        }
+
+        // Literals the value of `expr` may point to
+        Literals visit(const Expression *expr) {
+            if (expr == nullptr)
+                return {};
+            switch (expr->nodeType) {
+            case NodeType::STRING_LITERAL:
+                return {static_cast<const StringLiteral *>(expr)->value};
+            case NodeType::IDENTIFIER:
+                return variables[static_cast<const Identifier *>(expr)->name];
+            case NodeType::BINARY_EXPRESSION: {
+                const auto *binExpr =
+                    static_cast<const BinaryExpression *>(expr);
+                Literals literals = visit(binExpr->left.get());
+                literals.merge(visit(binExpr->right.get()));
+                return literals;
+            }
+            case NodeType::UNARY_EXPRESSION: {
+                const auto *unExpr = static_cast<const UnaryExpression *>(expr);
+                if (unExpr->operator_ == TokenType::REFERENCE) {
+                    add(written, visit(unExpr->operand.get()));
+                    return {};
+                }
+                Literals literals = visit(unExpr->operand.get());
+                if (unExpr->operator_ == TokenType::DEREFERENCE)
+                    return {};
+                return literals;
+            }
+            case NodeType::TYPE_CAST:
+                return visit(
+                    static_cast<const TypeCast *>(expr)->expression.get());
+            case NodeType::ARRAY_ACCESS: {
+                const auto *access = static_cast<const ArrayAccess *>(expr);
+                visit(access->array.get());
+                visit(access->index.get());
+                return {};
+            }
+            case NodeType::MEMBER_ACCESS:
+                visit(static_cast<const MemberAccess *>(expr)->object.get());
+                return {};
+            case NodeType::ARRAY_ALLOCATION:
+                visit(static_cast<const ArrayAllocation *>(expr)->size.get());
+                return {};
+            case NodeType::LAYOUT_INITIALIZATION:
+                for (const auto &value :
+                     static_cast<const LayoutInitialization *>(expr)->values)
+                    add(written, visit(value.get()));
+                return {};
+            case NodeType::SYSCALL_EXPRESSION: {
+                const auto &arguments =
+                    static_cast<const SyscallExpression *>(expr)->arguments;
+                auto number = arguments.empty()
+                                  ? std::nullopt
+                                  : tryFoldConstant(arguments.front().get());
+                // Only read (0) stores into its buffer; write is 1, exit 60
+                const bool reads = !number || (*number != 1 && *number != 60);
+                for (const auto &argument : arguments) {
+                    Literals literals = visit(argument.get());
+                    if (reads)
+                        add(written, literals);
+                }
+                return {};
+            }
+            case NodeType::FUNCTION_CALL: {
+                const auto *funcCall = static_cast<const FunctionCall *>(expr);
+                const std::string name = baseName(funcCall->functionName);
+                auto [first, last] = functions.equal_range(name);
+                for (size_t i = 0; i < funcCall->arguments.size(); ++i) {
+                    Literals literals = visit(funcCall->arguments[i].get());
+                    if (first == last)
+                        add(written, literals);
+                    for (auto it = first; it != last; ++it) {
+                        const auto &parameters = it->second->parameters;
+                        if (i < parameters.size())
+                            add(variables[parameters[i]->name], literals);
+                    }
+                }
+                return results[name];
+            }
+            default:
+                return {};
+            }
+        }
+
+        void visit(const Statement *stmt) {
+            if (stmt == nullptr)
+                return;
+            switch (stmt->nodeType) {
+            case NodeType::VARIABLE_DECLARATION: {
+                const auto *varDecl =
+                    static_cast<const VariableDeclaration *>(stmt);
+                add(variables[varDecl->name],
+                    visit(varDecl->initializer.get()));
+                break;
+            }
+            case NodeType::ASSIGNMENT: {
+                const auto *assignment = static_cast<const Assignment *>(stmt);
+                Literals value = visit(assignment->value.get());
+                const Expression *target = assignment->target.get();
+                if (target->nodeType == NodeType::IDENTIFIER) {
+                    add(variables[static_cast<const Identifier *>(target)
+                                      ->name],
+                        value);
+                } else if (target->nodeType == NodeType::ARRAY_ACCESS) {
+                    const auto *access =
+                        static_cast<const ArrayAccess *>(target);
+                    add(written, visit(access->array.get()));
+                    visit(access->index.get());
+                    add(written, value);
+                } else if (target->nodeType == NodeType::MEMBER_ACCESS) {
+                    add(written,
+                        visit(static_cast<const MemberAccess *>(target)
+                                  ->object.get()));
+                    add(written, value);
+                }
+                break;
+            }
+            case NodeType::EXPRESSION_STATEMENT:
+                visit(static_cast<const ExpressionStatement *>(stmt)
+                          ->expression.get());
+                break;
+            case NodeType::RETURN_STATEMENT:
+                add(results[function],
+                    visit(static_cast<const ReturnStatement *>(stmt)
+                              ->value.get()));
+                break;
+            case NodeType::IF_STATEMENT: {
+                const auto *ifStmt = static_cast<const IfStatement *>(stmt);
+                visit(ifStmt->condition.get());
+                visit(ifStmt->thenStatement.get());
+                visit(ifStmt->elseStatement.get());
+                break;
+            }
+            case NodeType::WHILE_STATEMENT: {
+                const auto *whileStmt =
+                    static_cast<const WhileStatement *>(stmt);
+                visit(whileStmt->condition.get());
+                visit(whileStmt->body.get());
+                break;
+            }
+            case NodeType::BLOCK_STATEMENT:
+                for (const auto &inner :
+                     static_cast<const BlockStatement *>(stmt)->statements)
+                    visit(inner.get());
+                break;
+            case NodeType::FUNCTION_DECLARATION: {
+                const auto *funcDecl =
+                    static_cast<const FunctionDeclaration *>(stmt);
+                function = funcDecl->name;
+                visit(funcDecl->body.get());
+                function.clear();
+                break;
+            }
+            case NodeType::NAMESPACE_DECLARATION:
+                for (const auto &inner :
+                     static_cast<const NamespaceDeclaration *>(stmt)
+                         ->statements)
+                    visit(inner.get());
+                break;
+            default:
+                break;
+            }
+        }
+    };
+
+    Analysis analysis;
+    for (const auto &statement : program->statements)
+        analysis.collectFunctions(statement.get());
+    // Sets only grow, so this settles
+    do {
+        analysis.changed = false;
+        for (const auto &statement : program->statements)
+            analysis.visit(statement.get());
+    } while (analysis.changed);
+    return std::move(analysis.written);
+}
+
+// Operand for a variable's value: its cell, or for a layout it owns the
+// address of its cells
+Operand CodeGenerator::variableOperand(const std::string &varFQDN) {
+    const int address = memoryManager.getVariableAddress(varFQDN);
+    return layoutValueVariables.contains(varFQDN) ? Operand::imm(address)
+                                                  : Operand::mem(address);
+}
+
 void CodeGenerator::generateIdentifier(const Identifier *id) {
     std::string varFQDN = getVariableFQDN(id->name);
     if (memoryManager.hasVariable(varFQDN)) {
@@ -1014,24 +1584,40 @@ void CodeGenerator::generateIdentifier(const Identifier *id) {
         
         // Check if this is a layout variable
         std::string layoutFQDN = getVariableLayoutType(varFQDN);
-        if (!layoutFQDN.empty()) {
+        if (layoutValueVariables.contains(varFQDN)) {
+            // The variable's own cells hold the layout
+            emitAssign(a0, Operand::imm(address),
+                       "Layout base address of " + id->name);
+        } else if (!layoutFQDN.empty()) {
             // For layout variables, return the base address (stored at the address)
-            emit("a0 := p(" + std::to_string(address) + ") // Load layout base address for " + id->name);
+            emitAssign(a0, Operand::mem(address), "Load layout base address for " + id->name);
             emitComment("DEBUG: Variable " + id->name + " is layout type " + layoutFQDN);
         } else {
             // For primitive variables, load the value
-            emit("a0 := p(" + std::to_string(address) + ") // Load " + id->name);
+            emitAssign(a0, Operand::mem(address), "Load " + id->name);
         }
         
         pushToStack(" variable " + id->name);
     } else {
         emitComment("WARNING: Undefined variable " + varFQDN + " - using 0");
-        emit("a0 := 0");
+        emitAssign(a0, Operand::imm(0));
         pushToStack(" undefined variable " + id->name);
     }
 }
 
 void CodeGenerator::generateBinaryExpression(const BinaryExpression *binExpr) {
+    if (binExpr->operator_ == TokenType::BITWISE_AND ||
+        binExpr->operator_ == TokenType::BITWISE_OR ||
+        binExpr->operator_ == TokenType::BITWISE_XOR) {
+        generateBitwiseExpression(binExpr);
+        return;
+    }
+    if (binExpr->operator_ == TokenType::LOGICAL_AND ||
+        binExpr->operator_ == TokenType::LOGICAL_OR) {
+        generateLogicalExpression(binExpr);
+        return;
+    }
+
     // Generate left operand (will be on stack)
     generateExpression(binExpr->left.get());
 
@@ -1042,7 +1628,7 @@ void CodeGenerator::generateBinaryExpression(const BinaryExpression *binExpr) {
     if (isComparisonOperator(binExpr->operator_)) {
         // Pop both operands to registers
         popFromStack("Get right operand");
-        emit("a1 := a0");
+        emitAssign(a1, a0);
         popFromStack("Get left operand");
 
         // Generate comparison result directly
@@ -1050,34 +1636,13 @@ void CodeGenerator::generateBinaryExpression(const BinaryExpression *binExpr) {
 
         // Result is already pushed by generateComparisonResult
     }
-    // Handle bitwise operations
-    else if (binExpr->operator_ == TokenType::BITWISE_AND ||
-             binExpr->operator_ == TokenType::BITWISE_OR ||
-             binExpr->operator_ == TokenType::BITWISE_XOR) {
-        // Pop operands into registers
-        // a0 now has left operand, a1 has right operand
-
-        switch (binExpr->operator_) {
-        case TokenType::BITWISE_AND:
-            emit("call namespace_bit_BITWISE_AND // Perform bitwise AND");
-            break;
-        case TokenType::BITWISE_OR:
-            emit("call namespace_bit_BITWISE_OR // Perform bitwise OR");
-            break;
-        case TokenType::BITWISE_XOR:
-            emit("call namespace_bit_BITWISE_XOR // Perform bitwise XOR");
-            break;
-        default:
-            break;
-        }
-
-        // Result is now in a0
-        pushToStack(" bitwise operation result");
-    }
     // Handle regular arithmetic operations
     else {
-        std::string op = getOperatorInstruction(binExpr->operator_);
-        emit(op + " // Binary operation");
+        const AlphaOperator op = getOperatorInstruction(binExpr->operator_);
+        if (op == AlphaOperator::NONE)
+            emit(Instruction::make(InstructionKind::NOP), "Unknown operator");
+        else
+            emit(Instruction::makeStackOperation(op), "Binary operation");
     }
 }
 
@@ -1092,18 +1657,18 @@ void CodeGenerator::generateUnaryExpression(const UnaryExpression *unExpr) {
                 static_cast<const Identifier *>(unExpr->operand.get());
             if (memoryManager.hasVariable(id->name)) {
                 int address = memoryManager.getVariableAddress(id->name);
-                emit("a0 := " + std::to_string(address) + " // Address of " +
-                     id->name);
+                exposedCells.insert(address);
+                emitAssign(a0, Operand::imm(address), "Address of " + id->name);
                 pushToStack(" address");
             } else {
                 emitComment("Warning: Taking address of undefined variable " +
                             id->name);
-                emit("a0 := 0");
+                emitAssign(a0, Operand::imm(0));
                 pushToStack(" null address");
             }
         } else {
             emitComment("Warning: Reference operator on non-identifier");
-            emit("a0 := 0");
+            emitAssign(a0, Operand::imm(0));
             pushToStack(" null address");
         }
         break;
@@ -1111,8 +1676,13 @@ void CodeGenerator::generateUnaryExpression(const UnaryExpression *unExpr) {
     case TokenType::DEREFERENCE: {
         // Dereference operator (<-): load value from address
         generateExpression(unExpr->operand.get()); // Get the address
+        if (options.compactLayouts && pointsToLayout(unExpr->operand.get())) {
+            // A layout's value is its address; there is no cell to load
+            emitComment("Dereferenced layout keeps its address");
+            break;
+        }
         popFromStack("Get address");
-        emit("a0 := p(a0) // Dereference address");
+        emitAssign(a0, Operand::indirect(0), "Dereference address");
         pushToStack(" dereferenced value");
         break;
     }
@@ -1120,8 +1690,8 @@ void CodeGenerator::generateUnaryExpression(const UnaryExpression *unExpr) {
         // Unary minus: negate value
         generateExpression(unExpr->operand.get());
         popFromStack("Get value");
-        emit("a1 := 0");
-        emit("a0 := a1 - a0 // Negate value");
+        emitAssign(a1, Operand::imm(0));
+        emitBinary(a0, a1, AlphaOperator::SUB, a0, "Negate value");
         pushToStack(" negated value");
         break;
     }
@@ -1129,7 +1699,7 @@ void CodeGenerator::generateUnaryExpression(const UnaryExpression *unExpr) {
         // Bitwise NOT: flip all bits
         generateExpression(unExpr->operand.get());
         popFromStack("Get value");
-        emit("a0 := ~a0 // Bitwise NOT");
+        emit(Instruction::makeUnary(a0, AlphaOperator::NOT, a0), "Bitwise NOT");
         pushToStack(" NOT result");
         break;
     }
@@ -1140,7 +1710,8 @@ void CodeGenerator::generateUnaryExpression(const UnaryExpression *unExpr) {
     }
 }
 
-void CodeGenerator::generateFunctionCall(const FunctionCall *funcCall) {
+std::string
+CodeGenerator::resolveFunctionLabel(const FunctionCall *funcCall) const {
     // Check if this is a namespace-qualified function call
     size_t dotPos = funcCall->functionName.find('.');
     std::string actualFunctionName;
@@ -1184,110 +1755,511 @@ void CodeGenerator::generateFunctionCall(const FunctionCall *funcCall) {
         }
     }
 
+    return actualFunctionName;
+}
+
+void CodeGenerator::generateFunctionCall(const FunctionCall *funcCall) {
+    const std::string actualFunctionName = resolveFunctionLabel(funcCall);
+
+    auto candidate = inlineCandidates.find(actualFunctionName);
+    if (candidate != inlineCandidates.end() &&
+        candidate->second->parameters.size() == funcCall->arguments.size()) {
+        generateInlineCall(funcCall, candidate->second);
+        return;
+    }
+
     emitComment("Function call: " + funcCall->functionName);
 
-    // Push arguments in reverse order
+    // A call that can re-enter the current function keeps the caller's
+    // frame on the stack
+    const FrameLayout *savedFrame = nullptr;
+    auto callerFrame = frameLayouts.find(currentFunctionLabel);
+    auto calleeFrame = frameLayouts.find(actualFunctionName);
+    if (callerFrame != frameLayouts.end() &&
+        calleeFrame != frameLayouts.end() &&
+        callerFrame->second.component == calleeFrame->second.component &&
+        callerFrame->second.size > 0) {
+        savedFrame = &callerFrame->second;
+        generateFrameSave(*savedFrame);
+    }
+
+    // Push arguments in reverse order; under the register convention only
+    // those after the seventh
     int argCount = funcCall->arguments.size();
-    emitComment("DEBUG: Pushing " + std::to_string(argCount) + " arguments");
+    auto parameterCount = functionParameterCounts.find(actualFunctionName);
+    if (parameterCount != functionParameterCounts.end() &&
+        parameterCount->second != argCount) {
+        throw CodeGeneratorError("Function '" + funcCall->functionName +
+                                 "' expects " +
+                                 std::to_string(parameterCount->second) +
+                                 " arguments, got " + std::to_string(argCount));
+    }
+    const bool registerCall = usesRegisterCalls(actualFunctionName);
+    const int registerArguments =
+        registerCall ? std::min(argCount, argumentRegisterCount) : 0;
+    emitComment(std::to_string(argCount - registerArguments) +
+                " arguments passed on the stack");
 
-    for (int i = argCount - 1; i >= 0; i--) {
+    for (int i = argCount - 1; i >= registerArguments; i--) {
         emitComment("DEBUG: Pushing argument " + std::to_string(i));
         generateExpression(funcCall->arguments[i].get());
     }
+    generateArgumentRegisters(funcCall->arguments, registerArguments, 1);
 
     // Call the function using the actual function name
-    emit("call " + actualFunctionName + " // Function call");
+    emit(Instruction::makeJump(InstructionKind::CALL, actualFunctionName),
+         "Function call");
+    currentCallees.insert(actualFunctionName);
+
+    if (registerCall) {
+        // The callee consumed the stack arguments and left its result in a0
+        stackDepth -= argCount - registerArguments;
+        pushToStack("Return value");
+    }
+
+    if (savedFrame != nullptr)
+        generateFrameRestore(*savedFrame);
 
     // Function call result is already on stack (function pushed iter)
     // No additional stack operations needed
     emitComment("DEBUG: Function call completed - return value is on stack");
 }
 
-// Update member access to use FQDNs
-void CodeGenerator::generateMemberAccess(const MemberAccess *memberAccess) {
-    // Determine layout type BEFORE generating the object expression
-    std::string objFQDN;
-    std::string layoutFQDN;
-    
-    if (memberAccess->object->nodeType == NodeType::IDENTIFIER) {
-        const auto *objId =
-            static_cast<const Identifier *>(memberAccess->object.get());
-        objFQDN = getVariableFQDN(objId->name);
-        layoutFQDN = getVariableLayoutType(objFQDN);
-        emitComment("DEBUG: Simple identifier access: " + objFQDN + " has layout type " + layoutFQDN);
-    } else if (memberAccess->object->nodeType == NodeType::ARRAY_ACCESS) {
-        // Handle array access - get the array variable and its element type
-        const auto *arrayAccess = static_cast<const ArrayAccess *>(memberAccess->object.get());
-        
-        if (arrayAccess->array->nodeType == NodeType::IDENTIFIER) {
-            const auto *arrayId = static_cast<const Identifier *>(arrayAccess->array.get());
-            std::string arrayFQDN = getVariableFQDN(arrayId->name);
-            
-            // Find the array's element type (which should be a layout)
-            Symbol *arraySymbol = semanticAnalyzer->getSymbolTable().findSymbolByFQDN(arrayFQDN);
-            if (arraySymbol && arraySymbol->type && arraySymbol->type->isPointer()) {
-                const auto *ptrType = static_cast<const PointerSemanticType *>(arraySymbol->type.get());
-                if (ptrType->pointsTo && ptrType->pointsTo->isLayout()) {
-                    const auto *layoutType = static_cast<const LayoutSemanticType *>(ptrType->pointsTo.get());
-                    layoutFQDN = layoutType->layoutName;
-                    objFQDN = arrayFQDN + "[" + arrayAccess->index->toString() + "]";
-                    emitComment("DEBUG: Array element has layout type " + layoutFQDN);
-                }
-            }
+// A call whose value the current function returns unchanged can leave
+// through the callee: the arguments are passed as for a call, then control
+// jumps to the callee's entry, which stores them into its parameters and
+// returns straight to our caller. For a self call that is parameter
+// reassignment plus a jump back to the top. Returns false when the call
+// needs the regular path.
+bool CodeGenerator::tryGenerateTailCall(const FunctionCall *funcCall) {
+    if (!options.tailCalls || !inlineReturnLabels.empty() ||
+        currentFunctionLabel.empty() || currentFunctionLabel == "global::main")
+        return false;
+
+    const std::string actualFunctionName = resolveFunctionLabel(funcCall);
+    auto parameterCount = functionParameterCounts.find(actualFunctionName);
+    const int argCount = funcCall->arguments.size();
+    // Unknown targets, inlined bodies and leftover stack values (the callee
+    // would return past them) rule a jump out
+    if (parameterCount == functionParameterCounts.end() ||
+        parameterCount->second != argCount ||
+        actualFunctionName == "global::main" ||
+        inlineCandidates.contains(actualFunctionName) || stackDepth != 0 ||
+        usesRegisterCalls(actualFunctionName) !=
+            usesRegisterCalls(currentFunctionLabel))
+        return false;
+
+    emitComment("Tail call: " + funcCall->functionName);
+    const int registerArguments =
+        usesRegisterCalls(actualFunctionName)
+            ? std::min(argCount, argumentRegisterCount)
+            : 0;
+    for (int i = argCount - 1; i >= registerArguments; i--) {
+        generateExpression(funcCall->arguments[i].get());
+    }
+    generateArgumentRegisters(funcCall->arguments, registerArguments, 1);
+
+    // Our frame is dead from here on, so nothing is saved even when the
+    // callee shares its component
+    emitJump(actualFunctionName, "Tail call");
+    currentCallees.insert(actualFunctionName);
+    stackDepth -= argCount - registerArguments;
+    return true;
+}
+
+// Loads arguments [0, count) into a<firstRegister>... Arguments that need
+// code are evaluated left to right on the stack and popped into their
+// registers; constants, and variables when no argument makes a call, are
+// loaded straight into theirs afterwards.
+void CodeGenerator::generateArgumentRegisters(
+    const std::vector<std::unique_ptr<Expression>> &arguments, size_t count,
+    int firstRegister) {
+    bool argumentsCall = false;
+    for (size_t i = 0; i < count; ++i) {
+        argumentsCall |= containsCall(arguments[i].get());
+    }
+    auto isDirect = [&](const Expression *argument) {
+        return tryFoldConstant(argument).has_value() ||
+               (argument->nodeType == NodeType::IDENTIFIER && !argumentsCall);
+    };
+
+    std::vector<size_t> computed;
+    for (size_t i = 0; i < count; ++i) {
+        if (!isDirect(arguments[i].get())) {
+            generateExpression(arguments[i].get());
+            computed.push_back(i);
         }
-    } else if (memberAccess->object->nodeType == NodeType::MEMBER_ACCESS) {
-        // Handle nested member access like n.tuple.right
-        const auto *nestedMemberAccess = static_cast<const MemberAccess *>(memberAccess->object.get());
-        
-        // Get the layout type by tracing through the chain
-        if (nestedMemberAccess->object->nodeType == NodeType::IDENTIFIER) {
-            const auto *baseId = static_cast<const Identifier *>(nestedMemberAccess->object.get());
-            std::string baseFQDN = getVariableFQDN(baseId->name);
-            std::string baseLayoutFQDN = getVariableLayoutType(baseFQDN);
-            
-            if (!baseLayoutFQDN.empty()) {
-                // Find the type of the nested member
-                Symbol *baseLayoutSymbol = semanticAnalyzer->getSymbolTable().findSymbol(baseLayoutFQDN);
-                if (baseLayoutSymbol && baseLayoutSymbol->symbolKind == SymbolKind::LAYOUT) {
-                    const auto *baseLayoutType = static_cast<const LayoutSemanticType *>(baseLayoutSymbol->type.get());
-                    for (const auto &member : baseLayoutType->members) {
-                        if (member->name == nestedMemberAccess->memberName) {
-                            if (member->type->isLayout()) {
-                                const auto *memberLayoutType = static_cast<const LayoutSemanticType *>(member->type.get());
-                                layoutFQDN = memberLayoutType->layoutName;
-                                objFQDN = baseId->name + "." + nestedMemberAccess->memberName;
-                                emitComment("DEBUG: Chained member access: " + objFQDN + " has layout type " + layoutFQDN);
-                            } else {
-                                emitComment("DEBUG: Member " + nestedMemberAccess->memberName + " is not a layout type");
-                                objFQDN = baseId->name + "." + nestedMemberAccess->memberName;
-                            }
-                            break;
-                        }
-                    }
-                }
-            }
+    }
+    for (size_t i : std::ranges::reverse_view(computed)) {
+        popStackToRegister(firstRegister + static_cast<int>(i),
+                           "Argument " + std::to_string(i));
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        const Expression *argument = arguments[i].get();
+        if (!isDirect(argument))
+            continue;
+        const Operand reg = Operand::reg(firstRegister + static_cast<int>(i));
+        if (auto value = tryFoldConstant(argument)) {
+            emitAssign(reg, Operand::imm(*value),
+                       "Argument " + std::to_string(i));
+            continue;
         }
-    } else if (memberAccess->object->nodeType == NodeType::UNARY_EXPRESSION) {
-        // Handle dereference operations like (<-n.tuple).right
-        const auto *unaryExpr = static_cast<const UnaryExpression *>(memberAccess->object.get());
-        
-        if (unaryExpr->operator_ == TokenType::DEREFERENCE) {
-            emitComment("DEBUG: Handling dereference in member access");
-            
-            // The operand of dereference should give us a pointer to a layout
-            if (unaryExpr->operand->nodeType == NodeType::MEMBER_ACCESS) {
-                // Case: (<-b.ptr).value where b.ptr is a pointer to layout
-                const auto *ptrMemberAccess = static_cast<const MemberAccess *>(unaryExpr->operand.get());
-                
-                if (ptrMemberAccess->object->nodeType == NodeType::IDENTIFIER) {
-                    const auto *baseId = static_cast<const Identifier *>(ptrMemberAccess->object.get());
-                    std::string baseFQDN = getVariableFQDN(baseId->name);
-                    std::string baseLayoutFQDN = getVariableLayoutType(baseFQDN);
-                    
-                    emitComment("DEBUG: Analyzing dereference of member access " + baseId->name + "." + ptrMemberAccess->memberName);
-                    emitComment("DEBUG: Base object " + baseId->name + " has layout type " + baseLayoutFQDN);
-                    
-                    if (!baseLayoutFQDN.empty()) {
+        const auto *id = static_cast<const Identifier *>(argument);
+        std::string varFQDN = getVariableFQDN(id->name);
+        if (memoryManager.hasVariable(varFQDN)) {
+            emitAssign(reg, variableOperand(varFQDN),
+                       "Argument " + std::to_string(i) + ": " + id->name);
+        } else {
+            emitComment("WARNING: Undefined variable " + varFQDN +
+                        " - using 0");
+            emitAssign(reg, Operand::imm(0));
+        }
+    }
+}
+
+bool CodeGenerator::usesRegisterCalls(const std::string &functionLabel) const {
+    return options.registerCalls && functionLabel != "global::main";
+}
+
+bool CodeGenerator::containsCall(const Expression *expr) {
+    return anySubexpression(expr, [](const Expression *node) {
+        return node->nodeType == NodeType::FUNCTION_CALL ||
+               node->nodeType == NodeType::SYSCALL_EXPRESSION;
+    });
+}
+
+bool CodeGenerator::anySubexpression(
+    const Expression *expr,
+    const std::function<bool(const Expression *)> &predicate) {
+    if (expr == nullptr)
+        return false;
+    if (predicate(expr))
+        return true;
+
+    auto any = [&](const Expression *child) {
+        return anySubexpression(child, predicate);
+    };
+    switch (expr->nodeType) {
+    case NodeType::BINARY_EXPRESSION: {
+        const auto *binExpr = static_cast<const BinaryExpression *>(expr);
+        return any(binExpr->left.get()) || any(binExpr->right.get());
+    }
+    case NodeType::UNARY_EXPRESSION:
+        return any(static_cast<const UnaryExpression *>(expr)->operand.get());
+    case NodeType::TYPE_CAST:
+        return any(static_cast<const TypeCast *>(expr)->expression.get());
+    case NodeType::ARRAY_ACCESS: {
+        const auto *access = static_cast<const ArrayAccess *>(expr);
+        return any(access->array.get()) || any(access->index.get());
+    }
+    case NodeType::MEMBER_ACCESS:
+        return any(static_cast<const MemberAccess *>(expr)->object.get());
+    case NodeType::ARRAY_ALLOCATION:
+        return any(static_cast<const ArrayAllocation *>(expr)->size.get());
+    case NodeType::LAYOUT_INITIALIZATION:
+        return std::ranges::any_of(
+            static_cast<const LayoutInitialization *>(expr)->values,
+            [&](const auto &value) { return any(value.get()); });
+    case NodeType::FUNCTION_CALL:
+        return std::ranges::any_of(
+            static_cast<const FunctionCall *>(expr)->arguments,
+            [&](const auto &argument) { return any(argument.get()); });
+    case NodeType::SYSCALL_EXPRESSION:
+        return std::ranges::any_of(
+            static_cast<const SyscallExpression *>(expr)->arguments,
+            [&](const auto &argument) { return any(argument.get()); });
+    default:
+        return false;
+    }
+}
+
+void CodeGenerator::generateInlineCall(const FunctionCall *funcCall,
+                                       const FunctionDeclaration *funcDecl) {
+    emitComment("Inlined call: " + funcCall->functionName);
+
+    // Arguments are evaluated in the caller's scope, exactly like a call
+    for (int i = static_cast<int>(funcCall->arguments.size()) - 1; i >= 0;
+         i--) {
+        generateExpression(funcCall->arguments[i].get());
+    }
+
+    // The body sees its own scope and the globals, as in the callee, not
+    // the caller's locals. Parameters and locals get fresh cells above the
+    // caller's variables.
+    std::vector<std::unique_ptr<Scope>> callerSymbolScopes;
+    if (semanticAnalyzer != nullptr) {
+        auto &symbolTable = semanticAnalyzer->getSymbolTable();
+        callerSymbolScopes = symbolTable.hideLocalScopes();
+        symbolTable.pushScope("function_" + funcDecl->name);
+    }
+    MemoryManager::HiddenScopes callerScopes = memoryManager.hideLocalScopes();
+    memoryManager.pushScope("inline_" + funcDecl->name);
+
+    for (const auto &param : funcDecl->parameters) {
+        std::string paramFQDN = getVariableFQDN(param->name);
+        int address = memoryManager.allocateMemory(paramFQDN);
+        scalarCells.insert(address);
+        popFromStack("Get parameter " + param->name);
+        emitAssign(Operand::mem(address), a0, "Store parameter " + param->name);
+    }
+
+    // Every "ret" leaves its value on the stack and jumps to the end label
+    const int bodyStackDepth = stackDepth;
+    const std::string endLabel = labelGenerator.generateLabel("inline_end");
+    inlineReturnLabels.push_back(endLabel);
+    generateStatement(funcDecl->body.get());
+    inlineReturnLabels.pop_back();
+
+    const auto &statements = funcDecl->body->statements;
+    if (statements.empty() ||
+        statements.back()->nodeType != NodeType::RETURN_STATEMENT) {
+        emitAssign(a0, Operand::imm(0));
+        pushToStack("Default return value");
+    }
+    emitLabel(endLabel);
+    stackDepth = bodyStackDepth + 1;
+
+    memoryManager.popScope();
+    memoryManager.restoreLocalScopes(std::move(callerScopes));
+    if (semanticAnalyzer != nullptr) {
+        auto &symbolTable = semanticAnalyzer->getSymbolTable();
+        symbolTable.popScope();
+        symbolTable.restoreLocalScopes(std::move(callerSymbolScopes));
+    }
+}
+
+// Size of a function body in AST nodes, or -1 if it must not be inlined:
+// calls (which also rules out recursion) and layout handling stay out-of-line
+int CodeGenerator::getInlineCost(const ASTNode *node) {
+    if (node == nullptr)
+        return 0;
+
+    auto sum = [](std::initializer_list<const ASTNode *> children) {
+        int cost = 1;
+        for (const auto *child : children) {
+            const int childCost = getInlineCost(child);
+            if (childCost < 0)
+                return -1;
+            cost += childCost;
+        }
+        return cost;
+    };
+    auto sumAll = [](const auto &children) {
+        int cost = 1;
+        for (const auto &child : children) {
+            const int childCost = getInlineCost(child.get());
+            if (childCost < 0)
+                return -1;
+            cost += childCost;
+        }
+        return cost;
+    };
+
+    switch (node->nodeType) {
+    case NodeType::LITERAL:
+    case NodeType::STRING_LITERAL:
+    case NodeType::IDENTIFIER:
+        return 1;
+    case NodeType::BINARY_EXPRESSION: {
+        const auto *binExpr = static_cast<const BinaryExpression *>(node);
+        return sum({binExpr->left.get(), binExpr->right.get()});
+    }
+    case NodeType::UNARY_EXPRESSION:
+        return sum({static_cast<const UnaryExpression *>(node)->operand.get()});
+    case NodeType::TYPE_CAST:
+        return sum({static_cast<const TypeCast *>(node)->expression.get()});
+    case NodeType::ARRAY_ACCESS: {
+        const auto *access = static_cast<const ArrayAccess *>(node);
+        return sum({access->array.get(), access->index.get()});
+    }
+    case NodeType::ARRAY_ALLOCATION:
+        return sum({static_cast<const ArrayAllocation *>(node)->size.get()});
+    case NodeType::SYSCALL_EXPRESSION:
+        return sumAll(static_cast<const SyscallExpression *>(node)->arguments);
+    case NodeType::VARIABLE_DECLARATION: {
+        const auto *varDecl = static_cast<const VariableDeclaration *>(node);
+        if (varDecl->type->nodeType == NodeType::LAYOUT_TYPE)
+            return -1;
+        return sum({varDecl->initializer.get()});
+    }
+    case NodeType::ASSIGNMENT: {
+        const auto *assignment = static_cast<const Assignment *>(node);
+        return sum({assignment->target.get(), assignment->value.get()});
+    }
+    case NodeType::EXPRESSION_STATEMENT:
+        return sum(
+            {static_cast<const ExpressionStatement *>(node)->expression.get()});
+    case NodeType::RETURN_STATEMENT:
+        return sum({static_cast<const ReturnStatement *>(node)->value.get()});
+    case NodeType::IF_STATEMENT: {
+        const auto *ifStmt = static_cast<const IfStatement *>(node);
+        return sum({ifStmt->condition.get(), ifStmt->thenStatement.get(),
+                    ifStmt->elseStatement.get()});
+    }
+    case NodeType::WHILE_STATEMENT: {
+        const auto *whileStmt = static_cast<const WhileStatement *>(node);
+        return sum({whileStmt->condition.get(), whileStmt->body.get()});
+    }
+    case NodeType::BLOCK_STATEMENT:
+        return sumAll(static_cast<const BlockStatement *>(node)->statements);
+    default:
+        return -1;
+    }
+}
+
+// Address of a member of a layout variable that owns its cells (directly
+// or through nested layout members), known at compile time. memberLayout
+// receives the member's layout when it is one itself.
+std::optional<int>
+CodeGenerator::getStaticMemberAddress(const MemberAccess *memberAccess,
+                                      std::string &memberLayout) {
+    int objectAddress = 0;
+    std::string layoutFQDN;
+    if (memberAccess->object->nodeType == NodeType::IDENTIFIER) {
+        std::string objFQDN = getVariableFQDN(
+            static_cast<const Identifier *>(memberAccess->object.get())->name);
+        if (!layoutValueVariables.contains(objFQDN))
+            return std::nullopt;
+        objectAddress = memoryManager.getVariableAddress(objFQDN);
+        layoutFQDN = getVariableLayoutType(objFQDN);
+    } else if (memberAccess->object->nodeType == NodeType::MEMBER_ACCESS) {
+        auto nested = getStaticMemberAddress(
+            static_cast<const MemberAccess *>(memberAccess->object.get()),
+            layoutFQDN);
+        if (!nested || layoutFQDN.empty())
+            return std::nullopt;
+        objectAddress = *nested;
+    } else {
+        return std::nullopt;
+    }
+
+    Symbol *layoutSymbol =
+        semanticAnalyzer->getSymbolTable().findSymbol(layoutFQDN);
+    if (layoutSymbol == nullptr ||
+        layoutSymbol->symbolKind != SymbolKind::LAYOUT)
+        return std::nullopt;
+    int offset = 0;
+    try {
+        offset = memoryManager.getLayoutMemberOffset(layoutFQDN,
+                                                     memberAccess->memberName);
+    } catch (const std::exception &) {
+        return std::nullopt;
+    }
+
+    memberLayout.clear();
+    const auto *layoutType =
+        static_cast<const LayoutSemanticType *>(layoutSymbol->type.get());
+    for (const auto &member : layoutType->members) {
+        if (member->name == memberAccess->memberName &&
+            member->type->isLayout()) {
+            memberLayout =
+                static_cast<const LayoutSemanticType *>(member->type.get())
+                    ->layoutName;
+        }
+    }
+    return objectAddress + offset;
+}
+
+// Update member access to use FQDNs
+void CodeGenerator::generateMemberAccess(const MemberAccess *memberAccess) {
+    std::string memberLayout;
+    if (auto address = getStaticMemberAddress(memberAccess, memberLayout)) {
+        const std::string description =
+            memberAccess->object->toString() + "." + memberAccess->memberName;
+        if (memberLayout.empty()) {
+            emitAssign(a0, Operand::mem(*address), "Load " + description);
+            pushToStack(" member value");
+        } else {
+            emitAssign(a0, Operand::imm(*address), "Address of " + description);
+            pushToStack(" layout member address");
+        }
+        return;
+    }
+
+    // Determine layout type BEFORE generating the object expression
+    std::string objFQDN;
+    std::string layoutFQDN;
+    
+    if (memberAccess->object->nodeType == NodeType::IDENTIFIER) {
+        const auto *objId =
+            static_cast<const Identifier *>(memberAccess->object.get());
+        objFQDN = getVariableFQDN(objId->name);
+        layoutFQDN = getVariableLayoutType(objFQDN);
+        emitComment("Member of " + objFQDN + " (layout " + layoutFQDN + ")");
+    } else if (memberAccess->object->nodeType == NodeType::ARRAY_ACCESS) {
+        // Handle array access - get the array variable and its element type
+        const auto *arrayAccess = static_cast<const ArrayAccess *>(memberAccess->object.get());
+        
+        if (arrayAccess->array->nodeType == NodeType::IDENTIFIER) {
+            const auto *arrayId = static_cast<const Identifier *>(arrayAccess->array.get());
+            std::string arrayFQDN = getVariableFQDN(arrayId->name);
+            
+            // Find the array's element type (which should be a layout)
+            Symbol *arraySymbol = semanticAnalyzer->getSymbolTable().findSymbolByFQDN(arrayFQDN);
+            if (arraySymbol && arraySymbol->type && arraySymbol->type->isPointer()) {
+                const auto *ptrType = static_cast<const PointerSemanticType *>(arraySymbol->type.get());
+                if (ptrType->pointsTo && ptrType->pointsTo->isLayout()) {
+                    const auto *layoutType = static_cast<const LayoutSemanticType *>(ptrType->pointsTo.get());
+                    layoutFQDN = layoutType->layoutName;
+                    objFQDN = arrayFQDN + "[" + arrayAccess->index->toString() + "]";
+                    emitComment("DEBUG: Array element has layout type " + layoutFQDN);
+                }
+            }
+        }
+    } else if (memberAccess->object->nodeType == NodeType::MEMBER_ACCESS) {
+        // Handle nested member access like n.tuple.right
+        const auto *nestedMemberAccess = static_cast<const MemberAccess *>(memberAccess->object.get());
+        
+        // Get the layout type by tracing through the chain
+        if (nestedMemberAccess->object->nodeType == NodeType::IDENTIFIER) {
+            const auto *baseId = static_cast<const Identifier *>(nestedMemberAccess->object.get());
+            std::string baseFQDN = getVariableFQDN(baseId->name);
+            std::string baseLayoutFQDN = getVariableLayoutType(baseFQDN);
+            
+            if (!baseLayoutFQDN.empty()) {
+                // Find the type of the nested member
+                Symbol *baseLayoutSymbol = semanticAnalyzer->getSymbolTable().findSymbol(baseLayoutFQDN);
+                if (baseLayoutSymbol && baseLayoutSymbol->symbolKind == SymbolKind::LAYOUT) {
+                    const auto *baseLayoutType = static_cast<const LayoutSemanticType *>(baseLayoutSymbol->type.get());
+                    for (const auto &member : baseLayoutType->members) {
+                        if (member->name == nestedMemberAccess->memberName) {
+                            if (member->type->isLayout()) {
+                                const auto *memberLayoutType = static_cast<const LayoutSemanticType *>(member->type.get());
+                                layoutFQDN = memberLayoutType->layoutName;
+                                objFQDN = baseId->name + "." + nestedMemberAccess->memberName;
+                                emitComment("DEBUG: Chained member access: " + objFQDN + " has layout type " + layoutFQDN);
+                            } else {
+                                emitComment("DEBUG: Member " + nestedMemberAccess->memberName + " is not a layout type");
+                                objFQDN = baseId->name + "." + nestedMemberAccess->memberName;
+                            }
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+    } else if (memberAccess->object->nodeType == NodeType::UNARY_EXPRESSION) {
+        // Handle dereference operations like (<-n.tuple).right
+        const auto *unaryExpr = static_cast<const UnaryExpression *>(memberAccess->object.get());
+        
+        if (unaryExpr->operator_ == TokenType::DEREFERENCE) {
+            emitComment("DEBUG: Handling dereference in member access");
+            
+            // The operand of dereference should give us a pointer to a layout
+            if (unaryExpr->operand->nodeType == NodeType::MEMBER_ACCESS) {
+                // Case: (<-b.ptr).value where b.ptr is a pointer to layout
+                const auto *ptrMemberAccess = static_cast<const MemberAccess *>(unaryExpr->operand.get());
+                
+                if (ptrMemberAccess->object->nodeType == NodeType::IDENTIFIER) {
+                    const auto *baseId = static_cast<const Identifier *>(ptrMemberAccess->object.get());
+                    std::string baseFQDN = getVariableFQDN(baseId->name);
+                    std::string baseLayoutFQDN = getVariableLayoutType(baseFQDN);
+                    
+                    emitComment("DEBUG: Analyzing dereference of member access " + baseId->name + "." + ptrMemberAccess->memberName);
+                    emitComment("DEBUG: Base object " + baseId->name + " has layout type " + baseLayoutFQDN);
+                    
+                    if (!baseLayoutFQDN.empty()) {
                         // Find the type of the pointer member
                         Symbol *baseLayoutSymbol = semanticAnalyzer->getSymbolTable().findSymbol(baseLayoutFQDN);
                         if (baseLayoutSymbol && baseLayoutSymbol->symbolKind == SymbolKind::LAYOUT) {
@@ -1366,8 +2338,8 @@ void CodeGenerator::generateMemberAccess(const MemberAccess *memberAccess) {
 
     // Add total offset to base address
     popFromStack("Get base address");
-    emit("a0 := a0 + " + std::to_string(offset) +
-         " // Add total member offset");
+    emitBinary(a0, a0, AlphaOperator::ADD, Operand::imm(offset),
+               "Add total member offset");
     
     // Check if this member is itself a layout type
     bool memberIsLayout = false;
@@ -1393,7 +2365,7 @@ void CodeGenerator::generateMemberAccess(const MemberAccess *memberAccess) {
         pushToStack(" layout member address");
     } else {
         // For primitive members, load the value
-        emit("a0 := p(a0) // Load member value");
+        emitAssign(a0, Operand::indirect(0), "Load member value");
         pushToStack(" member value");
     }
 }
@@ -1408,51 +2380,40 @@ void CodeGenerator::generateArrayAccess(const ArrayAccess *arrayAccess) {
     generateExpression(arrayAccess->index.get());
 
     // Determine the element size based on the array's element type
-    int elementSize = 1; // Default for basic types
-    std::string arrayFQDN;
-    
-    // Get the array variable's FQDN to determine its element type
-    if (arrayAccess->array->nodeType == NodeType::IDENTIFIER) {
-        const auto *arrayId = static_cast<const Identifier *>(arrayAccess->array.get());
-        arrayFQDN = getVariableFQDN(arrayId->name);
-        
-        // Find the array's type to determine element size
-        Symbol *arraySymbol = semanticAnalyzer->getSymbolTable().findSymbolByFQDN(arrayFQDN);
-        if (arraySymbol && arraySymbol->type && arraySymbol->type->isPointer()) {
-            const auto *ptrType = static_cast<const PointerSemanticType *>(arraySymbol->type.get());
-            if (ptrType->pointsTo && ptrType->pointsTo->isLayout()) {
-                const auto *layoutType = static_cast<const LayoutSemanticType *>(ptrType->pointsTo.get());
-                elementSize = calculateLayoutSize(layoutType->layoutName);
-                emitComment("DEBUG: Array access for layout type " + layoutType->layoutName + 
-                           " with element size " + std::to_string(elementSize));
-            }
-        }
+    int elementSize = getArrayElementSize(arrayAccess);
+    const bool layoutElements = !getArrayElementLayout(arrayAccess).empty();
+    if (layoutElements) {
+        emitComment("Layout elements of " + std::to_string(elementSize) +
+                    " cells");
     }
 
     // Pop index and array address, calculate address
     popFromStack("Get index");
-    emit("a1 := a0 // Store index in a1");
+    emitAssign(a1, a0, "Store index in a1");
     popFromStack("Get array base address");
     
     if (elementSize > 1) {
         // For layout types, multiply index by element size
-        emit("a2 := " + std::to_string(elementSize) + " // Element size");
-        emit("a1 := a1 * a2 // Calculate offset (index * element_size)");
-        emit("a0 := a0 + a1 // Calculate element address (base + offset)");
+        emitAssign(a2, Operand::imm(elementSize), "Element size");
+        emitBinary(a1, a1, AlphaOperator::MUL, a2,
+                   "Calculate offset (index * element_size)");
+        emitBinary(a0, a0, AlphaOperator::ADD, a1,
+                   "Calculate element address (base + offset)");
         emitComment("DEBUG: Layout array access: base + (index * " + std::to_string(elementSize) + ")");
     } else {
         // For basic types, simple addition
-        emit("a0 := a0 + a1 // Calculate element address (base + index)");
+        emitBinary(a0, a0, AlphaOperator::ADD, a1,
+                   "Calculate element address (base + index)");
     }
     
     // For layout types, we return the address (not the value)
     // For basic types, we load the value
-    if (elementSize > 1) {
+    if (layoutElements) {
         // Return the address of the layout element (no dereference)
         pushToStack(" layout element address");
     } else {
         // Load the value for basic types
-        emit("a0 := p(a0) // Load array element");
+        emitAssign(a0, Operand::indirect(0), "Load array element");
         pushToStack(" element value");
     }
 }
@@ -1465,7 +2426,7 @@ void CodeGenerator::generateArrayAllocation(const ArrayAllocation *arrayAlloc) {
 
     // Pop size to register
     popFromStack("Get array size");
-    emit("a1 := a0 // Store size in a1");
+    emitAssign(a1, a0, "Store size in a1");
 
     // Calculate the size of each element
     int elementSize = 1; // Default for basic types
@@ -1479,12 +2440,11 @@ void CodeGenerator::generateArrayAllocation(const ArrayAllocation *arrayAlloc) {
         emitComment("DEBUG: Array of layout type " + elementLayoutFQDN + " with element size " + std::to_string(elementSize));
     }
 
-    // For now, allocate array at compile time with a fixed size if iter's a
-    // literal
-    if (arrayAlloc->size->nodeType == NodeType::LITERAL) {
-        const auto *sizeLit =
-            static_cast<const Literal *>(arrayAlloc->size.get());
-        int arraySize = std::stoi(sizeLit->value);
+    // Allocate array at compile time with a fixed size if the size is a
+    // constant expression
+    auto constantSize = tryFoldConstant(arrayAlloc->size.get());
+    if (constantSize && *constantSize >= 0 && *constantSize <= INT32_MAX) {
+        int arraySize = static_cast<int>(*constantSize);
 
         // Calculate total memory needed: array size * element size
         int totalMemoryNeeded = arraySize * elementSize;
@@ -1493,80 +2453,1210 @@ void CodeGenerator::generateArrayAllocation(const ArrayAllocation *arrayAlloc) {
                    " cells, total " + std::to_string(totalMemoryNeeded) + " cells");
 
         // Allocate contiguous memory block for the array
-        int baseAddress = memoryManager.allocateArray(totalMemoryNeeded);
-
-        emit("a0 := " + std::to_string(baseAddress) +
-             " // Base address of allocated array");
+        int baseAddress = allocateStaticData(totalMemoryNeeded);
 
         // Initialize array elements
-        if (!elementLayoutFQDN.empty()) {
-            // For layout types, initialize each element properly
-            for (int i = 0; i < arraySize; i++) {
-                int elementBaseAddress = baseAddress + (i * elementSize);
-                emitComment("DEBUG: Initializing layout element " + std::to_string(i) + 
-                           " at address " + std::to_string(elementBaseAddress));
-                
-                // Initialize layout members to 0
-                for (int j = 0; j < elementSize; j++) {
-                    emit("p(" + std::to_string(elementBaseAddress + j) +
-                         ") := 0 // Initialize layout member " + std::to_string(j));
-                }
+        if (filledAllocations.contains(arrayAlloc)) {
+            emitComment("Elements are all written before they are read");
+        } else {
+            generateBlockFill(baseAddress, totalMemoryNeeded, 0);
+        }
+
+        emitAssign(a0, Operand::imm(baseAddress),
+                   "Base address of allocated array");
+    } else {
+        // Dynamic allocation: p(0) holds the highest address in use (main
+        // seeds it with the end of static memory), so the array takes the
+        // cells right above it and moves the mark. Those cells have never
+        // been used and are still zero.
+        if (elementSize != 1) {
+            emitBinary(a1, a1, AlphaOperator::MUL, Operand::imm(elementSize),
+                       "Cells needed");
+        }
+        emitAssign(a0, Operand::mem(0), "Highest address in use");
+        emitBinary(a1, a0, AlphaOperator::ADD, a1);
+        emitAssign(Operand::mem(0), a1, "Claim the array's cells");
+        emitBinary(a0, a0, AlphaOperator::ADD, Operand::imm(1),
+                   "Base address of allocated array (dynamic)");
+    }
+
+    pushToStack(" array base address");
+}
+
+// Block intrinsics. Up to blockUnrollLimit cells are handled one by one;
+// larger blocks run a loop with a1 (and a2) walking the cells.
+
+// Stores `value` into `size` cells from `destination`
+void CodeGenerator::generateBlockFill(int destination, int size,
+                                      int64_t value) {
+    const Operand fillValue = Operand::imm(value);
+    if (size <= options.blockUnrollLimit) {
+        for (int i = 0; i < size; ++i) {
+            emitAssign(Operand::mem(destination + i), fillValue,
+                       "Fill cell " + std::to_string(i));
+        }
+        return;
+    }
+
+    const std::string loopLabel = labelGenerator.generateLabel("fill");
+    emitAssign(a1, Operand::imm(destination),
+               "Fill " + std::to_string(size) + " cells");
+    emitLabel(loopLabel);
+    emitAssign(Operand::indirect(1), fillValue);
+    emitBinary(a1, a1, AlphaOperator::ADD, Operand::imm(1));
+    emitConditionalJump(a1, AlphaOperator::LT,
+                        Operand::imm(destination + size), loopLabel);
+}
+
+// Copies `size` cells from the address in a0 to `destination`
+void CodeGenerator::generateBlockCopy(int destination, int size) {
+    if (size <= options.blockUnrollLimit) {
+        for (int i = 0; i < size; ++i) {
+            if (i == 0) {
+                emitAssign(a2, Operand::indirect(0), "Load cell 0");
+            } else {
+                emitBinary(a1, a0, AlphaOperator::ADD, Operand::imm(i));
+                emitAssign(a2, Operand::indirect(1),
+                           "Load cell " + std::to_string(i));
             }
+            emitAssign(Operand::mem(destination + i), a2);
+        }
+        return;
+    }
+
+    const std::string loopLabel = labelGenerator.generateLabel("copy");
+    emitAssign(a1, a0, "Copy " + std::to_string(size) + " cells");
+    emitAssign(a2, Operand::imm(destination));
+    emitLabel(loopLabel);
+    emitAssign(a3, Operand::indirect(1));
+    emitAssign(Operand::indirect(2), a3);
+    emitBinary(a1, a1, AlphaOperator::ADD, Operand::imm(1));
+    emitBinary(a2, a2, AlphaOperator::ADD, Operand::imm(1));
+    emitConditionalJump(a2, AlphaOperator::LT,
+                        Operand::imm(destination + size), loopLabel);
+}
+
+// ============================================================================
+// Utility Methods
+// ============================================================================
+
+// Stack operation for an arithmetic operator; bitwise operators are lowered
+// separately and have none
+AlphaOperator CodeGenerator::getOperatorInstruction(TokenType op) {
+    switch (op) {
+    case TokenType::PLUS:
+        return AlphaOperator::ADD;
+    case TokenType::MINUS:
+        return AlphaOperator::SUB;
+    case TokenType::MULTIPLY:
+        return AlphaOperator::MUL;
+    case TokenType::DIVIDE:
+        return AlphaOperator::DIV;
+    case TokenType::MODULO:
+        return AlphaOperator::MOD;
+    default:
+        return AlphaOperator::NONE;
+    }
+}
+
+bool CodeGenerator::isComparisonOperator(TokenType op) {
+    return op == TokenType::EQUAL || op == TokenType::NOT_EQUAL ||
+           op == TokenType::LESS_THAN || op == TokenType::LESS_EQUAL ||
+           op == TokenType::GREATER_THAN || op == TokenType::GREATER_EQUAL;
+}
+
+AlphaOperator CodeGenerator::getComparisonOperator(TokenType op) {
+    switch (op) {
+    case TokenType::EQUAL:
+        return AlphaOperator::EQ;
+    case TokenType::NOT_EQUAL:
+        return AlphaOperator::NE;
+    case TokenType::LESS_THAN:
+        return AlphaOperator::LT;
+    case TokenType::LESS_EQUAL:
+        return AlphaOperator::LE;
+    case TokenType::GREATER_THAN:
+        return AlphaOperator::GT;
+    case TokenType::GREATER_EQUAL:
+        return AlphaOperator::GE;
+    default:
+        throw CodeGeneratorError("Not a comparison operator");
+    }
+}
+
+TokenType CodeGenerator::invertComparison(TokenType op) {
+    switch (op) {
+    case TokenType::EQUAL:
+        return TokenType::NOT_EQUAL;
+    case TokenType::NOT_EQUAL:
+        return TokenType::EQUAL;
+    case TokenType::LESS_THAN:
+        return TokenType::GREATER_EQUAL;
+    case TokenType::LESS_EQUAL:
+        return TokenType::GREATER_THAN;
+    case TokenType::GREATER_THAN:
+        return TokenType::LESS_EQUAL;
+    case TokenType::GREATER_EQUAL:
+        return TokenType::LESS_THAN;
+    default:
+        throw CodeGeneratorError("Not a comparison operator");
+    }
+}
+
+TokenType CodeGenerator::swapComparison(TokenType op) {
+    switch (op) {
+    case TokenType::LESS_THAN:
+        return TokenType::GREATER_THAN;
+    case TokenType::LESS_EQUAL:
+        return TokenType::GREATER_EQUAL;
+    case TokenType::GREATER_THAN:
+        return TokenType::LESS_THAN;
+    case TokenType::GREATER_EQUAL:
+        return TokenType::LESS_EQUAL;
+    default:
+        return op; // == and != are symmetric
+    }
+}
+
+// ============================================================================
+// Constant Folding
+// ============================================================================
+
+std::optional<int64_t> CodeGenerator::tryFoldConstant(const Expression *expr) {
+    switch (expr->nodeType) {
+    case NodeType::LITERAL: {
+        const auto *literal = static_cast<const Literal *>(expr);
+        if (literal->literalType == TokenType::CHARACTER) {
+            if (literal->value.empty())
+                return 0;
+            return static_cast<unsigned char>(literal->value[0]);
+        }
+        if (literal->literalType != TokenType::INTEGER)
+            return std::nullopt;
+        try {
+            size_t consumed = 0;
+            const int64_t value = std::stoll(literal->value, &consumed);
+            if (consumed != literal->value.size())
+                return std::nullopt;
+            return value;
+        } catch (const std::exception &) {
+            return std::nullopt;
+        }
+    }
+    case NodeType::UNARY_EXPRESSION: {
+        const auto *unExpr = static_cast<const UnaryExpression *>(expr);
+        if (unExpr->operator_ != TokenType::MINUS &&
+            unExpr->operator_ != TokenType::BITWISE_NOT)
+            return std::nullopt;
+        auto operand = tryFoldConstant(unExpr->operand.get());
+        if (!operand)
+            return std::nullopt;
+        // Two's complement wrap-around like the target
+        const auto bits = static_cast<uint64_t>(*operand);
+        return static_cast<int64_t>(
+            unExpr->operator_ == TokenType::MINUS ? 0 - bits : ~bits);
+    }
+    case NodeType::TYPE_CAST: {
+        const auto *typeCast = static_cast<const TypeCast *>(expr);
+        auto value = tryFoldConstant(typeCast->expression.get());
+        if (!value)
+            return std::nullopt;
+        const auto *basicType =
+            dynamic_cast<const BasicType *>(typeCast->targetType.get());
+        if (basicType != nullptr && basicType->baseType == TokenType::CHAR)
+            return *value & 255;
+        if (basicType != nullptr ||
+            typeCast->targetType->nodeType == NodeType::POINTER_TYPE)
+            return value;
+        return std::nullopt;
+    }
+    case NodeType::BINARY_EXPRESSION: {
+        const auto *binExpr = static_cast<const BinaryExpression *>(expr);
+        auto left = tryFoldConstant(binExpr->left.get());
+        if (!left)
+            return std::nullopt;
+
+        // A constant left operand may decide && / || on its own
+        if (binExpr->operator_ == TokenType::LOGICAL_AND && *left == 0)
+            return 0;
+        if (binExpr->operator_ == TokenType::LOGICAL_OR && *left != 0)
+            return 1;
+
+        auto right = tryFoldConstant(binExpr->right.get());
+        if (!right)
+            return std::nullopt;
+
+        const auto a = static_cast<uint64_t>(*left);
+        const auto b = static_cast<uint64_t>(*right);
+        switch (binExpr->operator_) {
+        case TokenType::PLUS:
+            return static_cast<int64_t>(a + b);
+        case TokenType::MINUS:
+            return static_cast<int64_t>(a - b);
+        case TokenType::MULTIPLY:
+            return static_cast<int64_t>(a * b);
+        case TokenType::DIVIDE:
+        case TokenType::MODULO:
+            // Leave traps and overflow to the target
+            if (*right == 0 ||
+                (*left == INT64_MIN && *right == -1))
+                return std::nullopt;
+            return binExpr->operator_ == TokenType::DIVIDE ? *left / *right
+                                                          : *left % *right;
+        case TokenType::BITWISE_AND:
+            return *left & *right;
+        case TokenType::BITWISE_OR:
+            return *left | *right;
+        case TokenType::BITWISE_XOR:
+            return *left ^ *right;
+        case TokenType::LOGICAL_AND:
+        case TokenType::LOGICAL_OR:
+            return *right != 0 ? 1 : 0;
+        case TokenType::EQUAL:
+            return *left == *right ? 1 : 0;
+        case TokenType::NOT_EQUAL:
+            return *left != *right ? 1 : 0;
+        case TokenType::LESS_THAN:
+            return *left < *right ? 1 : 0;
+        case TokenType::LESS_EQUAL:
+            return *left <= *right ? 1 : 0;
+        case TokenType::GREATER_THAN:
+            return *left > *right ? 1 : 0;
+        case TokenType::GREATER_EQUAL:
+            return *left >= *right ? 1 : 0;
+        default:
+            return std::nullopt;
+        }
+    }
+    default:
+        return std::nullopt;
+    }
+}
+
+const Expression *
+CodeGenerator::getIdentityOperand(const BinaryExpression *binExpr) {
+    const Expression *left = binExpr->left.get();
+    const Expression *right = binExpr->right.get();
+    auto isConstant = [](const Expression *expr, int64_t value) {
+        auto folded = tryFoldConstant(expr);
+        return folded && *folded == value;
+    };
+
+    switch (binExpr->operator_) {
+    case TokenType::PLUS:
+    case TokenType::BITWISE_OR:
+    case TokenType::BITWISE_XOR:
+        if (isConstant(right, 0))
+            return left;
+        if (isConstant(left, 0))
+            return right;
+        break;
+    case TokenType::MINUS:
+        if (isConstant(right, 0))
+            return left;
+        break;
+    case TokenType::MULTIPLY:
+        if (isConstant(right, 1))
+            return left;
+        if (isConstant(left, 1))
+            return right;
+        break;
+    case TokenType::DIVIDE:
+        if (isConstant(right, 1))
+            return left;
+        break;
+    case TokenType::BITWISE_AND:
+        if (isConstant(right, -1))
+            return left;
+        if (isConstant(left, -1))
+            return right;
+        break;
+    default:
+        break;
+    }
+    return nullptr;
+}
+
+// ============================================================================
+// Register-Based Expression Evaluation
+// ============================================================================
+
+bool CodeGenerator::isImmediateOperand(const Expression *expr) {
+    return tryFoldConstant(expr).has_value();
+}
+
+int CodeGenerator::getArrayElementSize(const ArrayAccess *arrayAccess) {
+    const std::string layoutName = getArrayElementLayout(arrayAccess);
+    return layoutName.empty() ? 1 : calculateLayoutSize(layoutName);
+}
+
+std::string
+CodeGenerator::getArrayElementLayout(const ArrayAccess *arrayAccess) {
+    if (arrayAccess->array->nodeType != NodeType::IDENTIFIER)
+        return "";
+
+    const auto *arrayId =
+        static_cast<const Identifier *>(arrayAccess->array.get());
+    Symbol *arraySymbol =
+        semanticAnalyzer->getSymbolTable().findSymbolByFQDN(
+            getVariableFQDN(arrayId->name));
+    if (arraySymbol && arraySymbol->type && arraySymbol->type->isPointer()) {
+        const auto *ptrType =
+            static_cast<const PointerSemanticType *>(arraySymbol->type.get());
+        if (ptrType->pointsTo && ptrType->pointsTo->isLayout()) {
+            const auto *layoutType =
+                static_cast<const LayoutSemanticType *>(ptrType->pointsTo.get());
+            return layoutType->layoutName;
+        }
+    }
+    return "";
+}
+
+// Whether an expression's static type is a pointer to a layout; covers the
+// forms layout pointers are written in (variables, members and casts)
+bool CodeGenerator::pointsToLayout(const Expression *expr) {
+    auto isLayoutPointer = [](const SemanticType *type) {
+        return type != nullptr && type->isPointer() &&
+               static_cast<const PointerSemanticType *>(type)->pointsTo &&
+               static_cast<const PointerSemanticType *>(type)
+                   ->pointsTo->isLayout();
+    };
+
+    switch (expr->nodeType) {
+    case NodeType::IDENTIFIER: {
+        Symbol *symbol = semanticAnalyzer->getSymbolTable().findSymbolByFQDN(
+            getVariableFQDN(static_cast<const Identifier *>(expr)->name));
+        return symbol != nullptr && isLayoutPointer(symbol->type.get());
+    }
+    case NodeType::TYPE_CAST: {
+        const Type *target = static_cast<const TypeCast *>(expr)->targetType.get();
+        return target->nodeType == NodeType::POINTER_TYPE &&
+               static_cast<const PointerType *>(target)->pointsTo->nodeType ==
+                   NodeType::LAYOUT_TYPE;
+    }
+    case NodeType::MEMBER_ACCESS: {
+        const auto *memberAccess = static_cast<const MemberAccess *>(expr);
+        if (memberAccess->object->nodeType != NodeType::IDENTIFIER)
+            return false;
+        const std::string layoutFQDN = getVariableLayoutType(getVariableFQDN(
+            static_cast<const Identifier *>(memberAccess->object.get())->name));
+        Symbol *layoutSymbol =
+            semanticAnalyzer->getSymbolTable().findSymbol(layoutFQDN);
+        if (layoutSymbol == nullptr ||
+            layoutSymbol->symbolKind != SymbolKind::LAYOUT)
+            return false;
+        const auto *layoutType =
+            static_cast<const LayoutSemanticType *>(layoutSymbol->type.get());
+        return std::ranges::any_of(layoutType->members, [&](const auto &member) {
+            return member->name == memberAccess->memberName &&
+                   isLayoutPointer(member->type.get());
+        });
+    }
+    default:
+        return false;
+    }
+}
+
+bool CodeGenerator::isRegisterExpression(const Expression *expr) {
+    if (isImmediateOperand(expr))
+        return true;
+
+    switch (expr->nodeType) {
+    case NodeType::LITERAL:
+        return false;
+    case NodeType::IDENTIFIER:
+        return true;
+    case NodeType::UNARY_EXPRESSION: {
+        const auto *unExpr = static_cast<const UnaryExpression *>(expr);
+        return (unExpr->operator_ == TokenType::MINUS ||
+                unExpr->operator_ == TokenType::BITWISE_NOT ||
+                (unExpr->operator_ == TokenType::DEREFERENCE &&
+                 !(options.compactLayouts &&
+                   pointsToLayout(unExpr->operand.get())))) &&
+               isRegisterExpression(unExpr->operand.get());
+    }
+    case NodeType::TYPE_CAST: {
+        const auto *typeCast = static_cast<const TypeCast *>(expr);
+        return (typeCast->targetType->nodeType == NodeType::BASIC_TYPE ||
+                typeCast->targetType->nodeType == NodeType::POINTER_TYPE) &&
+               isRegisterExpression(typeCast->expression.get());
+    }
+    case NodeType::ARRAY_ACCESS: {
+        // Element loads of basic arrays; layout elements yield addresses
+        const auto *arrayAccess = static_cast<const ArrayAccess *>(expr);
+        return arrayAccess->array->nodeType == NodeType::IDENTIFIER &&
+               getArrayElementLayout(arrayAccess).empty() &&
+               isRegisterExpression(arrayAccess->index.get());
+    }
+    case NodeType::BINARY_EXPRESSION: {
+        const auto *binExpr = static_cast<const BinaryExpression *>(expr);
+        if (const Expression *operand = getIdentityOperand(binExpr))
+            return isRegisterExpression(operand);
+        switch (binExpr->operator_) {
+        case TokenType::PLUS:
+        case TokenType::MINUS:
+        case TokenType::MULTIPLY:
+        case TokenType::DIVIDE:
+        case TokenType::MODULO:
+            break;
+        case TokenType::BITWISE_AND:
+        case TokenType::BITWISE_OR:
+        case TokenType::BITWISE_XOR:
+            if (!options.nativeBitwise)
+                return false;
+            break;
+        default:
+            if (!isComparisonOperator(binExpr->operator_))
+                return false;
+            break;
+        }
+        return isRegisterExpression(binExpr->left.get()) &&
+               isRegisterExpression(binExpr->right.get());
+    }
+    case NodeType::MEMBER_ACCESS: {
+        // Members of layout variables sit at fixed cells
+        std::string memberLayout;
+        return getStaticMemberAddress(
+                   static_cast<const MemberAccess *>(expr), memberLayout) &&
+               memberLayout.empty();
+    }
+    default:
+        // Calls, syscalls, allocations, strings, other member access
+        return false;
+    }
+}
+
+// ============================================================================
+// Instruction Selection
+// ============================================================================
+
+// Register expressions are covered with Alpha_TUI instructions by tiling:
+// labelTiles computes bottom-up what each node costs (in instructions) as an
+// immediate, a memory operand or a register, and the generate functions
+// emit the cheapest cover top-down. A binary node becomes one instruction
+// whose operands take any form the instruction accepts (no immediate on the
+// left), so `i = i + 1` is `p(i) := p(i) + 1`.
+
+Operand SelectedOperand::toOperand() const {
+    if (reg < 0)
+        return fixed;
+    return indirect ? Operand::indirect(reg) : Operand::reg(reg);
+}
+
+bool CodeGenerator::isCommutativeOperator(TokenType op) {
+    return op == TokenType::PLUS || op == TokenType::MULTIPLY ||
+           op == TokenType::BITWISE_AND || op == TokenType::BITWISE_OR ||
+           op == TokenType::BITWISE_XOR;
+}
+
+// Casts between integers and pointers and identities (x + 0) produce no
+// code; the selector looks through them
+const Expression *CodeGenerator::skipTransparentNodes(const Expression *expr) {
+    while (true) {
+        if (expr->nodeType == NodeType::TYPE_CAST) {
+            const auto *typeCast = static_cast<const TypeCast *>(expr);
+            const auto *basicType =
+                dynamic_cast<const BasicType *>(typeCast->targetType.get());
+            if (basicType != nullptr && basicType->baseType == TokenType::CHAR)
+                return expr;
+            expr = typeCast->expression.get();
+        } else if (expr->nodeType == NodeType::BINARY_EXPRESSION) {
+            const Expression *operand = getIdentityOperand(
+                static_cast<const BinaryExpression *>(expr));
+            if (operand == nullptr)
+                return expr;
+            expr = operand;
+        } else {
+            return expr;
+        }
+    }
+}
+
+int CodeGenerator::getOperandCost(const Expression *expr, bool allowImmediate) {
+    const TileCosts costs = labelTiles(expr);
+    const int cost = std::min(costs.memory, costs.reg);
+    return allowImmediate ? std::min(cost, costs.immediate) : cost;
+}
+
+// Commutative operators may take their operands in either order; the
+// right one can be an immediate, the left one can not
+bool CodeGenerator::swapsOperands(const BinaryExpression *binExpr) {
+    if (!isCommutativeOperator(binExpr->operator_))
+        return false;
+    const Expression *left = binExpr->left.get();
+    const Expression *right = binExpr->right.get();
+    return getOperandCost(right, false) + getOperandCost(left, true) <
+           getOperandCost(left, false) + getOperandCost(right, true);
+}
+
+TileCosts CodeGenerator::labelTiles(const Expression *expr) {
+    if (auto it = tileCosts.find(expr); it != tileCosts.end())
+        return it->second;
+    const TileCosts costs = computeTileCosts(expr);
+    tileCosts[expr] = costs;
+    return costs;
+}
+
+TileCosts CodeGenerator::computeTileCosts(const Expression *expr) {
+    TileCosts costs;
+    if (tryFoldConstant(expr)) {
+        costs.immediate = 0;
+        costs.reg = 1;
+        return costs;
+    }
+    expr = skipTransparentNodes(expr);
+
+    switch (expr->nodeType) {
+    case NodeType::IDENTIFIER: {
+        const std::string varFQDN =
+            getVariableFQDN(static_cast<const Identifier *>(expr)->name);
+        if (!memoryManager.hasVariable(varFQDN) ||
+            layoutValueVariables.contains(varFQDN))
+            costs.immediate = 0; // 0, or the layout's own address
+        else if (options.memoryOperands)
+            costs.memory = 0;
+        costs.reg = 1;
+        break;
+    }
+    case NodeType::MEMBER_ACCESS:
+        if (options.memoryOperands)
+            costs.memory = 0;
+        costs.reg = 1;
+        break;
+    case NodeType::UNARY_EXPRESSION: {
+        const auto *unExpr = static_cast<const UnaryExpression *>(expr);
+        const Expression *operand = unExpr->operand.get();
+        if (unExpr->operator_ == TokenType::MINUS) {
+            // aN := 0; aN := aN - x
+            costs.reg = 2 + getOperandCost(operand, true);
+        } else if (unExpr->operator_ == TokenType::BITWISE_NOT) {
+            costs.reg = 1 + getOperandCost(operand, false);
+        } else {
+            // p(aN) with the address in aN, or p(n) for a constant address
+            const int address =
+                tryFoldConstant(operand) ? 0 : labelTiles(operand).reg;
+            if (options.memoryOperands)
+                costs.memory = address;
+            costs.reg = address + 1;
+        }
+        break;
+    }
+    case NodeType::TYPE_CAST:
+        // Masking to char, see generateRegisterExpression
+        costs.reg =
+            labelTiles(static_cast<const TypeCast *>(expr)->expression.get())
+                .reg +
+            3;
+        break;
+    case NodeType::ARRAY_ACCESS: {
+        const auto *arrayAccess = static_cast<const ArrayAccess *>(expr);
+        const int address = 1 + getOperandCost(arrayAccess->array.get(), false) +
+                            getOperandCost(arrayAccess->index.get(), true);
+        if (options.memoryOperands)
+            costs.memory = address;
+        costs.reg = address + 1;
+        break;
+    }
+    case NodeType::BINARY_EXPRESSION: {
+        const auto *binExpr = static_cast<const BinaryExpression *>(expr);
+        const Expression *left = binExpr->left.get();
+        const Expression *right = binExpr->right.get();
+        if (swapsOperands(binExpr))
+            std::swap(left, right);
+        const int operands =
+            getOperandCost(left, false) + getOperandCost(right, true);
+        // A comparison branches to set 0 or 1
+        costs.reg =
+            (isComparisonOperator(binExpr->operator_) ? 4 : 1) + operands;
+        break;
+    }
+    default:
+        break;
+    }
+    return costs;
+}
+
+int CodeGenerator::getOperandNeed(const Expression *expr, bool allowImmediate) {
+    const TileCosts costs = labelTiles(expr);
+    if (allowImmediate && costs.immediate <= costs.memory &&
+        costs.immediate <= costs.reg)
+        return 0;
+    if (costs.memory > costs.reg)
+        return getRegisterNeed(expr);
+
+    expr = skipTransparentNodes(expr);
+    switch (expr->nodeType) {
+    case NodeType::UNARY_EXPRESSION: {
+        const Expression *address =
+            static_cast<const UnaryExpression *>(expr)->operand.get();
+        return tryFoldConstant(address) ? 0 : getRegisterNeed(address);
+    }
+    case NodeType::ARRAY_ACCESS: {
+        const auto *arrayAccess = static_cast<const ArrayAccess *>(expr);
+        return std::max(getBinaryRegisterNeed(arrayAccess->array.get(),
+                                              arrayAccess->index.get()),
+                        1);
+    }
+    default:
+        return 0; // p(n)
+    }
+}
+
+int CodeGenerator::getBinaryRegisterNeed(const Expression *left,
+                                         const Expression *right) {
+    // Immediates and p(n) are encoded in the instruction and need no register
+    const int leftNeed = getOperandNeed(left, false);
+    const int rightNeed = getOperandNeed(right, true);
+    if (leftNeed == rightNeed)
+        return leftNeed == 0 ? 0 : leftNeed + 1;
+    return std::max(leftNeed, rightNeed);
+}
+
+int CodeGenerator::getRegisterNeed(const Expression *expr) {
+    if (tryFoldConstant(expr))
+        return 1;
+    expr = skipTransparentNodes(expr);
+
+    switch (expr->nodeType) {
+    case NodeType::UNARY_EXPRESSION: {
+        const auto *unExpr = static_cast<const UnaryExpression *>(expr);
+        const Expression *operand = unExpr->operand.get();
+        // Negation subtracts from a zeroed scratch register
+        if (unExpr->operator_ == TokenType::MINUS)
+            return std::max(getOperandNeed(operand, true), 2);
+        if (unExpr->operator_ == TokenType::BITWISE_NOT)
+            return std::max(getOperandNeed(operand, false), 1);
+        return getRegisterNeed(operand);
+    }
+    case NodeType::TYPE_CAST:
+        return getRegisterNeed(
+            static_cast<const TypeCast *>(expr)->expression.get());
+    case NodeType::ARRAY_ACCESS: {
+        const auto *arrayAccess = static_cast<const ArrayAccess *>(expr);
+        return std::max(getBinaryRegisterNeed(arrayAccess->array.get(),
+                                              arrayAccess->index.get()),
+                        1);
+    }
+    case NodeType::BINARY_EXPRESSION: {
+        const auto *binExpr = static_cast<const BinaryExpression *>(expr);
+        return swapsOperands(binExpr)
+                   ? std::max(getBinaryRegisterNeed(binExpr->right.get(),
+                                                    binExpr->left.get()),
+                              1)
+                   : std::max(getBinaryRegisterNeed(binExpr->left.get(),
+                                                    binExpr->right.get()),
+                              1);
+    }
+    default:
+        return 1;
+    }
+}
+
+void CodeGenerator::releaseOperand(const SelectedOperand &operand) {
+    if (operand.reg >= 0)
+        registerAllocator.deallocateRegister(operand.reg);
+}
+
+// Register for the result of an instruction reading `lhs` and `rhs`: one
+// the operands already occupy (the instruction reads them before it
+// writes), or a new one
+int CodeGenerator::takeResultRegister(const SelectedOperand &lhs,
+                                      const SelectedOperand &rhs) {
+    if (lhs.reg >= 0) {
+        releaseOperand(rhs);
+        return lhs.reg;
+    }
+    if (rhs.reg >= 0)
+        return rhs.reg;
+    return registerAllocator.allocateRegister();
+}
+
+SelectedOperand CodeGenerator::selectOperand(const Expression *expr,
+                                             bool allowImmediate) {
+    const TileCosts costs = labelTiles(expr);
+    if (allowImmediate && costs.immediate <= costs.memory &&
+        costs.immediate <= costs.reg) {
+        if (auto value = tryFoldConstant(expr))
+            return {Operand::imm(*value)};
+        const auto *id =
+            static_cast<const Identifier *>(skipTransparentNodes(expr));
+        const std::string varFQDN = getVariableFQDN(id->name);
+        if (!memoryManager.hasVariable(varFQDN)) {
+            emitComment("WARNING: Undefined variable " + varFQDN +
+                        " - using 0");
+            return {Operand::imm(0)};
+        }
+        return {variableOperand(varFQDN)};
+    }
+    if (costs.memory <= costs.reg)
+        return generateMemoryOperand(expr);
+    return {Operand{}, generateRegisterExpression(expr)};
+}
+
+SelectedOperand CodeGenerator::generateMemoryOperand(const Expression *expr) {
+    expr = skipTransparentNodes(expr);
+    switch (expr->nodeType) {
+    case NodeType::IDENTIFIER:
+        return {variableOperand(getVariableFQDN(
+            static_cast<const Identifier *>(expr)->name))};
+    case NodeType::MEMBER_ACCESS: {
+        std::string memberLayout;
+        return {Operand::mem(*getStaticMemberAddress(
+            static_cast<const MemberAccess *>(expr), memberLayout))};
+    }
+    case NodeType::UNARY_EXPRESSION: {
+        const Expression *address =
+            static_cast<const UnaryExpression *>(expr)->operand.get();
+        if (auto cell = tryFoldConstant(address))
+            return {Operand::mem(*cell)};
+        return {Operand{}, generateRegisterExpression(address), true};
+    }
+    case NodeType::ARRAY_ACCESS: {
+        const auto *arrayAccess = static_cast<const ArrayAccess *>(expr);
+        auto [array, index] = generateRegisterOperands(
+            arrayAccess->array.get(), arrayAccess->index.get());
+        const int reg = takeResultRegister(array, index);
+        emitBinary(Operand::reg(reg), array.toOperand(), AlphaOperator::ADD,
+                   index.toOperand(), "Element address");
+        return {Operand{}, reg, true};
+    }
+    default:
+        throw CodeGeneratorError("Expression is not a memory operand");
+    }
+}
+
+std::pair<SelectedOperand, SelectedOperand>
+CodeGenerator::generateRegisterOperands(const Expression *left,
+                                        const Expression *right) {
+    // Evaluate the subtree needing more registers first
+    const int leftNeed = getOperandNeed(left, false);
+    const int rightNeed = getOperandNeed(right, true);
+    const bool rightFirst = rightNeed > leftNeed;
+    const Expression *second = rightFirst ? left : right;
+
+    SelectedOperand first = selectOperand(rightFirst ? right : left, rightFirst);
+    SelectedOperand last;
+    if (first.reg >= 0 && (rightFirst ? leftNeed : rightNeed) >
+                              registerAllocator.getAvailableRegisterCount()) {
+        // Not enough registers left: park the first result on the stack
+        pushRegisterToStack(first.reg, "Spill");
+        registerAllocator.deallocateRegister(first.reg);
+        last = selectOperand(second, !rightFirst);
+        first.reg = registerAllocator.allocateRegister();
+        popStackToRegister(first.reg, "Reload spill");
+    } else {
+        last = selectOperand(second, !rightFirst);
+    }
+    return rightFirst ? std::pair{last, first} : std::pair{first, last};
+}
+
+int CodeGenerator::generateRegisterExpression(const Expression *expr) {
+    if (auto value = tryFoldConstant(expr)) {
+        const int reg = registerAllocator.allocateRegister();
+        emitAssign(Operand::reg(reg), Operand::imm(*value));
+        return reg;
+    }
+    expr = skipTransparentNodes(expr);
+
+    switch (expr->nodeType) {
+    case NodeType::IDENTIFIER: {
+        const auto *id = static_cast<const Identifier *>(expr);
+        const int reg = registerAllocator.allocateRegister();
+        std::string varFQDN = getVariableFQDN(id->name);
+        if (memoryManager.hasVariable(varFQDN)) {
+            emitAssign(Operand::reg(reg), variableOperand(varFQDN),
+                       "Load " + id->name);
+        } else {
+            emitComment("WARNING: Undefined variable " + varFQDN +
+                        " - using 0");
+            emitAssign(Operand::reg(reg), Operand::imm(0));
+        }
+        return reg;
+    }
+    case NodeType::UNARY_EXPRESSION: {
+        const auto *unExpr = static_cast<const UnaryExpression *>(expr);
+        const Expression *operandExpr = unExpr->operand.get();
+        if (unExpr->operator_ == TokenType::MINUS) {
+            const SelectedOperand operand = selectOperand(operandExpr, true);
+            const int reg = registerAllocator.allocateRegister();
+            emitAssign(Operand::reg(reg), Operand::imm(0));
+            emitBinary(Operand::reg(reg), Operand::reg(reg), AlphaOperator::SUB,
+                       operand.toOperand(), "Negate value");
+            releaseOperand(operand);
+            return reg;
+        }
+        if (unExpr->operator_ == TokenType::BITWISE_NOT) {
+            const SelectedOperand operand = selectOperand(operandExpr, false);
+            const int reg = takeResultRegister(operand, {});
+            emit(Instruction::makeUnary(Operand::reg(reg), AlphaOperator::NOT,
+                                        operand.toOperand()),
+                 "Bitwise NOT");
+            return reg;
+        }
+        if (auto cell = tryFoldConstant(operandExpr)) {
+            const int reg = registerAllocator.allocateRegister();
+            emitAssign(Operand::reg(reg), Operand::mem(*cell),
+                       "Dereference address");
+            return reg;
+        }
+        const int reg = generateRegisterExpression(operandExpr);
+        emitAssign(Operand::reg(reg), Operand::indirect(reg),
+                   "Dereference address");
+        return reg;
+    }
+    case NodeType::TYPE_CAST: {
+        // Keep the low 8 bits, see generateMaskOperation
+        const auto *typeCast = static_cast<const TypeCast *>(expr);
+        const int reg = generateRegisterExpression(typeCast->expression.get());
+        const Operand value = Operand::reg(reg);
+        std::string maskedLabel = labelGenerator.generateLabel("masked");
+        emitBinary(value, value, AlphaOperator::MOD, Operand::imm(256),
+                   "Mask to char");
+        emitConditionalJump(value, AlphaOperator::GE, Operand::imm(0),
+                            maskedLabel);
+        emitBinary(value, value, AlphaOperator::ADD, Operand::imm(256));
+        emitLabel(maskedLabel);
+        return reg;
+    }
+    case NodeType::MEMBER_ACCESS: {
+        const auto *memberAccess = static_cast<const MemberAccess *>(expr);
+        std::string memberLayout;
+        const int reg = registerAllocator.allocateRegister();
+        emitAssign(Operand::reg(reg),
+                   Operand::mem(
+                       *getStaticMemberAddress(memberAccess, memberLayout)),
+                   "Load member " + memberAccess->memberName);
+        return reg;
+    }
+    case NodeType::ARRAY_ACCESS: {
+        const SelectedOperand element = generateMemoryOperand(expr);
+        emitAssign(Operand::reg(element.reg), element.toOperand(),
+                   "Load array element");
+        return element.reg;
+    }
+    case NodeType::BINARY_EXPRESSION: {
+        const auto *binExpr = static_cast<const BinaryExpression *>(expr);
+        const Expression *left = binExpr->left.get();
+        const Expression *right = binExpr->right.get();
+        if (swapsOperands(binExpr))
+            std::swap(left, right);
+        const auto [lhs, rhs] = generateRegisterOperands(left, right);
+        const int reg = takeResultRegister(lhs, rhs);
+        const Operand result = Operand::reg(reg);
+
+        if (isComparisonOperator(binExpr->operator_)) {
+            std::string trueLabel = labelGenerator.generateLabel("true");
+            std::string endLabel = labelGenerator.generateLabel("cmp_end");
+            emitConditionalJump(lhs.toOperand(),
+                                getComparisonOperator(binExpr->operator_),
+                                rhs.toOperand(), trueLabel);
+            emitAssign(result, Operand::imm(0), "Comparison result: false");
+            emitJump(endLabel);
+            emitLabel(trueLabel);
+            emitAssign(result, Operand::imm(1), "Comparison result: true");
+            emitLabel(endLabel);
+        } else {
+            emitBinary(result, lhs.toOperand(),
+                       getArithmeticOperator(binExpr->operator_),
+                       rhs.toOperand());
+        }
+        return reg;
+    }
+    default:
+        throw CodeGeneratorError(
+            "Expression cannot be evaluated in registers");
+    }
+}
+
+AlphaOperator CodeGenerator::getArithmeticOperator(TokenType op) {
+    switch (op) {
+    case TokenType::PLUS:
+        return AlphaOperator::ADD;
+    case TokenType::MINUS:
+        return AlphaOperator::SUB;
+    case TokenType::MULTIPLY:
+        return AlphaOperator::MUL;
+    case TokenType::DIVIDE:
+        return AlphaOperator::DIV;
+    case TokenType::MODULO:
+        return AlphaOperator::MOD;
+    case TokenType::BITWISE_AND:
+        return AlphaOperator::AND;
+    case TokenType::BITWISE_OR:
+        return AlphaOperator::OR;
+    default:
+        return AlphaOperator::XOR;
+    }
+}
+
+bool CodeGenerator::generateSelectedStore(Operand destination,
+                                          const Expression *value,
+                                          const std::string &comment) {
+    if (!options.registerExpressions || !options.memoryOperands ||
+        !isRegisterExpression(value))
+        return false;
+
+    // An arithmetic root writes its result straight into the cell
+    const Expression *root = skipTransparentNodes(value);
+    if (!tryFoldConstant(value) &&
+        root->nodeType == NodeType::BINARY_EXPRESSION &&
+        !isComparisonOperator(
+            static_cast<const BinaryExpression *>(root)->operator_)) {
+        const auto *binExpr = static_cast<const BinaryExpression *>(root);
+        const Expression *left = binExpr->left.get();
+        const Expression *right = binExpr->right.get();
+        if (swapsOperands(binExpr))
+            std::swap(left, right);
+        const auto [lhs, rhs] = generateRegisterOperands(left, right);
+        emitBinary(destination, lhs.toOperand(),
+                   getArithmeticOperator(binExpr->operator_), rhs.toOperand(),
+                   comment);
+        releaseOperand(lhs);
+        releaseOperand(rhs);
+        return true;
+    }
+
+    const SelectedOperand operand = selectOperand(value, true);
+    emitAssign(destination, operand.toOperand(), comment);
+    releaseOperand(operand);
+    return true;
+}
+
+// ============================================================================
+// Bitwise Lowering
+// ============================================================================
+
+// Operators in the order their lookup tables are laid out in memory
+static const TokenType kBitwiseOperators[] = {
+    TokenType::BITWISE_AND, TokenType::BITWISE_OR, TokenType::BITWISE_XOR};
+
+bool CodeGenerator::isBooleanExpression(const Expression *expr) {
+    if (expr->nodeType == NodeType::LITERAL) {
+        const auto *literal = static_cast<const Literal *>(expr);
+        return literal->literalType == TokenType::INTEGER &&
+               (literal->value == "0" || literal->value == "1");
+    }
+    if (expr->nodeType != NodeType::BINARY_EXPRESSION)
+        return false;
+
+    const auto *binExpr = static_cast<const BinaryExpression *>(expr);
+    if (isComparisonOperator(binExpr->operator_) ||
+        binExpr->operator_ == TokenType::LOGICAL_AND ||
+        binExpr->operator_ == TokenType::LOGICAL_OR)
+        return true;
+    if (binExpr->operator_ == TokenType::BITWISE_AND ||
+        binExpr->operator_ == TokenType::BITWISE_OR ||
+        binExpr->operator_ == TokenType::BITWISE_XOR) {
+        return isBooleanExpression(binExpr->left.get()) &&
+               isBooleanExpression(binExpr->right.get());
+    }
+    return false;
+}
+
+// Returns 2^k if expr is the literal 2^k - 1 (1 <= k <= 62), else 0
+static int64_t getLowBitMaskModulus(const Expression *expr) {
+    if (expr->nodeType != NodeType::LITERAL)
+        return 0;
+    const auto *literal = static_cast<const Literal *>(expr);
+    if (literal->literalType != TokenType::INTEGER)
+        return 0;
+
+    int64_t value = 0;
+    try {
+        value = std::stoll(literal->value);
+    } catch (const std::exception &) {
+        return 0;
+    }
+    if (value <= 0 || value >= (int64_t{1} << 62))
+        return 0;
+    const int64_t modulus = value + 1;
+    return (modulus & value) == 0 ? modulus : 0;
+}
+
+void CodeGenerator::generateBitwiseExpression(const BinaryExpression *binExpr) {
+    const TokenType op = binExpr->operator_;
+
+    // x & (2^k - 1) keeps the low k bits: a floored modulo
+    if (op == TokenType::BITWISE_AND && !options.nativeBitwise) {
+        const Expression *value = nullptr;
+        int64_t modulus = getLowBitMaskModulus(binExpr->right.get());
+        if (modulus != 0) {
+            value = binExpr->left.get();
+        } else if ((modulus = getLowBitMaskModulus(binExpr->left.get())) !=
+                   0) {
+            value = binExpr->right.get();
+        }
+        if (value != nullptr) {
+            generateExpression(value);
+            generateMaskOperation(modulus);
+            return;
+        }
+    }
+
+    generateExpression(binExpr->left.get());
+    generateExpression(binExpr->right.get());
+
+    if (options.nativeBitwise) {
+        popFromStack("Get right operand");
+        emitAssign(a1, a0);
+        popFromStack("Get left operand");
+        emitBinary(a0, a0, getArithmeticOperator(op), a1,
+                   "Native bitwise operation");
+        pushToStack(" bitwise operation result");
+        return;
+    }
+
+    // Both operands are 0/1: plain arithmetic gives the same result
+    if (isBooleanExpression(binExpr->left.get()) &&
+        isBooleanExpression(binExpr->right.get())) {
+        if (op == TokenType::BITWISE_AND) {
+            emitStackOperation(AlphaOperator::MUL, "Boolean AND");
+            return;
+        }
+        popFromStack("Get right operand");
+        emitAssign(a1, a0);
+        popFromStack("Get left operand");
+        if (op == TokenType::BITWISE_OR) {
+            emitBinary(a2, a0, AlphaOperator::MUL, a1);
+            emitBinary(a0, a0, AlphaOperator::ADD, a1);
+            emitBinary(a0, a0, AlphaOperator::SUB, a2,
+                       "Boolean OR: a + b - a * b");
         } else {
-            // Simple initialization for basic types
-            for (int i = 0; i < totalMemoryNeeded; i++) {
-                emit("p(" + std::to_string(baseAddress + i) +
-                     ") := 0 // Initialize element " + std::to_string(i));
-            }
+            emitBinary(a0, a0, AlphaOperator::SUB, a1);
+            emitBinary(a0, a0, AlphaOperator::MUL, a0,
+                       "Boolean XOR: (a - b)^2");
         }
-    } else {
-        // Dynamic allocation - for now, use a simple approach
-        // This would need runtime memory management in a complete
-        // implementation
-        int baseAddress =
-            memoryManager.allocateArray(100 * elementSize); // Default max size for now
-        emit("a0 := " + std::to_string(baseAddress) +
-             " // Base address of allocated array (dynamic)");
-        emitComment("Warning: Dynamic array allocation simplified");
+        pushToStack(" boolean operation result");
+        return;
     }
 
-    pushToStack(" array base address");
+    // General case: table-driven runtime routine, result is pushed by it
+    bitwiseRuntimeOperations.insert(op);
+    emit(Instruction::makeJump(InstructionKind::CALL,
+                               getBitwiseRuntimeLabel(op)),
+         "Bitwise operation");
+    stackDepth--;
 }
 
-// ============================================================================
-// Utility Methods
-// ============================================================================
+void CodeGenerator::generateMaskOperation(int64_t modulus) {
+    // Keep the low bits of the value on the stack. Alpha_TUI's % truncates
+    // toward zero, so negative remainders are shifted into range.
+    std::string maskedLabel = labelGenerator.generateLabel("masked");
+    popFromStack("Get value to mask");
+    emitBinary(a0, a0, AlphaOperator::MOD, Operand::imm(modulus),
+               "Mask low bits");
+    emitConditionalJump(a0, AlphaOperator::GE, Operand::imm(0), maskedLabel);
+    emitBinary(a0, a0, AlphaOperator::ADD, Operand::imm(modulus));
+    emitLabel(maskedLabel);
+    pushToStack(" masked value");
+}
 
-std::string CodeGenerator::getOperatorInstruction(TokenType op) {
+std::string CodeGenerator::getBitwiseRuntimeLabel(TokenType op) {
     switch (op) {
-    case TokenType::PLUS:
-        return "stack+";
-    case TokenType::MINUS:
-        return "stack-";
-    case TokenType::MULTIPLY:
-        return "stack*";
-    case TokenType::DIVIDE:
-        return "stack/";
-    case TokenType::MODULO:
-        return "stack%";
     case TokenType::BITWISE_AND:
-        // Special handling for bitwise AND - don't return an instruction
-        return "";
+        return "runtime_bitwise_and";
     case TokenType::BITWISE_OR:
-        // Special handling for bitwise OR - don't return an instruction
-        return "";
+        return "runtime_bitwise_or";
     case TokenType::BITWISE_XOR:
-        // Special handling for bitwise XOR - don't return an instruction
-        return "";
+        return "runtime_bitwise_xor";
     default:
-        return "nop // Unknown operator";
+        throw CodeGeneratorError("Not a bitwise operator");
     }
 }
 
-bool CodeGenerator::isComparisonOperator(TokenType op) {
-    return op == TokenType::EQUAL || op == TokenType::NOT_EQUAL ||
-           op == TokenType::LESS_THAN || op == TokenType::LESS_EQUAL ||
-           op == TokenType::GREATER_THAN || op == TokenType::GREATER_EQUAL;
+std::vector<TokenType> CodeGenerator::getBitwiseRuntimeOperations() const {
+    std::vector<TokenType> operations;
+    for (TokenType op : kBitwiseOperators) {
+        if (bitwiseRuntimeOperations.contains(op))
+            operations.push_back(op);
+    }
+    return operations;
+}
+
+std::vector<Instruction>
+CodeGenerator::generateBitwiseTables(int tableBase) const {
+    // One 16x16 table per operator, indexed by (left nibble * 16 + right
+    // nibble)
+    std::vector<Instruction> tables;
+    int address = tableBase;
+    for (TokenType op : getBitwiseRuntimeOperations()) {
+        tables.push_back(Instruction::makeComment(
+            " Lookup table for " + getBitwiseRuntimeLabel(op)));
+        for (int a = 0; a < 16; ++a) {
+            for (int b = 0; b < 16; ++b) {
+                const int value = op == TokenType::BITWISE_AND  ? (a & b)
+                                  : op == TokenType::BITWISE_OR ? (a | b)
+                                                                : (a ^ b);
+                tables.push_back(Instruction::makeAssign(
+                    Operand::mem(address++), Operand::imm(value)));
+            }
+        }
+    }
+    return tables;
+}
+
+void CodeGenerator::generateBitwiseRuntime(int tableBase) {
+    // Entry points select their table in a5 and share one loop that
+    // combines both operands nibble by nibble (16 nibbles = 64 bits)
+    const Operand a4 = Operand::reg(4);
+    const Operand a5 = Operand::reg(5);
+    const Operand a6 = Operand::reg(6);
+    const Operand a7 = Operand::reg(7);
+    emitBlankLine();
+    emitComment("Runtime: table-driven bitwise operations");
+    int table = tableBase;
+    for (TokenType op : getBitwiseRuntimeOperations()) {
+        emitLabel(getBitwiseRuntimeLabel(op));
+        emitAssign(a5, Operand::imm(table), "Lookup table");
+        emitJump("runtime_bitwise");
+        table += 256;
+    }
+
+    const Operand nibble = Operand::imm(16);
+    emitLabel("runtime_bitwise");
+    emit(Instruction::makePop());
+    emitAssign(a2, a0, "Right operand");
+    emit(Instruction::makePop());
+    emitAssign(a1, a0, "Left operand");
+    emitAssign(a3, Operand::imm(0), "Result");
+    emitAssign(a4, Operand::imm(1), "Place value of the current nibble");
+    emitAssign(a7, nibble, "Nibbles left");
+    emitLabel("runtime_bitwise_loop");
+    emitConditionalJump(a7, AlphaOperator::EQ, Operand::imm(0),
+                        "runtime_bitwise_done");
+    emitConditionalJump(a1, AlphaOperator::NE, Operand::imm(0),
+                        "runtime_bitwise_next");
+    emitConditionalJump(a2, AlphaOperator::EQ, Operand::imm(0),
+                        "runtime_bitwise_done", "Only zero bits left");
+    emitLabel("runtime_bitwise_next");
+    // Floored split: operand = rest * 16 + nibble with 0 <= nibble < 16
+    emitBinary(a0, a1, AlphaOperator::MOD, nibble);
+    emitConditionalJump(a0, AlphaOperator::GE, Operand::imm(0),
+                        "runtime_bitwise_left");
+    emitBinary(a0, a0, AlphaOperator::ADD, nibble);
+    emitLabel("runtime_bitwise_left");
+    emitBinary(a1, a1, AlphaOperator::SUB, a0);
+    emitBinary(a1, a1, AlphaOperator::DIV, nibble);
+    emitBinary(a6, a0, AlphaOperator::MUL, nibble);
+    emitBinary(a0, a2, AlphaOperator::MOD, nibble);
+    emitConditionalJump(a0, AlphaOperator::GE, Operand::imm(0),
+                        "runtime_bitwise_right");
+    emitBinary(a0, a0, AlphaOperator::ADD, nibble);
+    emitLabel("runtime_bitwise_right");
+    emitBinary(a2, a2, AlphaOperator::SUB, a0);
+    emitBinary(a2, a2, AlphaOperator::DIV, nibble);
+    emitBinary(a6, a6, AlphaOperator::ADD, a0);
+    emitBinary(a6, a6, AlphaOperator::ADD, a5);
+    emitAssign(a0, Operand::indirect(6), "Combined nibble");
+    emitBinary(a0, a0, AlphaOperator::MUL, a4);
+    emitBinary(a3, a3, AlphaOperator::ADD, a0);
+    emitBinary(a4, a4, AlphaOperator::MUL, nibble);
+    emitBinary(a7, a7, AlphaOperator::SUB, Operand::imm(1));
+    emitJump("runtime_bitwise_loop");
+    emitLabel("runtime_bitwise_done");
+    emitAssign(a0, a3);
+    emit(Instruction::makePush());
+    emit(Instruction::make(InstructionKind::RETURN));
 }
 
 // ============================================================================
@@ -1603,7 +3693,7 @@ void CodeGenerator::setupLayoutMembers(
         emitComment("DEBUG: Layout is in namespace: " + namespaceName);
     }
 
-    int offset = 1; // 0 = layout base address
+    int offset = layoutHeaderCells();
 
     for (const auto &member : members) {
         emitComment("DEBUG: Layout " + layoutFQDN + " member '" + member->name +
@@ -1629,14 +3719,16 @@ int CodeGenerator::calculateLayoutSize(const std::string &layoutName) {
             semanticAnalyzer->getSymbolTable().findSymbol(layoutName);
         if ((layoutSymbol != nullptr) &&
             layoutSymbol->symbolKind == SymbolKind::LAYOUT) {
+            // Sizes are computed once per layout
+            if (auto known = layoutSizes.find(layoutSymbol->fqdn);
+                known != layoutSizes.end())
+                return known->second;
+
             const auto *layoutType = static_cast<const LayoutSemanticType *>(
                 layoutSymbol->type.get());
             
-            if (layoutType->members.empty())
-                return 1; // Even empty layouts need at least 1 cell for base address
-            
             // Calculate total size by summing member sizes
-            int totalSize = 1; // +1 for the layout base address
+            int totalSize = layoutHeaderCells();
             
             for (const auto &member : layoutType->members) {
                 if (member->type->isLayout()) {
@@ -1649,12 +3741,21 @@ int CodeGenerator::calculateLayoutSize(const std::string &layoutName) {
                 }
             }
             
+            // Even empty layouts need at least 1 cell
+            totalSize = std::max(totalSize, 1);
+            layoutSizes[layoutSymbol->fqdn] = totalSize;
             return totalSize;
         }
     }
     return 1; // Default size if layout not found
 }
 
+// The original layout format keeps each instance's own address in its
+// first cell; the compact one holds only the members
+int CodeGenerator::layoutHeaderCells() const {
+    return options.compactLayouts ? 0 : 1;
+}
+
 // ============================================================================
 // Helper to extract layout name from a Type (handles nested pointers)
 // ============================================================================
@@ -1706,19 +3807,12 @@ void CodeGenerator::generateIfStatement(const IfStatement *ifStmt) {
     std::string elseLabel = labelGenerator.generateLabel("else");
     std::string endLabel = labelGenerator.generateLabel("endif");
 
-    // Generate condition
-    generateExpression(ifStmt->condition.get());
-
-    // Pop condition result to register and compare with 0
-    popFromStack("Get condition result");
-
-    emit("a1 := 0");
-    emit("if a0 == a1 then goto " + elseLabel +
-         " // Jump to else if condition is false");
+    // Jump to else if condition is false
+    generateConditionalJump(ifStmt->condition.get(), elseLabel, false);
 
     // Generate then branch
     generateStatement(ifStmt->thenStatement.get());
-    emit("goto " + endLabel + " // Jump to end");
+    emitJump(endLabel, "Jump to end");
 
     // Generate else branch
     emitLabel(elseLabel);
@@ -1727,7 +3821,7 @@ void CodeGenerator::generateIfStatement(const IfStatement *ifStmt) {
     }
 
     emitLabel(endLabel);
-    emit("");
+    emitBlankLine();
 }
 
 void CodeGenerator::generateWhileStatement(const WhileStatement *whileStmt) {
@@ -1737,27 +3831,38 @@ void CodeGenerator::generateWhileStatement(const WhileStatement *whileStmt) {
     std::string loopLabel = labelGenerator.generateLabel("loop");
     std::string endLabel = labelGenerator.generateLabel("endloop");
 
-    // Add break/continue labels for nested loops
-    breakLabels.push_back(endLabel);
-    continueLabels.push_back(loopLabel);
+    if (!options.rotateLoops) {
+        // Add break/continue labels for nested loops
+        breakLabels.push_back(endLabel);
+        continueLabels.push_back(loopLabel);
 
-    // Loop start
-    emitLabel(loopLabel);
+        // Loop start
+        emitLabel(loopLabel);
 
-    // Generate condition
-    generateExpression(whileStmt->condition.get());
+        // Jump to end if condition is false
+        generateConditionalJump(whileStmt->condition.get(), endLabel, false);
 
-    // Pop condition result to register and compare with 0
-    popFromStack("Get condition result");
-    emit("a1 := 0");
-    emit("if a0 == a1 then goto " + endLabel +
-         " // Jump to end if condition is false");
+        // Generate loop body
+        generateStatement(whileStmt->body.get());
+
+        // Jump back to loop start
+        emitJump(loopLabel, "Jump back to loop start");
+    } else {
+        // Rotated loop: a guard skips the loop once, then the condition at
+        // the bottom jumps back while it holds, so each iteration runs the
+        // test without an extra unconditional jump
+        std::string conditionLabel = labelGenerator.generateLabel("loopcond");
+        breakLabels.push_back(endLabel);
+        continueLabels.push_back(conditionLabel);
+
+        generateConditionalJump(whileStmt->condition.get(), endLabel, false);
 
-    // Generate loop body
-    generateStatement(whileStmt->body.get());
+        emitLabel(loopLabel);
+        generateStatement(whileStmt->body.get());
 
-    // Jump back to loop start
-    emit("goto " + loopLabel + " // Jump back to loop start");
+        emitLabel(conditionLabel);
+        generateConditionalJump(whileStmt->condition.get(), loopLabel, true);
+    }
 
     // Loop end
     emitLabel(endLabel);
@@ -1766,38 +3871,71 @@ void CodeGenerator::generateWhileStatement(const WhileStatement *whileStmt) {
     breakLabels.pop_back();
     continueLabels.pop_back();
 
-    emit("");
+    emitBlankLine();
 }
 
 void CodeGenerator::generateReturnStatement(const ReturnStatement *retStmt) {
     emitComment("Return statement");
 
+    if (retStmt->value &&
+        retStmt->value->nodeType == NodeType::FUNCTION_CALL &&
+        tryGenerateTailCall(
+            static_cast<const FunctionCall *>(retStmt->value.get()))) {
+        return;
+    }
+
     if (retStmt->value) {
         // Generate return value
         generateExpression(retStmt->value.get());
         // Value is already on stack, ready for return
     } else {
         // No return value, push default (0)
-        emit("a0 := 0");
+        emitAssign(a0, Operand::imm(0));
         pushToStack("Default return value");
     }
 
-    emit("return // Return from function");
+    if (!inlineReturnLabels.empty()) {
+        // The value belongs to the code after the inlined body
+        emitJump(inlineReturnLabels.back(), "Leave inlined body");
+        stackDepth--;
+        return;
+    }
+
+    if (usesRegisterCalls(currentFunctionLabel)) {
+        popFromStack("Return value in a0");
+    }
+
+    emit(Instruction::make(InstructionKind::RETURN), "Return from function");
 }
 
 void CodeGenerator::generateFunctionDeclaration(
     const FunctionDeclaration *funcDecl) {
+    // Generate into a separate buffer; generate() links it back in if the
+    // function is reachable
+    FunctionCode function;
+    std::vector<Instruction> enclosingOutput = std::move(output);
+    output.clear();
+    std::unordered_set<TokenType> enclosingBitwiseOperations =
+        std::move(bitwiseRuntimeOperations);
+    bitwiseRuntimeOperations.clear();
+    std::set<std::string> enclosingStringLiterals =
+        std::move(currentStringLiterals);
+    currentStringLiterals.clear();
+    std::unordered_set<int> enclosingScalarCells = std::move(scalarCells);
+    std::unordered_set<int> enclosingExposedCells = std::move(exposedCells);
+    scalarCells.clear();
+    exposedCells.clear();
+    currentCallees.clear();
+    const int enclosingHighestAddress = memoryManager.getHighestMemoryAddress();
+
     emitComment("Function declaration: " + funcDecl->name);
 
     // Save current function context
     std::string oldFunction = currentFunction;
     currentFunction = funcDecl->name;
 
-    // Store parameter count for later use
-    functionParameterCounts[funcDecl->name] = funcDecl->parameters.size();
-
     // Generate function label
-    emit("");
+    emitBlankLine();
 
     // Check if we're in a namespace scope by looking up the function's symbol
     std::string functionLabel = funcDecl->name;
@@ -1815,8 +3953,18 @@ void CodeGenerator::generateFunctionDeclaration(
 
     emitLabel(functionLabel);
 
-    // Reset stack depth for new function - we'll track iter locally
-    stackDepth = funcDecl->parameters.size();
+    // Callers split their arguments between registers and stack by this
+    functionParameterCounts[functionLabel] = funcDecl->parameters.size();
+
+    // Reset stack depth for new function - we'll track iter locally. Under
+    // the register convention only the parameters after the seventh are on
+    // the stack.
+    const int registerParameters =
+        usesRegisterCalls(functionLabel)
+            ? std::min(static_cast<int>(funcDecl->parameters.size()),
+                       argumentRegisterCount)
+            : 0;
+    stackDepth = funcDecl->parameters.size() - registerParameters;
     emitComment("DEBUG: Function " + funcDecl->name +
                 " starts with stack depth: " + std::to_string(stackDepth));
 
@@ -1826,24 +3974,54 @@ void CodeGenerator::generateFunctionDeclaration(
                                                      funcDecl->name);
     memoryManager.pushScope("function_" + funcDecl->name);
 
+    // Frame placement from the layout pass; without one the frame starts
+    // at the next free cell
+    auto layout = frameLayouts.find(functionLabel);
+    if (layout != frameLayouts.end()) {
+        memoryManager.setNextMemoryAddress(layout->second.base);
+    }
+    function.frameBase = memoryManager.getNextMemoryAddress();
+    memoryManager.setHighestMemoryAddress(function.frameBase - 1);
+
+    // Parameters and scalar locals live in shared cells at the frame start
+    variableSlots.clear();
+    if (options.shareVariableSlots) {
+        const int slotBase =
+            memoryManager.reserveMemory(assignVariableSlots(funcDecl));
+        for (auto &[declaration, slot] : variableSlots) {
+            slot += slotBase;
+        }
+    }
+    const std::string enclosingFunctionLabel = currentFunctionLabel;
+    currentFunctionLabel = functionLabel;
+    const int enclosingStaticDataSize = staticDataSize;
+
     // Save current variable type tracking and start fresh for this function
     std::unordered_map<std::string, std::string> oldVariableLayoutTypes =
         variableLayoutTypes;
     variableLayoutTypes.clear();
 
-    // Allocate memory for parameters (they come from stack)
-    for (const auto &param : funcDecl->parameters) {
+    // Allocate memory for parameters (they come in registers, then from
+    // the stack)
+    for (int i = 0; i < static_cast<int>(funcDecl->parameters.size()); ++i) {
+        const auto &param = funcDecl->parameters[i];
         std::string paramFQDN = getVariableFQDN(param->name);
         std::string paramLayout = extractLayoutName(param->type.get());
         if (!paramLayout.empty()) {
             trackVariableLayout(paramFQDN, paramLayout);
         }
 
-        int address = memoryManager.allocateMemory(paramFQDN);
+        int address = allocateVariable(param.get(), paramFQDN);
+        scalarCells.insert(address);
 
-        popFromStack("Get parameter " + param->name);
-        emit("p(" + std::to_string(address) + ") := a0 // Store parameter " +
-             param->name);
+        Operand source = a0;
+        if (i < registerParameters) {
+            source = Operand::reg(i + 1);
+        } else {
+            popFromStack("Get parameter " + param->name);
+        }
+        emitAssign(Operand::mem(address), source,
+                   "Store parameter " + param->name);
         emitComment("DEBUG: Parameter " + param->name + " stored at address " +
                     std::to_string(address));
     }
@@ -1851,19 +4029,479 @@ void CodeGenerator::generateFunctionDeclaration(
     // Generate function body
     generateStatement(funcDecl->body.get());
 
-    // Note: Functions should have explicit return statements
-    // If no explicit return is found, the assembler will handle iter
-    // Todo: only emit this if no "ret" was found
-    emitComment("Function " + funcDecl->name + " ends without explicit return");
+    // A body that can run off its end returns the default value. If every
+    // path returns earlier, the tail is unreachable and the graph passes
+    // drop it.
+    const auto &statements = funcDecl->body->statements;
+    if (statements.empty() ||
+        statements.back()->nodeType != NodeType::RETURN_STATEMENT) {
+        emitComment("Function " + funcDecl->name +
+                    " ends without explicit return");
+        emitAssign(a0, Operand::imm(0));
+        pushToStack("Default return value");
+        if (usesRegisterCalls(currentFunctionLabel))
+            popFromStack("Return value in a0");
+        emit(Instruction::make(InstructionKind::RETURN),
+             "Return from function");
+    }
 
     // Restore previous context
     currentFunction = oldFunction;
+    currentFunctionLabel = enclosingFunctionLabel;
+    variableSlots.clear();
     variableLayoutTypes = oldVariableLayoutTypes;
 
     // Pop function scope
     memoryManager.popScope();
     if (semanticAnalyzer != nullptr)
         semanticAnalyzer->getSymbolTable().popScope();
+
+    // Calls that follow the declaration can substitute small bodies
+    if (options.inlineFunctions && funcDecl->name != "main") {
+        bool hasLayoutParameter = false;
+        for (const auto &param : funcDecl->parameters) {
+            hasLayoutParameter |= !extractLayoutName(param->type.get()).empty();
+        }
+        const int cost = getInlineCost(funcDecl->body.get());
+        if (!hasLayoutParameter && cost >= 0 && cost <= options.inlineCostLimit)
+            inlineCandidates[functionLabel] = funcDecl;
+    }
+
+    function.label = functionLabel;
+    function.staticDataSize = staticDataSize - enclosingStaticDataSize;
+    function.code = std::move(output);
+    function.callees = std::move(currentCallees);
+    currentCallees.clear();
+    function.bitwiseOperations = std::move(bitwiseRuntimeOperations);
+    function.stringLiterals = std::move(currentStringLiterals);
+    function.highestMemoryAddress = memoryManager.getHighestMemoryAddress();
+    function.scalarCells = std::move(scalarCells);
+    function.exposedCells = std::move(exposedCells);
+    functionCodes.push_back(std::move(function));
+
+    output = std::move(enclosingOutput);
+    bitwiseRuntimeOperations = std::move(enclosingBitwiseOperations);
+    currentStringLiterals = std::move(enclosingStringLiterals);
+    scalarCells = std::move(enclosingScalarCells);
+    exposedCells = std::move(enclosingExposedCells);
+    memoryManager.setHighestMemoryAddress(enclosingHighestAddress);
+}
+
+// ============================================================================
+// Dead Function Elimination
+// ============================================================================
+
+std::unordered_set<std::string>
+CodeGenerator::findReachableFunctions(const std::string &entryLabel) const {
+    std::unordered_map<std::string, const FunctionCode *> functionsByLabel;
+    for (const auto &function : functionCodes) {
+        functionsByLabel[function.label] = &function;
+    }
+
+    std::unordered_set<std::string> reachable{entryLabel};
+    std::vector<std::string> worklist{entryLabel};
+    while (!worklist.empty()) {
+        std::string label = worklist.back();
+        worklist.pop_back();
+
+        auto it = functionsByLabel.find(label);
+        if (it == functionsByLabel.end())
+            continue;
+        for (const auto &callee : it->second->callees) {
+            if (reachable.insert(callee).second)
+                worklist.push_back(callee);
+        }
+    }
+    return reachable;
+}
+
+std::vector<Instruction> CodeGenerator::linkFunctions(
+    const std::unordered_set<std::string> &reachable) const {
+    std::vector<Instruction> linked;
+    for (const auto &function : functionCodes) {
+        if (reachable.contains(function.label)) {
+            linked.insert(linked.end(), function.code.begin(),
+                          function.code.end());
+        } else {
+            linked.push_back(Instruction::makeComment(
+                " Function " + function.label +
+                " removed: not reachable from main"));
+        }
+    }
+    return linked;
+}
+
+// ============================================================================
+// Static Frame Overlay
+// ============================================================================
+
+// Frames are stacked along call graph paths: a function's frame starts
+// above the frames of all its callers, so two frames share memory only if
+// the functions can never be active at the same time. Functions of one
+// strongly connected component get consecutive frames and save their own
+// frame around calls into the component.
+void CodeGenerator::computeFrameLayouts(int globalHighestAddress) {
+    frameLayouts.clear();
+
+    const size_t count = functionCodes.size();
+    std::unordered_map<std::string, size_t> indexByLabel;
+    for (size_t i = 0; i < count; ++i) {
+        indexByLabel[functionCodes[i].label] = i;
+    }
+    std::vector<std::vector<size_t>> callees(count);
+    for (size_t i = 0; i < count; ++i) {
+        for (const auto &callee : functionCodes[i].callees) {
+            auto it = indexByLabel.find(callee);
+            if (it != indexByLabel.end())
+                callees[i].push_back(it->second);
+        }
+    }
+
+    // Tarjan's algorithm numbers components callees first
+    std::vector<int> component(count, -1);
+    std::vector<int> visitOrder(count, -1);
+    std::vector<int> lowLink(count, 0);
+    std::vector<bool> onStack(count, false);
+    std::vector<size_t> stack;
+    int nextVisit = 0;
+    int componentCount = 0;
+    std::function<void(size_t)> connect = [&](size_t v) {
+        visitOrder[v] = lowLink[v] = nextVisit++;
+        stack.push_back(v);
+        onStack[v] = true;
+        for (size_t w : callees[v]) {
+            if (visitOrder[w] < 0) {
+                connect(w);
+                lowLink[v] = std::min(lowLink[v], lowLink[w]);
+            } else if (onStack[w]) {
+                lowLink[v] = std::min(lowLink[v], visitOrder[w]);
+            }
+        }
+        if (lowLink[v] == visitOrder[v]) {
+            size_t w;
+            do {
+                w = stack.back();
+                stack.pop_back();
+                onStack[w] = false;
+                component[w] = componentCount;
+            } while (w != v);
+            componentCount++;
+        }
+    };
+    for (size_t i = 0; i < count; ++i) {
+        if (visitOrder[i] < 0)
+            connect(i);
+    }
+
+    std::vector<int> frameSizes(count);
+    std::vector<int> componentSizes(componentCount, 0);
+    for (size_t i = 0; i < count; ++i) {
+        const auto &function = functionCodes[i];
+        frameSizes[i] =
+            std::max(0, function.highestMemoryAddress - function.frameBase + 1);
+        componentSizes[component[i]] += frameSizes[i];
+    }
+
+    // Callers have higher component numbers, so walking the numbers
+    // downwards visits every caller before its callees
+    std::vector<std::vector<size_t>> members(componentCount);
+    for (size_t i = 0; i < count; ++i) {
+        members[component[i]].push_back(i);
+    }
+    std::vector<int> componentOffsets(componentCount, 0);
+    for (int c = componentCount - 1; c >= 0; --c) {
+        int base = globalHighestAddress + 1 + componentOffsets[c];
+        for (size_t i : members[c]) {
+            frameLayouts[functionCodes[i].label] = {base, frameSizes[i], c};
+            base += frameSizes[i];
+            for (size_t callee : callees[i]) {
+                const int d = component[callee];
+                if (d != c) {
+                    componentOffsets[d] = std::max(
+                        componentOffsets[d], componentOffsets[c] + componentSizes[c]);
+                }
+            }
+        }
+    }
+}
+
+// Arrays and strings created inside a function can outlive the call (itoa
+// returns its buffer), so with overlaid frames they get cells of their own
+// between the globals and the frames
+int CodeGenerator::allocateStaticData(int size) {
+    if (!options.overlayFrames || currentFunctionLabel.empty())
+        return memoryManager.allocateArray(size);
+    if (discardedFunctions.contains(currentFunctionLabel))
+        return staticDataBase; // The function's code is dropped anyway
+    const int address = staticDataBase + staticDataSize;
+    staticDataSize += size;
+    return address;
+}
+
+void CodeGenerator::generateFrameSave(const FrameLayout &frame) {
+    emitComment("Save frame for recursive call");
+    for (int address = frame.base; address < frame.base + frame.size;
+         ++address) {
+        emitAssign(a0, Operand::mem(address));
+        emit(Instruction::makePush());
+    }
+    stackDepth += frame.size;
+}
+
+void CodeGenerator::generateFrameRestore(const FrameLayout &frame) {
+    // The return value sits on top of the saved frame
+    emitComment("Restore frame after recursive call");
+    emit(Instruction::makePop(a1), "Return value");
+    for (int address = frame.base + frame.size - 1; address >= frame.base;
+         --address) {
+        emit(Instruction::makePop());
+        emitAssign(Operand::mem(address), a0);
+    }
+    emit(Instruction::makePush(a1), "Return value");
+    stackDepth -= frame.size;
+}
+
+// ============================================================================
+// Variable Slot Sharing
+// ============================================================================
+
+namespace {
+
+// Live ranges of a function's parameters and locals over a linear walk of
+// the body. Uses inside a loop keep variables declared outside of it live
+// until the loop ends, since the next iteration may read them again.
+class VariableLiveness {
+  public:
+    struct Range {
+        const ASTNode *declaration;
+        int start;
+        int end;
+        bool shareable;
+    };
+
+    std::vector<Range> ranges;
+
+    void declare(const ASTNode *declaration, const std::string &name,
+                 bool shareable) {
+        scopes.back()[name] = ranges.size();
+        ranges.push_back({declaration, position, position, shareable});
+        position++;
+    }
+
+    void use(const std::string &name) {
+        for (const auto &scope : std::ranges::reverse_view(scopes)) {
+            auto it = scope.find(name);
+            if (it == scope.end())
+                continue;
+            ranges[it->second].end = position++;
+            for (auto &loop : loops) {
+                if (it->second < loop.firstVariable)
+                    loop.outerUses.insert(it->second);
+            }
+            return;
+        }
+    }
+
+    void visitStatement(const Statement *stmt);
+    void visitExpression(const Expression *expr);
+
+  private:
+    struct Loop {
+        size_t firstVariable;
+        std::unordered_set<size_t> outerUses;
+    };
+
+    int position{0};
+    std::vector<std::unordered_map<std::string, size_t>> scopes{1};
+    std::vector<Loop> loops;
+};
+
+void VariableLiveness::visitStatement(const Statement *stmt) {
+    if (stmt == nullptr)
+        return;
+
+    switch (stmt->nodeType) {
+    case NodeType::VARIABLE_DECLARATION: {
+        const auto *varDecl = static_cast<const VariableDeclaration *>(stmt);
+        visitExpression(varDecl->initializer.get());
+        // Layouts own member cells next to the variable, and a variable
+        // without initializer keeps whatever its cell held before
+        declare(varDecl, varDecl->name,
+                varDecl->initializer != nullptr &&
+                    varDecl->type->nodeType != NodeType::LAYOUT_TYPE);
+        break;
+    }
+    case NodeType::ASSIGNMENT: {
+        const auto *assignment = static_cast<const Assignment *>(stmt);
+        visitExpression(assignment->value.get());
+        visitExpression(assignment->target.get());
+        break;
+    }
+    case NodeType::EXPRESSION_STATEMENT:
+        visitExpression(
+            static_cast<const ExpressionStatement *>(stmt)->expression.get());
+        break;
+    case NodeType::RETURN_STATEMENT:
+        visitExpression(static_cast<const ReturnStatement *>(stmt)->value.get());
+        break;
+    case NodeType::IF_STATEMENT: {
+        const auto *ifStmt = static_cast<const IfStatement *>(stmt);
+        visitExpression(ifStmt->condition.get());
+        visitStatement(ifStmt->thenStatement.get());
+        visitStatement(ifStmt->elseStatement.get());
+        break;
+    }
+    case NodeType::WHILE_STATEMENT: {
+        const auto *whileStmt = static_cast<const WhileStatement *>(stmt);
+        loops.push_back({ranges.size(), {}});
+        visitExpression(whileStmt->condition.get());
+        visitStatement(whileStmt->body.get());
+        Loop loop = std::move(loops.back());
+        loops.pop_back();
+        for (size_t variable : loop.outerUses) {
+            ranges[variable].end = position;
+        }
+        position++;
+        break;
+    }
+    case NodeType::BLOCK_STATEMENT:
+        scopes.emplace_back();
+        for (const auto &statement :
+             static_cast<const BlockStatement *>(stmt)->statements) {
+            visitStatement(statement.get());
+        }
+        scopes.pop_back();
+        break;
+    default:
+        break;
+    }
+}
+
+void VariableLiveness::visitExpression(const Expression *expr) {
+    if (expr == nullptr)
+        return;
+
+    switch (expr->nodeType) {
+    case NodeType::IDENTIFIER:
+        use(static_cast<const Identifier *>(expr)->name);
+        break;
+    case NodeType::BINARY_EXPRESSION: {
+        const auto *binExpr = static_cast<const BinaryExpression *>(expr);
+        visitExpression(binExpr->left.get());
+        visitExpression(binExpr->right.get());
+        break;
+    }
+    case NodeType::UNARY_EXPRESSION: {
+        const auto *unExpr = static_cast<const UnaryExpression *>(expr);
+        if (unExpr->operator_ == TokenType::REFERENCE &&
+            unExpr->operand->nodeType == NodeType::IDENTIFIER) {
+            // The address may be used at any later point
+            const auto &name =
+                static_cast<const Identifier *>(unExpr->operand.get())->name;
+            for (const auto &scope : std::ranges::reverse_view(scopes)) {
+                if (auto it = scope.find(name); it != scope.end()) {
+                    ranges[it->second].shareable = false;
+                    break;
+                }
+            }
+        }
+        visitExpression(unExpr->operand.get());
+        break;
+    }
+    case NodeType::FUNCTION_CALL:
+        for (const auto &argument :
+             static_cast<const FunctionCall *>(expr)->arguments) {
+            visitExpression(argument.get());
+        }
+        break;
+    case NodeType::SYSCALL_EXPRESSION:
+        for (const auto &argument :
+             static_cast<const SyscallExpression *>(expr)->arguments) {
+            visitExpression(argument.get());
+        }
+        break;
+    case NodeType::LAYOUT_INITIALIZATION:
+        for (const auto &value :
+             static_cast<const LayoutInitialization *>(expr)->values) {
+            visitExpression(value.get());
+        }
+        break;
+    case NodeType::ARRAY_ACCESS: {
+        const auto *access = static_cast<const ArrayAccess *>(expr);
+        visitExpression(access->array.get());
+        visitExpression(access->index.get());
+        break;
+    }
+    case NodeType::ARRAY_ALLOCATION:
+        visitExpression(static_cast<const ArrayAllocation *>(expr)->size.get());
+        break;
+    case NodeType::MEMBER_ACCESS:
+        visitExpression(static_cast<const MemberAccess *>(expr)->object.get());
+        break;
+    case NodeType::TYPE_CAST:
+        visitExpression(static_cast<const TypeCast *>(expr)->expression.get());
+        break;
+    default:
+        break;
+    }
+}
+
+} // namespace
+
+// Linear scan over the live ranges: a cell is handed to the next variable
+// once the range of its previous owner has ended. Variables that cannot
+// share keep a cell of their own.
+int CodeGenerator::assignVariableSlots(const FunctionDeclaration *funcDecl) {
+    VariableLiveness liveness;
+    for (const auto &param : funcDecl->parameters) {
+        liveness.declare(param.get(), param->name, true);
+    }
+    // Parameters are all stored on entry, before any of them is read
+    for (auto &range : liveness.ranges) {
+        range.start = 0;
+    }
+    liveness.visitStatement(funcDecl->body.get());
+
+    std::vector<VariableLiveness::Range> ranges = liveness.ranges;
+    std::ranges::stable_sort(ranges, {}, &VariableLiveness::Range::start);
+
+    int slotCount = 0;
+    std::vector<int> slotEnds; // slot -> end of its current owner
+    for (const auto &range : ranges) {
+        if (!range.shareable) {
+            // Layouts are allocated together with their member cells
+            if (range.declaration->nodeType == NodeType::VARIABLE_DECLARATION &&
+                static_cast<const VariableDeclaration *>(range.declaration)
+                        ->type->nodeType == NodeType::LAYOUT_TYPE)
+                continue;
+            variableSlots[range.declaration] = slotCount++;
+            slotEnds.push_back(std::numeric_limits<int>::max());
+            continue;
+        }
+        int slot = -1;
+        for (int candidate = 0; candidate < slotCount; ++candidate) {
+            if (slotEnds[candidate] < range.start) {
+                slot = candidate;
+                break;
+            }
+        }
+        if (slot < 0) {
+            slot = slotCount++;
+            slotEnds.push_back(range.end);
+        }
+        slotEnds[slot] = range.end;
+        variableSlots[range.declaration] = slot;
+    }
+    return slotCount;
+}
+
+int CodeGenerator::allocateVariable(const ASTNode *declaration,
+                                    const std::string &fqdn) {
+    auto slot = variableSlots.find(declaration);
+    if (slot == variableSlots.end())
+        return memoryManager.allocateMemory(fqdn);
+    memoryManager.bindMemory(fqdn, slot->second);
+    return slot->second;
 }
 
 void CodeGenerator::generateBlockStatement(const BlockStatement *blockStmt) {
@@ -1874,8 +4512,11 @@ void CodeGenerator::generateBlockStatement(const BlockStatement *blockStmt) {
                             std::to_string(blockStmt->column));
 
     // Generate code for each statement in the block
-    for (const auto &statement : blockStmt->statements) {
-        generateStatement(statement.get());
+    const auto &statements = blockStmt->statements;
+    for (size_t i = 0; i < statements.size(); ++i) {
+        if (options.elideFilledArrayZeroing)
+            markFilledAllocation(statements, i);
+        generateStatement(statements[i].get());
     }
 
     // Pop scope
@@ -1884,36 +4525,227 @@ void CodeGenerator::generateBlockStatement(const BlockStatement *blockStmt) {
         semanticAnalyzer->getSymbolTable().popScope();
 }
 
+// `T[] buf = ~T[n];` followed directly by stores `buf[k] = ...` to every
+// constant index k < n, none of whose values mention buf: no element can be
+// read before it is written, so the allocation need not zero them.
+void CodeGenerator::markFilledAllocation(
+    const std::vector<std::unique_ptr<Statement>> &statements, size_t index) {
+    if (statements[index]->nodeType != NodeType::VARIABLE_DECLARATION)
+        return;
+    const auto *varDecl =
+        static_cast<const VariableDeclaration *>(statements[index].get());
+    if (!varDecl->initializer ||
+        varDecl->initializer->nodeType != NodeType::ARRAY_ALLOCATION)
+        return;
+    const auto *arrayAlloc =
+        static_cast<const ArrayAllocation *>(varDecl->initializer.get());
+    auto elements = tryFoldConstant(arrayAlloc->size.get());
+    if (!elements || *elements <= 0 ||
+        arrayAlloc->elementType->nodeType == NodeType::LAYOUT_TYPE)
+        return;
+
+    auto mentionsArray = [&](const Expression *expr) {
+        return anySubexpression(expr, [&](const Expression *node) {
+            return node->nodeType == NodeType::IDENTIFIER &&
+                   static_cast<const Identifier *>(node)->name == varDecl->name;
+        });
+    };
+
+    std::unordered_set<int64_t> written;
+    for (size_t i = index + 1; i < statements.size(); ++i) {
+        if (statements[i]->nodeType != NodeType::ASSIGNMENT)
+            return;
+        const auto *assignment =
+            static_cast<const Assignment *>(statements[i].get());
+        if (assignment->target->nodeType != NodeType::ARRAY_ACCESS ||
+            mentionsArray(assignment->value.get()))
+            return;
+        const auto *target =
+            static_cast<const ArrayAccess *>(assignment->target.get());
+        auto element = tryFoldConstant(target->index.get());
+        if (target->array->nodeType != NodeType::IDENTIFIER ||
+            static_cast<const Identifier *>(target->array.get())->name !=
+                varDecl->name ||
+            !element || *element < 0 || *element >= *elements)
+            return;
+        written.insert(*element);
+        if (static_cast<int64_t>(written.size()) == *elements) {
+            filledAllocations.insert(arrayAlloc);
+            return;
+        }
+    }
+}
+
 void CodeGenerator::generateComparison(TokenType op,
                                        const std::string &trueLabel,
                                        const std::string &falseLabel) {
     // Generate conditional jump based on comparison operator
     switch (op) {
     case TokenType::EQUAL:
-        emit("if a0 == a1 then goto " + trueLabel + " // Jump if equal");
+        emitConditionalJump(a0, AlphaOperator::EQ, a1, trueLabel,
+                            "Jump if equal");
         break;
     case TokenType::NOT_EQUAL:
-        emit("if a0 != a1 then goto " + trueLabel + " // Jump if not equal");
+        emitConditionalJump(a0, AlphaOperator::NE, a1, trueLabel,
+                            "Jump if not equal");
         break;
     case TokenType::LESS_THAN:
-        emit("if a0 < a1 then goto " + trueLabel + " // Jump if less than");
+        emitConditionalJump(a0, AlphaOperator::LT, a1, trueLabel,
+                            "Jump if less than");
         break;
     case TokenType::LESS_EQUAL:
-        emit("if a0 <= a1 then goto " + trueLabel +
-             " // Jump if less than or equal");
+        emitConditionalJump(a0, AlphaOperator::LE, a1, trueLabel,
+                            "Jump if less than or equal");
         break;
     case TokenType::GREATER_THAN:
-        emit("if a0 > a1 then goto " + trueLabel + " // Jump if greater than");
+        emitConditionalJump(a0, AlphaOperator::GT, a1, trueLabel,
+                            "Jump if greater than");
         break;
     case TokenType::GREATER_EQUAL:
-        emit("if a0 >= a1 then goto " + trueLabel +
-             " // Jump if greater than or equal");
+        emitConditionalJump(a0, AlphaOperator::GE, a1, trueLabel,
+                            "Jump if greater than or equal");
         break;
     default:
         emitComment("Unknown comparison operator");
         break;
     }
-    emit("goto " + falseLabel + " // Jump to false branch");
+    emitJump(falseLabel, "Jump to false branch");
+}
+
+void CodeGenerator::generateConditionalJump(const Expression *condition,
+                                            const std::string &target,
+                                            bool jumpWhen) {
+    if (auto value = tryFoldConstant(condition)) {
+        // Constant condition: either always or never jump
+        if ((*value != 0) == jumpWhen) {
+            emitJump(target, "Constant condition");
+        }
+        return;
+    }
+
+    if (condition->nodeType == NodeType::BINARY_EXPRESSION) {
+        const auto *binExpr = static_cast<const BinaryExpression *>(condition);
+
+        // Short-circuit: the right operand only runs if the left one does
+        // not already decide the outcome
+        if (binExpr->operator_ == TokenType::LOGICAL_AND ||
+            binExpr->operator_ == TokenType::LOGICAL_OR) {
+            // The left operand decides alone when it equals `decidesWhen`
+            const bool decidesWhen =
+                binExpr->operator_ == TokenType::LOGICAL_OR;
+            if (decidesWhen == jumpWhen) {
+                generateConditionalJump(binExpr->left.get(), target, jumpWhen);
+                generateConditionalJump(binExpr->right.get(), target,
+                                        jumpWhen);
+            } else {
+                std::string skipLabel = labelGenerator.generateLabel(
+                    decidesWhen ? "or_done" : "and_done");
+                generateConditionalJump(binExpr->left.get(), skipLabel,
+                                        decidesWhen);
+                generateConditionalJump(binExpr->right.get(), target,
+                                        jumpWhen);
+                emitLabel(skipLabel);
+            }
+            return;
+        }
+
+        if (isComparisonOperator(binExpr->operator_)) {
+            // Nested comparison tested against 0/1, e.g. (a < b) == 0
+            auto isBooleanLiteral = [](const Expression *expr) {
+                if (expr->nodeType != NodeType::LITERAL)
+                    return false;
+                const auto *literal = static_cast<const Literal *>(expr);
+                return literal->literalType == TokenType::INTEGER &&
+                       (literal->value == "0" || literal->value == "1");
+            };
+            auto isComparison = [](const Expression *expr) {
+                if (expr->nodeType != NodeType::BINARY_EXPRESSION)
+                    return false;
+                TokenType op =
+                    static_cast<const BinaryExpression *>(expr)->operator_;
+                return isComparisonOperator(op) ||
+                       op == TokenType::LOGICAL_AND ||
+                       op == TokenType::LOGICAL_OR;
+            };
+
+            const Expression *inner = nullptr;
+            const Expression *constant = nullptr;
+            if (isComparison(binExpr->left.get()) &&
+                isBooleanLiteral(binExpr->right.get())) {
+                inner = binExpr->left.get();
+                constant = binExpr->right.get();
+            } else if (isComparison(binExpr->right.get()) &&
+                       isBooleanLiteral(binExpr->left.get())) {
+                inner = binExpr->right.get();
+                constant = binExpr->left.get();
+            }
+
+            if (inner != nullptr &&
+                (binExpr->operator_ == TokenType::EQUAL ||
+                 binExpr->operator_ == TokenType::NOT_EQUAL)) {
+                bool testsTrue =
+                    static_cast<const Literal *>(constant)->value == "1";
+                if (binExpr->operator_ == TokenType::NOT_EQUAL)
+                    testsTrue = !testsTrue;
+                generateConditionalJump(inner, target,
+                                        testsTrue ? jumpWhen : !jumpWhen);
+                return;
+            }
+
+            TokenType op = jumpWhen ? binExpr->operator_
+                                    : invertComparison(binExpr->operator_);
+
+            if (options.registerExpressions &&
+                isRegisterExpression(binExpr->left.get()) &&
+                isRegisterExpression(binExpr->right.get())) {
+                const Expression *left = binExpr->left.get();
+                const Expression *right = binExpr->right.get();
+                // Only the right side of a comparison takes an immediate
+                if (getOperandCost(right, false) + getOperandCost(left, true) <
+                    getOperandCost(left, false) + getOperandCost(right, true)) {
+                    std::swap(left, right);
+                    op = swapComparison(op);
+                }
+                const auto [lhs, rhs] = generateRegisterOperands(left, right);
+                emitConditionalJump(lhs.toOperand(), getComparisonOperator(op),
+                                    rhs.toOperand(), target,
+                                    "Branch on comparison");
+                releaseOperand(lhs);
+                releaseOperand(rhs);
+                return;
+            }
+
+            generateExpression(binExpr->left.get());
+            generateExpression(binExpr->right.get());
+            popFromStack("Get right operand");
+            emitAssign(a1, a0);
+            popFromStack("Get left operand");
+
+            emitConditionalJump(a0, getComparisonOperator(op), a1, target,
+                                "Branch on comparison");
+            return;
+        }
+    }
+
+    // Any other value: test against zero
+    generateExpression(condition);
+    popFromStack("Get condition result");
+    emitConditionalJump(a0, jumpWhen ? AlphaOperator::NE : AlphaOperator::EQ,
+                        Operand::imm(0), target, "Branch on condition");
+}
+
+void CodeGenerator::generateLogicalExpression(const BinaryExpression *binExpr) {
+    // Value of && / || outside a condition: branch, then materialize 0/1
+    std::string falseLabel = labelGenerator.generateLabel("logic_false");
+    std::string endLabel = labelGenerator.generateLabel("logic_end");
+
+    generateConditionalJump(binExpr, falseLabel, false);
+    emitAssign(a0, Operand::imm(1), "Logical result: true");
+    emitJump(endLabel);
+    emitLabel(falseLabel);
+    emitAssign(a0, Operand::imm(0), "Logical result: false");
+    emitLabel(endLabel);
+    pushToStack(" logical result");
 }
 
 void CodeGenerator::generateComparisonResult(TokenType op) {
@@ -1923,24 +4755,28 @@ void CodeGenerator::generateComparisonResult(TokenType op) {
 
     switch (op) {
     case TokenType::EQUAL:
-        emit("if a0 == a1 then goto " + trueLabel + " // Jump if equal");
+        emitConditionalJump(a0, AlphaOperator::EQ, a1, trueLabel,
+                            "Jump if equal");
         break;
     case TokenType::NOT_EQUAL:
-        emit("if a0 != a1 then goto " + trueLabel + " // Jump if not equal");
+        emitConditionalJump(a0, AlphaOperator::NE, a1, trueLabel,
+                            "Jump if not equal");
         break;
     case TokenType::LESS_THAN:
-        emit("if a0 < a1 then goto " + trueLabel + " // Jump if less than");
+        emitConditionalJump(a0, AlphaOperator::LT, a1, trueLabel,
+                            "Jump if less than");
         break;
     case TokenType::LESS_EQUAL:
-        emit("if a0 <= a1 then goto " + trueLabel +
-             " // Jump if less than or equal");
+        emitConditionalJump(a0, AlphaOperator::LE, a1, trueLabel,
+                            "Jump if less than or equal");
         break;
     case TokenType::GREATER_THAN:
-        emit("if a0 > a1 then goto " + trueLabel + " // Jump if greater than");
+        emitConditionalJump(a0, AlphaOperator::GT, a1, trueLabel,
+                            "Jump if greater than");
         break;
     case TokenType::GREATER_EQUAL:
-        emit("if a0 >= a1 then goto " + trueLabel +
-             " // Jump if greater than or equal");
+        emitConditionalJump(a0, AlphaOperator::GE, a1, trueLabel,
+                            "Jump if greater than or equal");
         break;
     default:
         emitComment("Unknown comparison operator");
@@ -1948,12 +4784,12 @@ void CodeGenerator::generateComparisonResult(TokenType op) {
     }
 
     // False case
-    emit("a0 := 0 // Comparison result: false");
-    emit("goto " + endLabel);
+    emitAssign(a0, Operand::imm(0), "Comparison result: false");
+    emitJump(endLabel);
 
     // True case
     emitLabel(trueLabel);
-    emit("a0 := 1 // Comparison result: true");
+    emitAssign(a0, Operand::imm(1), "Comparison result: true");
 
     emitLabel(endLabel);
 
@@ -1965,21 +4801,13 @@ void CodeGenerator::generateSyscallExpression(
     const SyscallExpression *syscallExpr) {
     emitComment("Syscall expression");
 
-    // Generate each argument and assign to registers a0-a6
-    for (size_t i = 0; i < syscallExpr->arguments.size(); ++i) {
-        generateExpression(syscallExpr->arguments[i].get());
-        popFromStack("Get argument " + std::to_string(i));
-        if (i == 0)
-            pushToStack(" syscall number");
-
-        emit("a" + std::to_string(i) + " := a0 // Store argument " +
-             std::to_string(i) + " in register a" + std::to_string(i));
-    }
-
-    popFromStack("Get syscall number");
+    // Assign the arguments to registers a0-a6. Each is computed before any
+    // register is set, so one argument's code cannot clobber another's.
+    generateArgumentRegisters(syscallExpr->arguments,
+                              syscallExpr->arguments.size(), 0);
 
     // Execute syscall
-    emit("syscall // Execute system call");
+    emit(Instruction::make(InstructionKind::SYSCALL), "Execute system call");
 
     // Syscall result is in a0, push iter to stack
     pushToStack(" syscall result");
@@ -2002,7 +4830,7 @@ void CodeGenerator::generateLayoutInitialization(const LayoutInitialization *lay
     }
     
     // Push a marker to indicate this is a layout initialization
-    emit("a0 := " + std::to_string(layoutInit->values.size()) + " // Number of layout init values");
+    emitAssign(a0, Operand::imm(static_cast<int64_t>(layoutInit->values.size())), "Number of layout init values");
     pushToStack(" layout init marker");
 }
 
@@ -0,0 +1,632 @@
+#include "instruction.hpp"
+#include <cctype>
+#include <sstream>
+
+namespace calpha {
+
+// ============================================================================
+// Operand / Operator helpers
+// ============================================================================
+
+std::string Operand::toString() const {
+    switch (kind) {
+    case OperandKind::REGISTER:
+        return "a" + std::to_string(value);
+    case OperandKind::IMMEDIATE:
+        return std::to_string(value);
+    case OperandKind::MEMORY:
+        return "p(" + std::to_string(value) + ")";
+    case OperandKind::MEMORY_INDIRECT:
+        return "p(a" + std::to_string(value) + ")";
+    default:
+        return "";
+    }
+}
+
+std::string alphaOperatorToString(AlphaOperator op) {
+    switch (op) {
+    case AlphaOperator::ADD:
+        return "+";
+    case AlphaOperator::SUB:
+        return "-";
+    case AlphaOperator::MUL:
+        return "*";
+    case AlphaOperator::DIV:
+        return "/";
+    case AlphaOperator::MOD:
+        return "%";
+    case AlphaOperator::AND:
+        return "&";
+    case AlphaOperator::OR:
+        return "|";
+    case AlphaOperator::XOR:
+        return "^";
+    case AlphaOperator::NOT:
+        return "~";
+    case AlphaOperator::EQ:
+        return "==";
+    case AlphaOperator::NE:
+        return "!=";
+    case AlphaOperator::LT:
+        return "<";
+    case AlphaOperator::LE:
+        return "<=";
+    case AlphaOperator::GT:
+        return ">";
+    case AlphaOperator::GE:
+        return ">=";
+    default:
+        return "?";
+    }
+}
+
+bool isAlphaComparison(AlphaOperator op) {
+    return op == AlphaOperator::EQ || op == AlphaOperator::NE ||
+           op == AlphaOperator::LT || op == AlphaOperator::LE ||
+           op == AlphaOperator::GT || op == AlphaOperator::GE;
+}
+
+AlphaOperator invertAlphaComparison(AlphaOperator op) {
+    switch (op) {
+    case AlphaOperator::EQ:
+        return AlphaOperator::NE;
+    case AlphaOperator::NE:
+        return AlphaOperator::EQ;
+    case AlphaOperator::LT:
+        return AlphaOperator::GE;
+    case AlphaOperator::LE:
+        return AlphaOperator::GT;
+    case AlphaOperator::GT:
+        return AlphaOperator::LE;
+    case AlphaOperator::GE:
+        return AlphaOperator::LT;
+    default:
+        return op;
+    }
+}
+
+AlphaOperator swapAlphaComparison(AlphaOperator op) {
+    switch (op) {
+    case AlphaOperator::LT:
+        return AlphaOperator::GT;
+    case AlphaOperator::LE:
+        return AlphaOperator::GE;
+    case AlphaOperator::GT:
+        return AlphaOperator::LT;
+    case AlphaOperator::GE:
+        return AlphaOperator::LE;
+    default:
+        return op; // == and != are symmetric
+    }
+}
+
+std::optional<int64_t> foldAlphaOperation(AlphaOperator op, int64_t lhs,
+                                          int64_t rhs) {
+    // Arithmetic wraps like 64-bit two's complement hardware instead of
+    // invoking signed-overflow UB
+    const auto ul = static_cast<uint64_t>(lhs);
+    const auto ur = static_cast<uint64_t>(rhs);
+    switch (op) {
+    case AlphaOperator::ADD:
+        return static_cast<int64_t>(ul + ur);
+    case AlphaOperator::SUB:
+        return static_cast<int64_t>(ul - ur);
+    case AlphaOperator::MUL:
+        return static_cast<int64_t>(ul * ur);
+    case AlphaOperator::DIV:
+    case AlphaOperator::MOD:
+        if (rhs == 0)
+            return std::nullopt;
+        if (rhs == -1) // INT64_MIN / -1 overflows
+            return op == AlphaOperator::DIV ? static_cast<int64_t>(0 - ul) : 0;
+        return op == AlphaOperator::DIV ? lhs / rhs : lhs % rhs;
+    case AlphaOperator::AND:
+        return lhs & rhs;
+    case AlphaOperator::OR:
+        return lhs | rhs;
+    case AlphaOperator::XOR:
+        return lhs ^ rhs;
+    default:
+        return std::nullopt;
+    }
+}
+
+bool foldAlphaComparison(AlphaOperator op, int64_t lhs, int64_t rhs) {
+    switch (op) {
+    case AlphaOperator::EQ:
+        return lhs == rhs;
+    case AlphaOperator::NE:
+        return lhs != rhs;
+    case AlphaOperator::LT:
+        return lhs < rhs;
+    case AlphaOperator::LE:
+        return lhs <= rhs;
+    case AlphaOperator::GT:
+        return lhs > rhs;
+    case AlphaOperator::GE:
+        return lhs >= rhs;
+    default:
+        return false;
+    }
+}
+
+// ============================================================================
+// Register effects
+// ============================================================================
+
+namespace {
+
+// Operand reads register `reg`, either directly or as a memory address
+bool operandUses(const Operand &operand, int reg) {
+    return (operand.kind == OperandKind::REGISTER ||
+            operand.kind == OperandKind::MEMORY_INDIRECT) &&
+           operand.value == reg;
+}
+
+// Syscalls take their number in a0 and arguments in a1..a6
+constexpr int kSyscallRegisters = 7;
+
+} // namespace
+
+bool Instruction::readsRegister(int reg) const {
+    switch (kind) {
+    case InstructionKind::ASSIGN:
+    case InstructionKind::UNARY:
+        return operandUses(lhs, reg) ||
+               (dst.kind == OperandKind::MEMORY_INDIRECT && dst.value == reg);
+    case InstructionKind::BINARY:
+        return operandUses(lhs, reg) || operandUses(rhs, reg) ||
+               (dst.kind == OperandKind::MEMORY_INDIRECT && dst.value == reg);
+    case InstructionKind::IF_GOTO:
+        return operandUses(lhs, reg) || operandUses(rhs, reg);
+    case InstructionKind::PUSH:
+        return lhs.isNone() ? reg == 0 : operandUses(lhs, reg);
+    case InstructionKind::SYSCALL:
+        return reg >= 0 && reg < kSyscallRegisters;
+    default:
+        return false;
+    }
+}
+
+bool Instruction::writesRegister(int reg) const {
+    switch (kind) {
+    case InstructionKind::ASSIGN:
+    case InstructionKind::BINARY:
+    case InstructionKind::UNARY:
+        return dst.isRegister(reg);
+    case InstructionKind::POP:
+        return dst.isNone() ? reg == 0 : dst.isRegister(reg);
+    case InstructionKind::SYSCALL:
+        return reg == 0;
+    default:
+        return false;
+    }
+}
+
+// ============================================================================
+// Encoding
+// ============================================================================
+
+std::string Instruction::toString() const {
+    std::string text;
+    switch (kind) {
+    case InstructionKind::BLANK:
+        break;
+    case InstructionKind::COMMENT:
+        return "//" + comment;
+    case InstructionKind::LABEL:
+        text = label + ":";
+        break;
+    case InstructionKind::ASSIGN:
+        text = dst.toString() + " := " + lhs.toString();
+        break;
+    case InstructionKind::BINARY:
+        text = dst.toString() + " := " + lhs.toString() + " " +
+               alphaOperatorToString(op) + " " + rhs.toString();
+        break;
+    case InstructionKind::UNARY:
+        text = dst.toString() + " := " + alphaOperatorToString(op) +
+               lhs.toString();
+        break;
+    case InstructionKind::PUSH:
+        text = lhs.isRegister(0) || lhs.isNone() ? "push"
+                                                 : "push " + lhs.toString();
+        break;
+    case InstructionKind::POP:
+        text = dst.isRegister(0) || dst.isNone() ? "pop"
+                                                 : "pop " + dst.toString();
+        break;
+    case InstructionKind::STACK_OP:
+        text = "stack" + alphaOperatorToString(op);
+        break;
+    case InstructionKind::CALL:
+        text = "call " + label;
+        break;
+    case InstructionKind::RETURN:
+        text = "return";
+        break;
+    case InstructionKind::GOTO:
+        text = "goto " + label;
+        break;
+    case InstructionKind::IF_GOTO:
+        text = "if " + lhs.toString() + " " + alphaOperatorToString(op) + " " +
+               rhs.toString() + " then goto " + label;
+        break;
+    case InstructionKind::SYSCALL:
+        text = "syscall";
+        break;
+    case InstructionKind::NOP:
+        text = "nop";
+        break;
+    }
+    if (!comment.empty()) {
+        text += text.empty() ? "//" + comment : " //" + comment;
+    }
+    return text;
+}
+
+std::string encodeAlphaProgram(const std::vector<Instruction> &program) {
+    std::string text;
+    for (const auto &instruction : program) {
+        text += instruction.toString();
+        text += '\n';
+    }
+    return text;
+}
+
+// ============================================================================
+// Decoding
+// ============================================================================
+
+namespace {
+
+std::string trim(const std::string &text) {
+    const size_t first = text.find_first_not_of(" \t\r\n");
+    if (first == std::string::npos)
+        return "";
+    const size_t last = text.find_last_not_of(" \t\r\n");
+    return text.substr(first, last - first + 1);
+}
+
+bool isIdentifier(const std::string &text) {
+    if (text.empty() ||
+        (std::isalpha(static_cast<unsigned char>(text[0])) == 0 &&
+         text[0] != '_'))
+        return false;
+    for (size_t i = 0; i < text.size(); ++i) {
+        const char c = text[i];
+        if (std::isalnum(static_cast<unsigned char>(c)) != 0 || c == '_')
+            continue;
+        // Qualified names (global::main) of the compiler's IR
+        if (c == ':' && i + 2 < text.size() && text[i + 1] == ':' &&
+            text[i + 2] != ':') {
+            ++i;
+            continue;
+        }
+        return false;
+    }
+    return true;
+}
+
+// Token of an instruction body: either an operand or an operator spelling
+struct AlphaToken {
+    bool isOperand{false};
+    Operand operand;
+    std::string text;
+};
+
+class InstructionScanner {
+  private:
+    const std::string &text;
+    size_t position{0};
+    int lineNumber;
+
+    [[nodiscard]] char current() const {
+        return position < text.size() ? text[position] : '\0';
+    }
+
+    void skipSpaces() {
+        while (std::isspace(static_cast<unsigned char>(current())) != 0)
+            ++position;
+    }
+
+    int64_t scanNumber() {
+        const size_t start = position;
+        if (current() == '-')
+            ++position;
+        while (std::isdigit(static_cast<unsigned char>(current())) != 0)
+            ++position;
+        try {
+            return std::stoll(text.substr(start, position - start));
+        } catch (const std::exception &) {
+            throw AlphaSyntaxError("invalid integer '" +
+                                       text.substr(start, position - start) +
+                                       "'",
+                                   lineNumber);
+        }
+    }
+
+    std::string scanWord() {
+        const size_t start = position;
+        while (std::isalnum(static_cast<unsigned char>(current())) != 0 ||
+               current() == '_')
+            ++position;
+        return text.substr(start, position - start);
+    }
+
+    Operand registerOperand(const std::string &word) const {
+        if (word == "a")
+            return Operand::reg(0);
+        if (word.size() > 1 && word[0] == 'a') {
+            const std::string digits = word.substr(1);
+            bool numeric = true;
+            for (char c : digits)
+                numeric = numeric && std::isdigit(static_cast<unsigned char>(c)) != 0;
+            if (numeric)
+                return Operand::reg(std::stoi(digits));
+        }
+        throw AlphaSyntaxError("unknown operand '" + word + "'", lineNumber);
+    }
+
+  public:
+    InstructionScanner(const std::string &text, int lineNumber)
+        : text(text), lineNumber(lineNumber) {
+    }
+
+    std::vector<AlphaToken> scan() {
+        std::vector<AlphaToken> tokens;
+        while (true) {
+            skipSpaces();
+            const char c = current();
+            if (c == '\0')
+                break;
+
+            const bool expectOperand =
+                tokens.empty() || !tokens.back().isOperand;
+            AlphaToken token;
+
+            if (std::isdigit(static_cast<unsigned char>(c)) != 0 ||
+                (c == '-' && expectOperand &&
+                 std::isdigit(static_cast<unsigned char>(
+                     position + 1 < text.size() ? text[position + 1] : '\0')) !=
+                     0)) {
+                token.isOperand = true;
+                token.operand = Operand::imm(scanNumber());
+            } else if (std::isalpha(static_cast<unsigned char>(c)) != 0) {
+                const std::string word = scanWord();
+                skipSpaces();
+                if (word == "p" && current() == '(') {
+                    ++position;
+                    skipSpaces();
+                    token.isOperand = true;
+                    if (std::isdigit(static_cast<unsigned char>(current())) !=
+                        0) {
+                        token.operand = Operand::mem(scanNumber());
+                    } else {
+                        const Operand inner = registerOperand(scanWord());
+                        token.operand = Operand::indirect(
+                            static_cast<int>(inner.value));
+                    }
+                    skipSpaces();
+                    if (current() != ')') {
+                        throw AlphaSyntaxError("expected ')' in memory operand",
+                                               lineNumber);
+                    }
+                    ++position;
+                } else if (word == "then" || word == "goto") {
+                    token.text = word;
+                } else {
+                    token.isOperand = true;
+                    token.operand = registerOperand(word);
+                }
+            } else {
+                // Operators, longest spelling first
+                static const char *const spellings[] = {
+                    ":=", "==", "!=", "<=", ">=", "<", ">", "+", "-",
+                    "*",  "/",  "%",  "&",  "|",  "^", "~"};
+                for (const char *spelling : spellings) {
+                    const std::string candidate(spelling);
+                    if (text.compare(position, candidate.size(), candidate) ==
+                        0) {
+                        token.text = candidate;
+                        position += candidate.size();
+                        break;
+                    }
+                }
+                if (token.text.empty()) {
+                    throw AlphaSyntaxError(
+                        std::string("unexpected character '") + c + "'",
+                        lineNumber);
+                }
+            }
+            tokens.push_back(token);
+        }
+        return tokens;
+    }
+};
+
+AlphaOperator operatorFromSpelling(const std::string &spelling) {
+    static const std::pair<const char *, AlphaOperator> table[] = {
+        {"+", AlphaOperator::ADD},  {"-", AlphaOperator::SUB},
+        {"*", AlphaOperator::MUL},  {"/", AlphaOperator::DIV},
+        {"%", AlphaOperator::MOD},  {"&", AlphaOperator::AND},
+        {"|", AlphaOperator::OR},   {"^", AlphaOperator::XOR},
+        {"~", AlphaOperator::NOT},  {"==", AlphaOperator::EQ},
+        {"!=", AlphaOperator::NE},  {"<", AlphaOperator::LT},
+        {"<=", AlphaOperator::LE},  {">", AlphaOperator::GT},
+        {">=", AlphaOperator::GE}};
+    for (const auto &[text, op] : table) {
+        if (spelling == text)
+            return op;
+    }
+    return AlphaOperator::NONE;
+}
+
+bool isArithmetic(AlphaOperator op) {
+    return op != AlphaOperator::NONE && op != AlphaOperator::NOT &&
+           !isAlphaComparison(op);
+}
+
+} // namespace
+
+Instruction decodeInstruction(const std::string &line, int lineNumber) {
+    Instruction instr;
+
+    std::string body = line;
+    if (const size_t commentPos = body.find("//");
+        commentPos != std::string::npos) {
+        instr.comment = body.substr(commentPos + 2);
+        body = body.substr(0, commentPos);
+    }
+    body = trim(body);
+
+    if (body.empty()) {
+        instr.kind = instr.comment.empty() && line.find("//") == std::string::npos
+                         ? InstructionKind::BLANK
+                         : InstructionKind::COMMENT;
+        return instr;
+    }
+
+    // Labels
+    if (body.back() == ':' && isIdentifier(trim(body.substr(0, body.size() - 1)))) {
+        instr.kind = InstructionKind::LABEL;
+        instr.label = trim(body.substr(0, body.size() - 1));
+        return instr;
+    }
+
+    // Keyword instructions
+    std::istringstream words(body);
+    std::string keyword;
+    words >> keyword;
+    std::string argument;
+    words >> argument;
+
+    auto requireLabel = [&](InstructionKind kind) {
+        if (!isIdentifier(argument)) {
+            throw AlphaSyntaxError("'" + keyword + "' requires a label",
+                                   lineNumber);
+        }
+        instr.kind = kind;
+        instr.label = argument;
+        return instr;
+    };
+
+    if (keyword == "push" || keyword == "pop") {
+        const Operand target =
+            argument.empty()
+                ? Operand::reg(0)
+                : InstructionScanner(argument, lineNumber).scan().front().operand;
+        if (!target.isRegister()) {
+            throw AlphaSyntaxError("'" + keyword + "' expects a register",
+                                   lineNumber);
+        }
+        if (keyword == "push") {
+            instr.kind = InstructionKind::PUSH;
+            instr.lhs = target;
+        } else {
+            instr.kind = InstructionKind::POP;
+            instr.dst = target;
+        }
+        return instr;
+    }
+    if (keyword.starts_with("stack") && keyword.size() == 6 &&
+        argument.empty()) {
+        instr.kind = InstructionKind::STACK_OP;
+        instr.op = operatorFromSpelling(keyword.substr(5));
+        if (!isArithmetic(instr.op)) {
+            throw AlphaSyntaxError("unknown stack operation '" + keyword + "'",
+                                   lineNumber);
+        }
+        return instr;
+    }
+    if (keyword == "call")
+        return requireLabel(InstructionKind::CALL);
+    if (keyword == "goto")
+        return requireLabel(InstructionKind::GOTO);
+    if (keyword == "return" || keyword == "syscall" || keyword == "nop") {
+        instr.kind = keyword == "return"    ? InstructionKind::RETURN
+                     : keyword == "syscall" ? InstructionKind::SYSCALL
+                                            : InstructionKind::NOP;
+        return instr;
+    }
+
+    if (keyword == "if") {
+        // if <lhs> <cmp> <rhs> then goto <label>
+        const size_t thenPos = body.find(" then ");
+        if (thenPos == std::string::npos) {
+            throw AlphaSyntaxError("expected 'then goto' in conditional",
+                                   lineNumber);
+        }
+        const auto condition =
+            InstructionScanner(body.substr(2, thenPos - 2), lineNumber).scan();
+        std::istringstream rest(body.substr(thenPos + 6));
+        std::string gotoWord;
+        rest >> gotoWord >> argument;
+        if (condition.size() != 3 || !condition[0].isOperand ||
+            condition[1].isOperand || !condition[2].isOperand ||
+            !isAlphaComparison(operatorFromSpelling(condition[1].text)) ||
+            gotoWord != "goto") {
+            throw AlphaSyntaxError("malformed conditional jump", lineNumber);
+        }
+        instr.lhs = condition[0].operand;
+        instr.op = operatorFromSpelling(condition[1].text);
+        instr.rhs = condition[2].operand;
+        return requireLabel(InstructionKind::IF_GOTO);
+    }
+
+    // Assignments: dst := src | dst := lhs op rhs | dst := op src
+    const auto tokens = InstructionScanner(body, lineNumber).scan();
+    if (tokens.size() < 3 || !tokens[0].isOperand || tokens[1].text != ":=") {
+        throw AlphaSyntaxError("unknown instruction '" + body + "'",
+                               lineNumber);
+    }
+    if (tokens[0].operand.isImmediate()) {
+        throw AlphaSyntaxError("cannot assign to a constant", lineNumber);
+    }
+    instr.dst = tokens[0].operand;
+
+    if (tokens.size() == 3 && tokens[2].isOperand) {
+        instr.kind = InstructionKind::ASSIGN;
+        instr.lhs = tokens[2].operand;
+        return instr;
+    }
+    if (tokens.size() == 4 && !tokens[2].isOperand && tokens[3].isOperand) {
+        const AlphaOperator op = operatorFromSpelling(tokens[2].text);
+        if (op == AlphaOperator::NOT) {
+            instr.kind = InstructionKind::UNARY;
+            instr.op = op;
+            instr.lhs = tokens[3].operand;
+            return instr;
+        }
+        if (op == AlphaOperator::SUB) {
+            // "a0 := - a1" is spelled as 0 - a1
+            instr.kind = InstructionKind::BINARY;
+            instr.lhs = Operand::imm(0);
+            instr.op = op;
+            instr.rhs = tokens[3].operand;
+            return instr;
+        }
+    }
+    if (tokens.size() == 5 && tokens[2].isOperand && !tokens[3].isOperand &&
+        tokens[4].isOperand && isArithmetic(operatorFromSpelling(tokens[3].text))) {
+        instr.kind = InstructionKind::BINARY;
+        instr.lhs = tokens[2].operand;
+        instr.op = operatorFromSpelling(tokens[3].text);
+        instr.rhs = tokens[4].operand;
+        return instr;
+    }
+    throw AlphaSyntaxError("malformed assignment '" + body + "'", lineNumber);
+}
+
+std::vector<Instruction> decodeAlphaProgram(const std::string &source) {
+    std::vector<Instruction> program;
+    std::istringstream stream(source);
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(stream, line)) {
+        program.push_back(decodeInstruction(line, ++lineNumber));
+    }
+    return program;
+}
+
+} // namespace calpha
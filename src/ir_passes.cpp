@@ -0,0 +1,1381 @@
+#include "ir_passes.hpp"
+#include <algorithm>
+#include <array>
+#include <map>
+#include <optional>
+#include <ranges>
+#include <set>
+#include <tuple>
+
+namespace calpha {
+
+namespace {
+
+// Upper bound for the rewrites of one pass run; every rewrite recomputes
+// the analyses
+constexpr int kMaxRewrites = 64;
+
+bool isComputation(const Instruction &instr) {
+    return instr.kind == InstructionKind::ASSIGN ||
+           instr.kind == InstructionKind::BINARY ||
+           instr.kind == InstructionKind::UNARY;
+}
+
+// ============================================================================
+// Loop helpers
+// ============================================================================
+
+// What the instructions of a loop may change
+struct LoopEffects {
+    const ControlFlowGraph *cfg{nullptr};
+    std::array<size_t, 8> registerDefs{};
+    RegisterSet referencedRegisters{0};
+    std::unordered_map<int64_t, int> storedCells; // address -> stores
+    bool unknownStore{false}; // p(aN) := ... or a syscall
+    bool hasCall{false};
+
+    // The cell may change: it is stored, or a pointer may refer to it
+    [[nodiscard]] bool mayWrite(int64_t cell) const {
+        return storedCells.contains(cell) ||
+               (unknownStore && !cfg->isDirectCell(cell));
+    }
+    // Some cell a pointer may refer to is stored
+    [[nodiscard]] bool mayWriteThroughPointer() const {
+        return unknownStore ||
+               std::ranges::any_of(storedCells, [&](const auto &entry) {
+                   return !cfg->isDirectCell(entry.first);
+               });
+    }
+};
+
+LoopEffects collectLoopEffects(const ControlFlowGraph &cfg, const Loop &loop) {
+    LoopEffects effects;
+    effects.cfg = &cfg;
+    for (size_t block : loop.blocks) {
+        for (const auto &instr : cfg.getBlocks()[block].instructions) {
+            if (instr.isTrivia())
+                continue;
+            const RegisterSet written = registersWritten(instr);
+            for (int reg = 0; reg < 8; ++reg) {
+                if ((written & registerBit(reg)) != 0)
+                    effects.registerDefs[reg]++;
+            }
+            effects.referencedRegisters |=
+                written | registersRead(instr, cfg.getCallingConvention());
+
+            if (instr.kind == InstructionKind::CALL)
+                effects.hasCall = true;
+            if (instr.kind == InstructionKind::SYSCALL ||
+                instr.dst.kind == OperandKind::MEMORY_INDIRECT)
+                effects.unknownStore = true;
+            if (instr.dst.kind == OperandKind::MEMORY)
+                effects.storedCells[instr.dst.value]++;
+        }
+    }
+    return effects;
+}
+
+// Value of the operand is the same in every iteration. Reads of `own` (the
+// register being computed) are allowed.
+bool isLoopInvariant(const Operand &operand, const LoopEffects &effects,
+                     int own = -1) {
+    switch (operand.kind) {
+    case OperandKind::NONE:
+    case OperandKind::IMMEDIATE:
+        return true;
+    case OperandKind::REGISTER:
+        return operand.value == own || effects.registerDefs[operand.value] == 0;
+    case OperandKind::MEMORY:
+        return !effects.mayWrite(operand.value);
+    case OperandKind::MEMORY_INDIRECT:
+        return !effects.mayWriteThroughPointer() &&
+               (operand.value == own ||
+                effects.registerDefs[operand.value] == 0);
+    }
+    return false;
+}
+
+// Executing the instruction where the loop would not have can not fault
+bool isSpeculatable(const Instruction &instr) {
+    if (instr.op != AlphaOperator::DIV && instr.op != AlphaOperator::MOD)
+        return true;
+    return instr.rhs.isImmediate() && instr.rhs.value != 0;
+}
+
+// The loop is entered only by falling through from the block before its
+// header, so code placed right before the header runs once per entry
+bool hasPreheaderSlot(const ControlFlowGraph &cfg, const Loop &loop) {
+    const auto &blocks = cfg.getBlocks();
+    const size_t header = loop.header;
+    if (cfg.isEntry(header) || loop.contains(header - 1))
+        return false;
+    for (size_t predecessor : blocks[header].predecessors) {
+        if (!loop.contains(predecessor) && predecessor != header - 1)
+            return false;
+    }
+    const Instruction *last = blocks[header - 1].terminator();
+    if (last != nullptr && last->isJump()) {
+        const auto labels = blocks[header].labels();
+        if (std::ranges::find(labels, last->label) != labels.end())
+            return false;
+    }
+    return blocks[header - 1].fallsThrough();
+}
+
+// Returns the block to append preheader code to, inserting an empty block
+// before the header when its predecessor also branches elsewhere. Block
+// indices from the header on shift by one in that case.
+size_t makePreheader(ControlFlowGraph &cfg, const Loop &loop) {
+    auto &blocks = cfg.getBlocks();
+    if (blocks[loop.header - 1].successors ==
+        std::vector<size_t>{loop.header})
+        return loop.header - 1;
+    blocks.insert(blocks.begin() + static_cast<std::ptrdiff_t>(loop.header),
+                  BasicBlock{});
+    return loop.header;
+}
+
+// The register holds the value computed in `block` wherever the loop is
+// left with the register live: `block` dominates all those exits
+bool holdsValueAtExits(const ControlFlowGraph &cfg, const Loop &loop,
+                       const RegisterLiveness &liveness,
+                       const std::vector<std::vector<bool>> &dominators,
+                       std::optional<size_t> block, int reg) {
+    const auto &blocks = cfg.getBlocks();
+    for (size_t member : loop.blocks) {
+        bool liveExit = false;
+        const Instruction *last = blocks[member].terminator();
+        if (last != nullptr && last->kind == InstructionKind::RETURN &&
+            (registersRead(*last, cfg.getCallingConvention()) &
+             registerBit(reg)) != 0)
+            liveExit = true;
+        for (size_t successor : blocks[member].successors) {
+            if (!loop.contains(successor) &&
+                (liveness.liveIn[successor] & registerBit(reg)) != 0)
+                liveExit = true;
+        }
+        if (liveExit && (!block || !dominators[member][*block]))
+            return false;
+    }
+    return true;
+}
+
+} // namespace
+
+// ============================================================================
+// Sparse conditional constant propagation
+// ============================================================================
+
+namespace {
+
+// Lattice value of an SSA name: not known yet (no executable definition
+// reached it so far), one constant, or overdefined
+struct ConstantValue {
+    enum class State { UNKNOWN, CONSTANT, OVERDEFINED };
+
+    State state{State::UNKNOWN};
+    int64_t value{0};
+
+    static ConstantValue of(int64_t number) {
+        return {State::CONSTANT, number};
+    }
+    static ConstantValue overdefined() {
+        return {State::OVERDEFINED, 0};
+    }
+
+    [[nodiscard]] bool isConstant() const {
+        return state == State::CONSTANT;
+    }
+    [[nodiscard]] ConstantValue meet(const ConstantValue &other) const {
+        if (state == State::UNKNOWN)
+            return other;
+        if (other.state == State::UNKNOWN)
+            return *this;
+        if (isConstant() && other.isConstant() && value == other.value)
+            return *this;
+        return overdefined();
+    }
+
+    bool operator==(const ConstantValue &other) const = default;
+};
+
+// Wegman-Zadeck propagation over the SSA form: a block is evaluated only
+// once an executable edge reaches it, and a branch whose condition is
+// constant makes only the edge it takes executable
+class ConstantPropagation {
+  public:
+    ConstantPropagation(const ControlFlowGraph &cfg, const SsaForm &ssa)
+        : cfg(cfg), blocks(cfg.getBlocks()), ssa(ssa),
+          values(ssa.definitions.size()), users(ssa.definitions.size()),
+          executableBlocks(blocks.size(), false) {
+        for (size_t name = 0; name < ssa.definitions.size(); ++name) {
+            if (ssa.definitions[name].kind == SsaForm::DefinitionKind::ENTRY)
+                values[name] = ConstantValue::overdefined();
+        }
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            for (size_t p = 0; p < ssa.phis[i].size(); ++p) {
+                for (const auto &operand : ssa.phis[i][p].operands) {
+                    users[operand.second].push_back({i, true, p});
+                }
+            }
+            for (size_t k = 0; k < ssa.instructions[i].size(); ++k) {
+                for (const auto &use : ssa.instructions[i][k].uses) {
+                    users[use.name].push_back({i, false, k});
+                }
+            }
+        }
+    }
+
+    void run() {
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            if (cfg.isEntry(i))
+                flowWorklist.emplace_back(SsaForm::kOutside, i);
+        }
+        while (!flowWorklist.empty() || !ssaWorklist.empty()) {
+            while (!flowWorklist.empty()) {
+                const auto [from, to] = flowWorklist.back();
+                flowWorklist.pop_back();
+                if (!executableEdges.insert({from, to}).second)
+                    continue;
+                for (size_t p = 0; p < ssa.phis[to].size(); ++p) {
+                    visitPhi(to, p);
+                }
+                if (executableBlocks[to])
+                    continue;
+                executableBlocks[to] = true;
+                for (size_t k = 0; k < blocks[to].instructions.size(); ++k) {
+                    visitInstruction(to, k);
+                }
+                visitExits(to);
+            }
+            while (!ssaWorklist.empty()) {
+                const SsaForm::Name name = ssaWorklist.back();
+                ssaWorklist.pop_back();
+                for (const auto &user : users[name]) {
+                    if (!executableBlocks[user.block])
+                        continue;
+                    if (user.isPhi) {
+                        visitPhi(user.block, user.index);
+                    } else {
+                        visitInstruction(user.block, user.index);
+                        if (&blocks[user.block].instructions[user.index] ==
+                            blocks[user.block].terminator())
+                            visitExits(user.block);
+                    }
+                }
+            }
+        }
+    }
+
+    [[nodiscard]] bool isExecutable(size_t block) const {
+        return executableBlocks[block];
+    }
+
+    // Constant `variable` holds when instruction `index` runs
+    [[nodiscard]] std::optional<int64_t> known(size_t block, size_t index,
+                                               int variable) const {
+        const auto &value = values[ssa.nameUsed(block, index, variable)];
+        if (!value.isConstant())
+            return std::nullopt;
+        return value.value;
+    }
+
+    // Value the operand reads; what p(aN) reads is not tracked
+    [[nodiscard]] ConstantValue read(size_t block, size_t index,
+                                     const Operand &operand) const {
+        if (operand.isImmediate())
+            return ConstantValue::of(operand.value);
+        if (operand.kind == OperandKind::MEMORY_INDIRECT)
+            return ConstantValue::overdefined();
+        const int variable = ssa.variableOf(operand);
+        if (variable < 0)
+            return ConstantValue::overdefined();
+        return values[ssa.nameUsed(block, index, variable)];
+    }
+
+    // Value an assignment computes
+    [[nodiscard]] ConstantValue evaluate(size_t block, size_t index) const {
+        const Instruction &instr = blocks[block].instructions[index];
+        using State = ConstantValue::State;
+        const ConstantValue lhs = read(block, index, instr.lhs);
+        switch (instr.kind) {
+        case InstructionKind::ASSIGN:
+            return lhs;
+        case InstructionKind::UNARY:
+            return lhs.isConstant() ? ConstantValue::of(~lhs.value) : lhs;
+        case InstructionKind::BINARY: {
+            const ConstantValue rhs = read(block, index, instr.rhs);
+            if (lhs.state == State::UNKNOWN || rhs.state == State::UNKNOWN)
+                return {};
+            if (!lhs.isConstant() || !rhs.isConstant())
+                return ConstantValue::overdefined();
+            if (auto folded =
+                    foldAlphaOperation(instr.op, lhs.value, rhs.value))
+                return ConstantValue::of(*folded);
+            return ConstantValue::overdefined();
+        }
+        default:
+            return ConstantValue::overdefined();
+        }
+    }
+
+    // Outcome of a conditional jump, if constant
+    [[nodiscard]] std::optional<bool> condition(size_t block,
+                                                size_t index) const {
+        const Instruction &instr = blocks[block].instructions[index];
+        const ConstantValue lhs = read(block, index, instr.lhs);
+        const ConstantValue rhs = read(block, index, instr.rhs);
+        if (!lhs.isConstant() || !rhs.isConstant())
+            return std::nullopt;
+        return foldAlphaComparison(instr.op, lhs.value, rhs.value);
+    }
+
+  private:
+    struct User {
+        size_t block;
+        bool isPhi;
+        size_t index;
+    };
+
+    const ControlFlowGraph &cfg;
+    const std::vector<BasicBlock> &blocks;
+    const SsaForm &ssa;
+    std::vector<ConstantValue> values; // Per SSA name
+    std::vector<std::vector<User>> users;
+    std::vector<bool> executableBlocks;
+    std::set<std::pair<size_t, size_t>> executableEdges;
+    std::vector<std::pair<size_t, size_t>> flowWorklist;
+    std::vector<SsaForm::Name> ssaWorklist;
+
+    void update(SsaForm::Name name, const ConstantValue &value) {
+        if (values[name] == value)
+            return;
+        values[name] = value;
+        ssaWorklist.push_back(name);
+    }
+
+    void visitPhi(size_t block, size_t index) {
+        const auto &phi = ssa.phis[block][index];
+        ConstantValue value;
+        for (const auto &[predecessor, name] : phi.operands) {
+            if (executableEdges.contains({predecessor, block}))
+                value = value.meet(values[name]);
+        }
+        update(phi.name, value);
+    }
+
+    void visitInstruction(size_t block, size_t index) {
+        const auto &defs = ssa.instructions[block][index].defs;
+        const Instruction &instr = blocks[block].instructions[index];
+        const bool computes = instr.kind == InstructionKind::ASSIGN ||
+                              instr.kind == InstructionKind::BINARY ||
+                              instr.kind == InstructionKind::UNARY;
+        for (const auto &def : defs) {
+            update(def.name, computes ? evaluate(block, index)
+                                      : ConstantValue::overdefined());
+        }
+    }
+
+    // Follows the edges the terminator can take. A condition that is not
+    // constant (or not known yet) takes both.
+    void visitExits(size_t block) {
+        const Instruction *last = blocks[block].terminator();
+        auto follow = [&](size_t successor) {
+            flowWorklist.emplace_back(block, successor);
+        };
+        auto jump = [&]() {
+            if (auto target = cfg.findBlock(last->label))
+                follow(*target);
+        };
+        auto fallThrough = [&]() {
+            if (block + 1 < blocks.size())
+                follow(block + 1);
+        };
+        if (last == nullptr || !last->isJump()) {
+            if (blocks[block].fallsThrough())
+                fallThrough();
+            return;
+        }
+        if (last->kind == InstructionKind::GOTO) {
+            jump();
+            return;
+        }
+        const auto index = static_cast<size_t>(
+            last - blocks[block].instructions.data());
+        const auto taken = condition(block, index);
+        if (!taken || *taken)
+            jump();
+        if (!taken || !*taken)
+            fallThrough();
+    }
+};
+
+// Replaces reads of known constants by immediates and p(aN) with a known
+// address by p(n). The Alpha_TUI forms the code generator emits keep a
+// register or cell on the left of operations and comparisons.
+bool foldConstantOperands(Instruction &instr, size_t block, size_t index,
+                          const ConstantPropagation &propagation) {
+    const Instruction original = instr;
+    auto known = [&](const Operand &operand) -> std::optional<int64_t> {
+        if (operand.kind == OperandKind::MEMORY_INDIRECT)
+            return std::nullopt;
+        const auto value = propagation.read(block, index, operand);
+        if (!value.isConstant())
+            return std::nullopt;
+        return value.value;
+    };
+    auto substitute = [&](Operand &operand, bool allowImmediate) {
+        if (operand.kind == OperandKind::MEMORY_INDIRECT) {
+            auto address = propagation.known(
+                block, index, static_cast<int>(operand.value));
+            if (address && *address >= 0)
+                operand = Operand::mem(*address);
+        } else if (allowImmediate && !operand.isImmediate()) {
+            if (auto number = known(operand))
+                operand = Operand::imm(*number);
+        }
+    };
+
+    switch (instr.kind) {
+    case InstructionKind::ASSIGN:
+    case InstructionKind::BINARY:
+    case InstructionKind::UNARY: {
+        substitute(instr.dst, false);
+        const ConstantValue value = propagation.evaluate(block, index);
+        if (value.isConstant()) {
+            Instruction folded =
+                Instruction::makeAssign(instr.dst, Operand::imm(value.value));
+            folded.comment = instr.comment;
+            instr = std::move(folded);
+            break;
+        }
+        if (instr.kind == InstructionKind::BINARY) {
+            const bool commutative =
+                instr.op == AlphaOperator::ADD ||
+                instr.op == AlphaOperator::MUL ||
+                instr.op == AlphaOperator::AND ||
+                instr.op == AlphaOperator::OR || instr.op == AlphaOperator::XOR;
+            if (commutative && known(instr.lhs) && !known(instr.rhs))
+                std::swap(instr.lhs, instr.rhs);
+            substitute(instr.lhs, false);
+            substitute(instr.rhs, true);
+        } else {
+            substitute(instr.lhs, instr.kind == InstructionKind::ASSIGN);
+        }
+        break;
+    }
+    case InstructionKind::IF_GOTO:
+        if (known(instr.lhs) && !known(instr.rhs)) {
+            std::swap(instr.lhs, instr.rhs);
+            instr.op = swapAlphaComparison(instr.op);
+        }
+        substitute(instr.lhs, false);
+        substitute(instr.rhs, true);
+        break;
+    default:
+        break;
+    }
+    return instr.kind != original.kind || instr.op != original.op ||
+           instr.dst != original.dst || instr.lhs != original.lhs ||
+           instr.rhs != original.rhs;
+}
+
+} // namespace
+
+bool propagateConstants(ControlFlowGraph &cfg) {
+    const SsaForm ssa = buildSsaForm(cfg);
+    ConstantPropagation propagation(cfg, ssa);
+    propagation.run();
+
+    auto &blocks = cfg.getBlocks();
+    bool changed = false;
+    std::vector<BasicBlock> executable;
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        if (!propagation.isExecutable(i)) {
+            changed = true;
+            continue;
+        }
+        auto &code = blocks[i].instructions;
+        std::vector<Instruction> kept;
+        for (size_t k = 0; k < code.size(); ++k) {
+            Instruction instr = code[k];
+            // Branches that always go the same way become a jump or
+            // disappear; the other side is no longer executable
+            if (instr.kind == InstructionKind::IF_GOTO) {
+                if (auto taken = propagation.condition(i, k)) {
+                    changed = true;
+                    if (!*taken)
+                        continue;
+                    Instruction jump = Instruction::makeJump(
+                        InstructionKind::GOTO, instr.label);
+                    jump.comment = instr.comment;
+                    kept.push_back(std::move(jump));
+                    continue;
+                }
+            }
+            if (foldConstantOperands(instr, i, k, propagation))
+                changed = true;
+            kept.push_back(std::move(instr));
+        }
+        blocks[i].instructions = std::move(kept);
+        executable.push_back(std::move(blocks[i]));
+    }
+    blocks = std::move(executable);
+    return changed;
+}
+
+// ============================================================================
+// Common subexpression elimination
+// ============================================================================
+
+namespace {
+
+// Value numbering over extended basic blocks: a block whose only
+// predecessor comes earlier in layout order starts with the values that
+// predecessor ends with. Equal value numbers are equal values, so a
+// computation whose number some register already holds becomes a copy and
+// a load whose number is known reads the register instead.
+class ValueNumbering {
+  public:
+    using Value = size_t;
+
+    // Memory cell as base value + offset; base kAbsolute is address 0
+    struct Location {
+        Value base;
+        int64_t offset;
+
+        auto operator<=>(const Location &) const = default;
+    };
+
+    struct State {
+        std::array<Value, 8> registers{};
+        std::map<Location, Value> memory;
+    };
+
+    static constexpr Value kAbsolute = 0;
+
+    explicit ValueNumbering(const ControlFlowGraph &cfg) : cfg(cfg) {
+        values.emplace_back(); // kAbsolute
+    }
+
+    // Registers hold unknown values, memory is unknown
+    State freshState() {
+        State state;
+        for (auto &value : state.registers) {
+            value = makeValue();
+        }
+        return state;
+    }
+
+    Value constant(int64_t number) {
+        auto [it, inserted] = constants.try_emplace(number, 0);
+        if (inserted) {
+            it->second = makeValue();
+            values[it->second].constant = number;
+        }
+        return it->second;
+    }
+
+    [[nodiscard]] std::optional<int64_t> constantOf(Value value) const {
+        return values[value].constant;
+    }
+
+    Value operation(AlphaOperator op, Value lhs, Value rhs) {
+        const auto left = values[lhs].constant;
+        const auto right = values[rhs].constant;
+        if (left && right) {
+            if (auto folded = foldAlphaOperation(op, *left, *right))
+                return constant(*folded);
+        }
+        if (right && ((*right == 0 && (op == AlphaOperator::ADD ||
+                                       op == AlphaOperator::SUB ||
+                                       op == AlphaOperator::OR ||
+                                       op == AlphaOperator::XOR)) ||
+                      (*right == 1 && (op == AlphaOperator::MUL ||
+                                       op == AlphaOperator::DIV))))
+            return lhs;
+        if (left && *left == 0 &&
+            (op == AlphaOperator::ADD || op == AlphaOperator::OR ||
+             op == AlphaOperator::XOR))
+            return rhs;
+        if (left && *left == 1 && op == AlphaOperator::MUL)
+            return rhs;
+
+        // base + k and base - k name the base and the offset, so nested
+        // member offsets meet in one value
+        if (op == AlphaOperator::ADD && left && !right)
+            std::swap(lhs, rhs);
+        if ((op == AlphaOperator::ADD || op == AlphaOperator::SUB) &&
+            values[rhs].constant && !values[lhs].constant) {
+            const int64_t step = op == AlphaOperator::ADD
+                                     ? *values[rhs].constant
+                                     : -*values[rhs].constant;
+            const auto [base, offset] = addressOf(lhs);
+            return offsetValue(base, offset + step);
+        }
+
+        const bool commutative =
+            op == AlphaOperator::ADD || op == AlphaOperator::MUL ||
+            op == AlphaOperator::AND || op == AlphaOperator::OR ||
+            op == AlphaOperator::XOR;
+        if (commutative && rhs < lhs)
+            std::swap(lhs, rhs);
+        return lookup({op, lhs, rhs});
+    }
+
+    Value complement(Value operand) {
+        if (auto number = values[operand].constant)
+            return constant(~*number);
+        return lookup({AlphaOperator::NOT, operand, 0});
+    }
+
+    // Location an operand reads or writes; nullopt for registers and
+    // immediates
+    [[nodiscard]] std::optional<Location> locationOf(const Operand &operand,
+                                                     const State &state) const {
+        if (operand.kind == OperandKind::MEMORY)
+            return Location{kAbsolute, operand.value};
+        if (operand.kind == OperandKind::MEMORY_INDIRECT) {
+            const Value address = state.registers[operand.value];
+            if (auto number = values[address].constant)
+                return Location{kAbsolute, *number};
+            const auto [base, offset] = addressOf(address);
+            return Location{base, offset};
+        }
+        return std::nullopt;
+    }
+
+    // Value of an operand, numbering unknown memory on first read
+    Value read(const Operand &operand, State &state) {
+        switch (operand.kind) {
+        case OperandKind::REGISTER:
+            return state.registers[operand.value];
+        case OperandKind::IMMEDIATE:
+            return constant(operand.value);
+        case OperandKind::MEMORY:
+        case OperandKind::MEMORY_INDIRECT: {
+            const Location location = *locationOf(operand, state);
+            auto [it, inserted] = state.memory.try_emplace(location, 0);
+            if (inserted)
+                it->second = makeValue();
+            return it->second;
+        }
+        case OperandKind::NONE:
+            break;
+        }
+        return makeValue();
+    }
+
+    void store(const Location &location, Value value, State &state) const {
+        std::erase_if(state.memory, [&](const auto &entry) {
+            return mayAlias(entry.first, location);
+        });
+        state.memory[location] = value;
+    }
+
+    // A syscall may write any cell a pointer can reach
+    void forgetPointerMemory(State &state) const {
+        std::erase_if(state.memory, [&](const auto &entry) {
+            return entry.first.base != kAbsolute ||
+                   !cfg.isDirectCell(entry.first.offset);
+        });
+    }
+
+    Value makeValue() {
+        values.emplace_back();
+        return values.size() - 1;
+    }
+
+  private:
+    struct Info {
+        std::optional<int64_t> constant;
+        std::optional<Location> address; // Set for base + offset values
+    };
+
+    const ControlFlowGraph &cfg;
+    std::vector<Info> values;
+    std::map<int64_t, Value> constants;
+    std::map<std::tuple<AlphaOperator, Value, Value>, Value> expressions;
+    std::map<Location, Value> offsets;
+
+    Value lookup(const std::tuple<AlphaOperator, Value, Value> &key) {
+        auto [it, inserted] = expressions.try_emplace(key, 0);
+        if (inserted)
+            it->second = makeValue();
+        return it->second;
+    }
+
+    [[nodiscard]] Location addressOf(Value value) const {
+        return values[value].address.value_or(Location{value, 0});
+    }
+
+    Value offsetValue(Value base, int64_t offset) {
+        if (offset == 0)
+            return base;
+        auto [it, inserted] = offsets.try_emplace(Location{base, offset}, 0);
+        if (inserted) {
+            it->second = makeValue();
+            values[it->second].address = Location{base, offset};
+        }
+        return it->second;
+    }
+
+    // Cells off the same base differ when their offsets do; pointers never
+    // reach direct cells
+    [[nodiscard]] bool mayAlias(const Location &a, const Location &b) const {
+        if (a.base == b.base)
+            return a.offset == b.offset;
+        if (a.base == kAbsolute)
+            return !cfg.isDirectCell(a.offset);
+        if (b.base == kAbsolute)
+            return !cfg.isDirectCell(b.offset);
+        return true;
+    }
+};
+
+// Register other than `except` holding the value
+std::optional<int> findHolder(const ValueNumbering::State &state,
+                              ValueNumbering::Value value, int except = -1) {
+    for (int reg = 0; reg < 8; ++reg) {
+        if (reg != except && state.registers[reg] == value)
+            return reg;
+    }
+    return std::nullopt;
+}
+
+// Rewrites one instruction given the state before it and updates the state;
+// returns false if the instruction can be dropped
+bool numberInstruction(Instruction &instr, ValueNumbering &numbering,
+                       ValueNumbering::State &state, bool &changed) {
+    using Value = ValueNumbering::Value;
+
+    // A memory operand whose value a register holds reads the register
+    auto useRegister = [&](Operand &operand, bool allowImmediate) {
+        if (!operand.isMemory())
+            return;
+        const Value value = numbering.read(operand, state);
+        if (auto reg = findHolder(state, value)) {
+            operand = Operand::reg(*reg);
+            changed = true;
+        } else if (auto number = numbering.constantOf(value);
+                   number && allowImmediate) {
+            operand = Operand::imm(*number);
+            changed = true;
+        }
+    };
+
+    switch (instr.kind) {
+    case InstructionKind::ASSIGN:
+    case InstructionKind::BINARY:
+    case InstructionKind::UNARY: {
+        Value value;
+        if (instr.kind == InstructionKind::ASSIGN) {
+            value = numbering.read(instr.lhs, state);
+        } else if (instr.kind == InstructionKind::UNARY) {
+            value = numbering.complement(numbering.read(instr.lhs, state));
+        } else {
+            value = numbering.operation(instr.op,
+                                        numbering.read(instr.lhs, state),
+                                        numbering.read(instr.rhs, state));
+        }
+        const auto location = numbering.locationOf(instr.dst, state);
+
+        if (instr.dst.isRegister()) {
+            const int reg = static_cast<int>(instr.dst.value);
+            if (state.registers[reg] == value) {
+                changed = true;
+                return false;
+            }
+            auto number = numbering.constantOf(value);
+            auto holder = findHolder(state, value, reg);
+            const bool isCopy = instr.kind == InstructionKind::ASSIGN &&
+                                !instr.lhs.isMemory();
+            if (!isCopy && (number || holder)) {
+                instr = Instruction::makeAssign(
+                    instr.dst, number ? Operand::imm(*number)
+                                      : Operand::reg(*holder));
+                changed = true;
+            }
+        } else if (location) {
+            if (auto it = state.memory.find(*location);
+                it != state.memory.end() && it->second == value) {
+                changed = true;
+                return false;
+            }
+        }
+        if (instr.kind == InstructionKind::BINARY) {
+            useRegister(instr.lhs, false);
+            useRegister(instr.rhs, true);
+        } else if (instr.lhs.isMemory()) {
+            useRegister(instr.lhs, instr.kind == InstructionKind::ASSIGN);
+        }
+
+        if (instr.dst.isRegister())
+            state.registers[instr.dst.value] = value;
+        else if (location)
+            numbering.store(*location, value, state);
+        return true;
+    }
+    case InstructionKind::IF_GOTO:
+        useRegister(instr.lhs, false);
+        useRegister(instr.rhs, true);
+        return true;
+    case InstructionKind::PUSH:
+        useRegister(instr.lhs, false);
+        return true;
+    case InstructionKind::POP: {
+        const Operand dst = instr.dst.isNone() ? Operand::reg(0) : instr.dst;
+        const Value value = numbering.makeValue();
+        if (dst.isRegister())
+            state.registers[dst.value] = value;
+        else if (auto location = numbering.locationOf(dst, state))
+            numbering.store(*location, value, state);
+        return true;
+    }
+    case InstructionKind::SYSCALL:
+        state.registers[0] = numbering.makeValue();
+        numbering.forgetPointerMemory(state);
+        return true;
+    case InstructionKind::CALL:
+        state = numbering.freshState();
+        return true;
+    default:
+        return true;
+    }
+}
+
+} // namespace
+
+bool eliminateCommonSubexpressions(ControlFlowGraph &cfg) {
+    auto &blocks = cfg.getBlocks();
+    ValueNumbering numbering(cfg);
+    std::vector<ValueNumbering::State> exitStates(blocks.size());
+    bool changed = false;
+
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        const auto &predecessors = blocks[i].predecessors;
+        ValueNumbering::State state =
+            predecessors.size() == 1 && predecessors[0] < i && !cfg.isEntry(i)
+                ? exitStates[predecessors[0]]
+                : numbering.freshState();
+
+        std::vector<Instruction> code;
+        for (auto instr : blocks[i].instructions) {
+            if (numberInstruction(instr, numbering, state, changed))
+                code.push_back(std::move(instr));
+        }
+        blocks[i].instructions = std::move(code);
+        exitStates[i] = std::move(state);
+    }
+    return changed;
+}
+
+// ============================================================================
+// Loop-invariant code motion
+// ============================================================================
+
+namespace {
+
+// Consecutive computations of one register starting at `start`, the first
+// from invariant operands only and the rest from invariant operands and
+// the register itself (a1 := p(5) + 2; a1 := p(a1))
+std::vector<size_t> invariantSequence(const std::vector<Instruction> &code,
+                                      size_t start,
+                                      const LoopEffects &effects) {
+    const Instruction &first = code[start];
+    if (!isComputation(first) || !first.dst.isRegister() ||
+        !isSpeculatable(first) || !isLoopInvariant(first.lhs, effects) ||
+        !isLoopInvariant(first.rhs, effects))
+        return {};
+
+    const int reg = static_cast<int>(first.dst.value);
+    std::vector<size_t> sequence{start};
+    for (size_t i = start + 1; i < code.size(); ++i) {
+        const Instruction &next = code[i];
+        if (next.isTrivia())
+            continue;
+        if (!isComputation(next) || !next.dst.isRegister(reg) ||
+            !isSpeculatable(next) || !isLoopInvariant(next.lhs, effects, reg) ||
+            !isLoopInvariant(next.rhs, effects, reg))
+            break;
+        sequence.push_back(i);
+    }
+    return sequence;
+}
+
+bool hoistOneInvariant(ControlFlowGraph &cfg) {
+    const auto dominators = computeDominators(cfg);
+    const auto liveness = computeRegisterLiveness(cfg);
+
+    for (const Loop &loop : findLoops(cfg, dominators)) {
+        if (!hasPreheaderSlot(cfg, loop))
+            continue;
+        const LoopEffects effects = collectLoopEffects(cfg, loop);
+        if (effects.hasCall)
+            continue;
+
+        for (size_t block : loop.blocks) {
+            const auto &code = cfg.getBlocks()[block].instructions;
+            for (size_t i = 0; i < code.size(); ++i) {
+                const auto sequence = invariantSequence(code, i, effects);
+                if (sequence.empty())
+                    continue;
+                const int reg = static_cast<int>(code[i].dst.value);
+                // The sequence has to be the register's only definition in
+                // the loop, and no value from before the loop is read
+                if (effects.registerDefs[reg] != sequence.size() ||
+                    (liveness.liveIn[loop.header] & registerBit(reg)) != 0 ||
+                    !holdsValueAtExits(cfg, loop, liveness, dominators, block,
+                                       reg))
+                    continue;
+
+                std::vector<Instruction> hoisted;
+                for (size_t index : sequence) {
+                    hoisted.push_back(code[index]);
+                }
+                auto &source = cfg.getBlocks()[block].instructions;
+                for (size_t index : std::ranges::reverse_view(sequence)) {
+                    source.erase(source.begin() +
+                                 static_cast<std::ptrdiff_t>(index));
+                }
+                const size_t preheader = makePreheader(cfg, loop);
+                auto &target = cfg.getBlocks()[preheader].instructions;
+                target.insert(target.end(), hoisted.begin(), hoisted.end());
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+bool hoistLoopInvariants(ControlFlowGraph &cfg) {
+    bool changed = false;
+    for (int rewrite = 0; rewrite < kMaxRewrites; ++rewrite) {
+        if (!hoistOneInvariant(cfg))
+            break;
+        cfg.rebuildEdges();
+        changed = true;
+    }
+    return changed;
+}
+
+// ============================================================================
+// Induction variable strength reduction
+// ============================================================================
+
+namespace {
+
+// A memory cell stored once per iteration as itself plus a constant
+struct InductionCell {
+    size_t block;
+    size_t store; // Index of the store within the block
+    size_t step;  // Index of the instruction computing cell + step
+    int64_t increment;
+};
+
+std::optional<int64_t> constantStep(const Instruction &instr, int64_t cell) {
+    if (instr.kind != InstructionKind::BINARY || instr.lhs != Operand::mem(cell) ||
+        !instr.rhs.isImmediate())
+        return std::nullopt;
+    if (instr.op == AlphaOperator::ADD)
+        return instr.rhs.value;
+    if (instr.op == AlphaOperator::SUB)
+        return -instr.rhs.value;
+    return std::nullopt;
+}
+
+std::unordered_map<int64_t, InductionCell>
+findInductionCells(const ControlFlowGraph &cfg, const Loop &loop,
+                   const LoopEffects &effects) {
+    std::unordered_map<int64_t, InductionCell> cells;
+    for (size_t block : loop.blocks) {
+        const auto &code = cfg.getBlocks()[block].instructions;
+        std::optional<size_t> previous;
+        for (size_t i = 0; i < code.size(); ++i) {
+            const Instruction &instr = code[i];
+            if (instr.isTrivia())
+                continue;
+            // Stores through pointers must not reach the cell
+            if (instr.dst.kind == OperandKind::MEMORY &&
+                effects.storedCells.at(instr.dst.value) == 1 &&
+                (!effects.unknownStore || cfg.isDirectCell(instr.dst.value))) {
+                const int64_t cell = instr.dst.value;
+                // p(n) := p(n) + k, or aX := p(n) + k; p(n) := aX
+                if (auto step = constantStep(instr, cell)) {
+                    cells[cell] = {block, i, i, *step};
+                } else if (previous && instr.kind == InstructionKind::ASSIGN &&
+                           instr.lhs.isRegister() &&
+                           code[*previous].dst == instr.lhs) {
+                    if (auto step = constantStep(code[*previous], cell))
+                        cells[cell] = {block, i, *previous, *step};
+                }
+            }
+            previous = i;
+        }
+    }
+    return cells;
+}
+
+// The register computed by code[index] is read as p(aN) before the block
+// changes it again
+bool isUsedAsAddress(const std::vector<Instruction> &code, size_t index) {
+    const auto reg = static_cast<int>(code[index].dst.value);
+    for (size_t i = index + 1; i < code.size(); ++i) {
+        for (const Operand *operand :
+             {&code[i].dst, &code[i].lhs, &code[i].rhs}) {
+            if (*operand == Operand::indirect(reg))
+                return true;
+        }
+        if (code[i].writesRegister(reg))
+            return false;
+    }
+    return false;
+}
+
+// Register no loop instruction touches and that is dead around the loop
+std::optional<int> findFreeRegister(const ControlFlowGraph &cfg,
+                                    const Loop &loop,
+                                    const LoopEffects &effects,
+                                    const RegisterLiveness &liveness,
+                                    const std::vector<std::vector<bool>> &dominators) {
+    for (int reg = 7; reg >= 1; --reg) {
+        if ((effects.referencedRegisters & registerBit(reg)) == 0 &&
+            (liveness.liveIn[loop.header] & registerBit(reg)) == 0 &&
+            holdsValueAtExits(cfg, loop, liveness, dominators, std::nullopt,
+                              reg))
+            return reg;
+    }
+    return std::nullopt;
+}
+
+bool reduceOneInduction(ControlFlowGraph &cfg) {
+    const auto dominators = computeDominators(cfg);
+    const auto liveness = computeRegisterLiveness(cfg);
+
+    for (const Loop &loop : findLoops(cfg, dominators)) {
+        if (!hasPreheaderSlot(cfg, loop))
+            continue;
+        const LoopEffects effects = collectLoopEffects(cfg, loop);
+        if (effects.hasCall)
+            continue;
+        const auto cells = findInductionCells(cfg, loop, effects);
+        const auto reg =
+            findFreeRegister(cfg, loop, effects, liveness, dominators);
+        if (cells.empty() || !reg)
+            continue;
+
+        for (size_t block : loop.blocks) {
+            const auto &code = cfg.getBlocks()[block].instructions;
+            for (size_t i = 0; i < code.size(); ++i) {
+                const Instruction &instr = code[i];
+                if (instr.kind != InstructionKind::BINARY ||
+                    !instr.dst.isRegister())
+                    continue;
+
+                // i * c, base + i with a base that is not a constant, or
+                // an element address c + i
+                const InductionCell *induction = nullptr;
+                Operand other;
+                for (const auto &[operand, rest] :
+                     {std::pair{instr.lhs, instr.rhs},
+                      std::pair{instr.rhs, instr.lhs}}) {
+                    auto it = operand.kind == OperandKind::MEMORY
+                                  ? cells.find(operand.value)
+                                  : cells.end();
+                    if (it != cells.end() && rest != operand) {
+                        induction = &it->second;
+                        other = rest;
+                        break;
+                    }
+                }
+                if (induction == nullptr ||
+                    (block == induction->block && i == induction->step))
+                    continue;
+                int64_t scale = 0;
+                if (instr.op == AlphaOperator::MUL && other.isImmediate()) {
+                    scale = other.value;
+                } else if (instr.op == AlphaOperator::ADD &&
+                           (other.isImmediate()
+                                ? isUsedAsAddress(code, i)
+                                : isLoopInvariant(other, effects))) {
+                    scale = 1;
+                } else {
+                    continue;
+                }
+
+                // The register tracks the expression: computed before the
+                // loop and stepped right after every store to the cell
+                const Operand tracker = Operand::reg(*reg);
+                Instruction initial = instr;
+                initial.dst = tracker;
+                initial.comment = " Induction expression";
+
+                const int64_t delta = induction->increment * scale;
+                Instruction step = Instruction::makeBinary(
+                    tracker, tracker,
+                    delta < 0 ? AlphaOperator::SUB : AlphaOperator::ADD,
+                    Operand::imm(delta < 0 ? -delta : delta));
+                step.comment = " Step induction expression";
+
+                // Every computation of the same expression reads the
+                // register instead
+                auto &blocks = cfg.getBlocks();
+                for (size_t member : loop.blocks) {
+                    for (auto &derived : blocks[member].instructions) {
+                        if (derived.kind == InstructionKind::BINARY &&
+                            derived.dst.isRegister() &&
+                            derived.op == initial.op &&
+                            derived.lhs == initial.lhs &&
+                            derived.rhs == initial.rhs)
+                            derived =
+                                Instruction::makeAssign(derived.dst, tracker);
+                    }
+                }
+                auto &storeBlock = blocks[induction->block].instructions;
+                storeBlock.insert(storeBlock.begin() +
+                                      static_cast<std::ptrdiff_t>(
+                                          induction->store + 1),
+                                  step);
+
+                const size_t preheader = makePreheader(cfg, loop);
+                cfg.getBlocks()[preheader].instructions.push_back(initial);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+bool reduceInductionStrength(ControlFlowGraph &cfg) {
+    bool changed = false;
+    for (int rewrite = 0; rewrite < kMaxRewrites; ++rewrite) {
+        if (!reduceOneInduction(cfg))
+            break;
+        cfg.rebuildEdges();
+        changed = true;
+    }
+    return changed;
+}
+
+// ============================================================================
+// Dead code elimination
+// ============================================================================
+
+bool removeUnreachableBlocks(ControlFlowGraph &cfg) {
+    // Without the program entry every block may be one
+    if (!cfg.findBlock("global::main"))
+        return false;
+    const auto reachable = cfg.reachableFrom("global::main");
+    auto &blocks = cfg.getBlocks();
+    std::vector<BasicBlock> kept;
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        if (reachable[i])
+            kept.push_back(std::move(blocks[i]));
+    }
+    const bool changed = kept.size() != blocks.size();
+    blocks = std::move(kept);
+    return changed;
+}
+
+namespace {
+
+using CellSet = std::set<int64_t>;
+
+void addCellsRead(const Instruction &instr, const ControlFlowGraph &cfg,
+                  CellSet &cells) {
+    for (const Operand *operand : {&instr.lhs, &instr.rhs}) {
+        if (operand->kind == OperandKind::MEMORY &&
+            cfg.isDirectCell(operand->value))
+            cells.insert(operand->value);
+    }
+}
+
+// Liveness of registers and direct cells. A call reads the cells the code
+// it reaches reads; a return passes on the cells live after the calls of
+// its function, or none when the program entry returns. Returns outside
+// any known function keep every cell live.
+class StoreLiveness {
+  public:
+    struct State {
+        RegisterSet registers{0};
+        CellSet cells;
+
+        bool operator==(const State &) const = default;
+    };
+
+    explicit StoreLiveness(const ControlFlowGraph &cfg)
+        : cfg(cfg), blocks(cfg.getBlocks()), liveIn(blocks.size()),
+          liveOut(blocks.size()), owners(blocks.size()) {
+        for (const auto &block : blocks) {
+            for (const auto &instr : block.instructions) {
+                for (const Operand *operand :
+                     {&instr.dst, &instr.lhs, &instr.rhs}) {
+                    if (operand->kind == OperandKind::MEMORY &&
+                        cfg.isDirectCell(operand->value))
+                        allCells.insert(operand->value);
+                }
+                if (instr.kind == InstructionKind::CALL)
+                    addFunction(instr.label);
+            }
+        }
+        if (cfg.findBlock("global::main")) {
+            exitCells.try_emplace("global::main");
+            addFunction("global::main");
+        }
+    }
+
+    void compute() {
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (size_t i = blocks.size(); i-- > 0;) {
+                State live = exitState(i);
+                liveOut[i] = live;
+                for (const auto &instr :
+                     std::ranges::reverse_view(blocks[i].instructions)) {
+                    if (instr.kind == InstructionKind::CALL) {
+                        auto &exit = exitCells[instr.label];
+                        const size_t known = exit.size();
+                        exit.insert(live.cells.begin(), live.cells.end());
+                        changed = changed || exit.size() != known;
+                    }
+                    transfer(instr, live);
+                }
+                if (live != liveIn[i]) {
+                    liveIn[i] = std::move(live);
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    [[nodiscard]] const State &getLiveOut(size_t block) const {
+        return liveOut[block];
+    }
+
+    // Steps `live` from after the instruction to before it
+    void transfer(const Instruction &instr, State &live) const {
+        live.registers = static_cast<RegisterSet>(
+            (live.registers & ~registersWritten(instr)) |
+            registersRead(instr, cfg.getCallingConvention()));
+        if (instr.kind == InstructionKind::CALL) {
+            const auto &read = calleeReads.at(instr.label);
+            live.cells.insert(read.begin(), read.end());
+            return;
+        }
+        if (instr.dst.kind == OperandKind::MEMORY)
+            live.cells.erase(instr.dst.value);
+        addCellsRead(instr, cfg, live.cells);
+    }
+
+  private:
+    const ControlFlowGraph &cfg;
+    const std::vector<BasicBlock> &blocks;
+    std::vector<State> liveIn;
+    std::vector<State> liveOut;
+    CellSet allCells;
+    std::map<std::string, CellSet> calleeReads;
+    std::map<std::string, CellSet> exitCells; // Live after the function
+    std::vector<std::vector<std::string>> owners; // Functions per block
+
+    void addFunction(const std::string &label) {
+        auto [it, inserted] = calleeReads.try_emplace(label);
+        if (!inserted)
+            return;
+        const auto reached = cfg.reachableFrom(label);
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            if (!reached[i])
+                continue;
+            for (const auto &instr : blocks[i].instructions) {
+                addCellsRead(instr, cfg, it->second);
+            }
+        }
+
+        // The function's own blocks, without those of its callees
+        auto entry = cfg.findBlock(label);
+        if (!entry)
+            return;
+        std::vector<bool> body(blocks.size(), false);
+        std::vector<size_t> worklist{*entry};
+        body[*entry] = true;
+        while (!worklist.empty()) {
+            const size_t block = worklist.back();
+            worklist.pop_back();
+            owners[block].push_back(label);
+            for (size_t successor : blocks[block].successors) {
+                if (!body[successor]) {
+                    body[successor] = true;
+                    worklist.push_back(successor);
+                }
+            }
+        }
+    }
+
+    State exitState(size_t block) {
+        State live;
+        for (size_t successor : blocks[block].successors) {
+            live.registers |= liveIn[successor].registers;
+            live.cells.insert(liveIn[successor].cells.begin(),
+                              liveIn[successor].cells.end());
+        }
+        const Instruction *last = blocks[block].terminator();
+        if (last == nullptr || last->kind != InstructionKind::RETURN)
+            return live;
+        if (owners[block].empty())
+            live.cells.insert(allCells.begin(), allCells.end());
+        for (const auto &function : owners[block]) {
+            const auto &exit = exitCells[function];
+            live.cells.insert(exit.begin(), exit.end());
+        }
+        return live;
+    }
+};
+
+// The instruction only computes a value nothing reads
+bool isDeadStore(const Instruction &instr, const StoreLiveness::State &live,
+                 const ControlFlowGraph &cfg) {
+    if (!isComputation(instr) || !isSpeculatable(instr))
+        return false;
+    if (instr.dst.isRegister())
+        return (live.registers & registerBit(instr.dst.value)) == 0;
+    return instr.dst.kind == OperandKind::MEMORY &&
+           cfg.isDirectCell(instr.dst.value) &&
+           !live.cells.contains(instr.dst.value);
+}
+
+} // namespace
+
+bool eliminateDeadStores(ControlFlowGraph &cfg) {
+    bool changed = false;
+    for (int rewrite = 0; rewrite < kMaxRewrites; ++rewrite) {
+        StoreLiveness liveness(cfg);
+        liveness.compute();
+
+        bool removed = false;
+        for (size_t i = 0; i < cfg.getBlocks().size(); ++i) {
+            auto &code = cfg.getBlocks()[i].instructions;
+            StoreLiveness::State live = liveness.getLiveOut(i);
+            std::vector<Instruction> kept;
+            for (auto &instr : std::ranges::reverse_view(code)) {
+                if (isDeadStore(instr, live, cfg)) {
+                    removed = true;
+                    continue;
+                }
+                liveness.transfer(instr, live);
+                kept.push_back(std::move(instr));
+            }
+            std::ranges::reverse(kept);
+            code = std::move(kept);
+        }
+        if (!removed)
+            break;
+        changed = true;
+    }
+    return changed;
+}
+
+} // namespace calpha
@@ -264,10 +264,20 @@ Token Lexer::scanOperator() {
                      sourceFile);
     case '&':
         advance();
+        if (currentChar() == '&') {
+            advance();
+            return Token(TokenType::LOGICAL_AND, "&&", startLine, startColumn,
+                         sourceFile);
+        }
         return Token(TokenType::BITWISE_AND, "&", startLine, startColumn,
                      sourceFile);
     case '|':
         advance();
+        if (currentChar() == '|') {
+            advance();
+            return Token(TokenType::LOGICAL_OR, "||", startLine, startColumn,
+                         sourceFile);
+        }
         return Token(TokenType::BITWISE_OR, "|", startLine, startColumn,
                      sourceFile);
     case '^':
@@ -427,6 +437,8 @@ std::string Lexer::tokenTypeToString(TokenType type) {
         {TokenType::BITWISE_OR, "BITWISE_OR"},
         {TokenType::BITWISE_XOR, "BITWISE_XOR"},
         {TokenType::BITWISE_NOT, "BITWISE_NOT"},
+        {TokenType::LOGICAL_AND, "LOGICAL_AND"},
+        {TokenType::LOGICAL_OR, "LOGICAL_OR"},
         {TokenType::ASSIGN, "ASSIGN"},
         {TokenType::REFERENCE, "REFERENCE"},
         {TokenType::DEREFERENCE, "DEREFERENCE"},
@@ -162,7 +162,7 @@ std::unique_ptr<Expression> Parser::parseExpression() {
 std::unique_ptr<Expression> Parser::parseLogicalOr() {
     auto expr = parseLogicalAnd();
 
-    while (match(TokenType::BITWISE_OR)) {
+    while (match(TokenType::LOGICAL_OR)) {
         TokenType op = tokens[position - 1].type;
         int line = tokens[position - 1].line;
         int column = tokens[position - 1].column;
@@ -177,7 +177,7 @@ std::unique_ptr<Expression> Parser::parseLogicalOr() {
 std::unique_ptr<Expression> Parser::parseLogicalAnd() {
     auto expr = parseEquality();
 
-    while (match(TokenType::BITWISE_AND)) {
+    while (match(TokenType::LOGICAL_AND)) {
         TokenType op = tokens[position - 1].type;
         int line = tokens[position - 1].line;
         int column = tokens[position - 1].column;
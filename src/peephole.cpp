@@ -0,0 +1,440 @@
+#include "peephole.hpp"
+#include <algorithm>
+#include <optional>
+
+namespace calpha {
+
+// ============================================================================
+// PeepholeContext Implementation
+// ============================================================================
+
+PeepholeContext::PeepholeContext(const std::vector<Instruction> &program,
+                                 const PeepholeOptions &options)
+    : program(program), options(options) {
+    for (size_t i = 0; i < program.size(); ++i) {
+        const Instruction &instr = program[i];
+        if (instr.kind == InstructionKind::LABEL) {
+            labelIndex[instr.label] = i;
+        } else if (instr.kind == InstructionKind::CALL || instr.isJump()) {
+            labelReferences[instr.label]++;
+        }
+    }
+}
+
+bool PeepholeContext::isRegisterDead(size_t from, int reg) const {
+    // Depth-first walk over all paths leaving `from`. Every path has to
+    // redefine the register before any read; anything we cannot follow
+    // counts as a read.
+    constexpr int kBudget = 512;
+    int budget = kBudget;
+    std::vector<size_t> worklist{from};
+    std::unordered_set<size_t> visited;
+
+    auto followLabel = [&](const std::string &label) {
+        if (auto it = labelIndex.find(label); it != labelIndex.end()) {
+            worklist.push_back(it->second);
+            return true;
+        }
+        return label == "END"; // Halting: nothing reads the register
+    };
+
+    while (!worklist.empty()) {
+        size_t index = worklist.back();
+        worklist.pop_back();
+
+        while (index < program.size()) {
+            if (!visited.insert(index).second)
+                break;
+            if (--budget <= 0)
+                return false;
+
+            const Instruction &instr = program[index];
+            if (instr.readsRegister(reg))
+                return false;
+            if (instr.writesRegister(reg))
+                break;
+
+            bool fallsThrough = true;
+            switch (instr.kind) {
+            case InstructionKind::GOTO:
+                if (!followLabel(instr.label))
+                    return false;
+                fallsThrough = false;
+                break;
+            case InstructionKind::IF_GOTO:
+                if (!followLabel(instr.label))
+                    return false;
+                break;
+            case InstructionKind::CALL:
+                if (reg >= 1 && reg <= options.argumentRegisters)
+                    return false;
+                // The callee may read the register before writing it
+                if (!followLabel(instr.label))
+                    return false;
+                break;
+            case InstructionKind::RETURN:
+                if (reg == 0 && options.returnValueInRegister)
+                    return false;
+                fallsThrough = false;
+                break;
+            default:
+                break;
+            }
+            if (!fallsThrough)
+                break;
+            ++index;
+        }
+    }
+    return true;
+}
+
+bool PeepholeContext::isRegisterDeadAt(const std::string &label,
+                                       int reg) const {
+    if (auto it = labelIndex.find(label); it != labelIndex.end())
+        return isRegisterDead(it->second, reg);
+    return label == "END";
+}
+
+std::vector<std::string> PeepholeContext::labelsAfter(size_t index) const {
+    std::vector<std::string> labels;
+    for (size_t i = index + 1; i < program.size(); ++i) {
+        if (program[i].isTrivia())
+            continue;
+        if (program[i].kind != InstructionKind::LABEL)
+            break;
+        labels.push_back(program[i].label);
+    }
+    return labels;
+}
+
+bool PeepholeContext::isLabelReferenced(const std::string &label) const {
+    return labelReferences.contains(label);
+}
+
+// ============================================================================
+// Rule table
+// ============================================================================
+
+namespace {
+
+using Window = std::vector<const Instruction *>;
+
+bool isRegisterMove(const Instruction &instr) {
+    return instr.kind == InstructionKind::ASSIGN && instr.dst.isRegister() &&
+           instr.lhs.isRegister();
+}
+
+// Plain data movement / arithmetic without stack or control effects
+bool isComputation(const Instruction &instr) {
+    return instr.kind == InstructionKind::ASSIGN ||
+           instr.kind == InstructionKind::BINARY ||
+           instr.kind == InstructionKind::UNARY;
+}
+
+// main, also under its qualified name before the program is emitted
+bool isEntryLabel(const std::string &label) {
+    return label == "main" || label == "global::main";
+}
+
+// A read through p(aN) may reach any cell
+bool readsMemoryCell(const Instruction &instr, const Operand &cell) {
+    auto mayRead = [&](const Operand &operand) {
+        return operand == cell ||
+               operand.kind == OperandKind::MEMORY_INDIRECT;
+    };
+    return mayRead(instr.lhs) || mayRead(instr.rhs);
+}
+
+// Replaces reads of register `reg` in source operand positions of `instr`
+// by `value`. Address registers of p(aN) are only replaced by another
+// register since Alpha_TUI accepts nothing else there. Returns false if
+// any read remains.
+bool substituteRegister(Instruction &instr, int reg, const Operand &value) {
+    auto replace = [&](Operand &operand, bool allowImmediate) {
+        if (operand.kind == OperandKind::MEMORY_INDIRECT &&
+            operand.value == reg && value.isRegister()) {
+            operand.value = value.value;
+            return;
+        }
+        if (!operand.isRegister(reg))
+            return;
+        if (value.isImmediate() && !allowImmediate)
+            return;
+        operand = value;
+    };
+    if (instr.dst.kind == OperandKind::MEMORY_INDIRECT)
+        replace(instr.dst, false);
+
+    switch (instr.kind) {
+    case InstructionKind::ASSIGN:
+        replace(instr.lhs, true);
+        break;
+    case InstructionKind::BINARY:
+        // A memory destination already needs one register source
+        if (!value.isMemory() || instr.dst.isRegister()) {
+            replace(instr.lhs, false);
+        }
+        replace(instr.rhs, true);
+        break;
+    case InstructionKind::IF_GOTO:
+        replace(instr.lhs, false);
+        replace(instr.rhs, true);
+        break;
+    default:
+        break;
+    }
+    return !instr.readsRegister(reg);
+}
+
+} // namespace
+
+std::vector<PeepholeRule> PeepholeOptimizer::createDefaultRules() {
+    std::vector<PeepholeRule> table;
+
+    // aX := aX
+    table.push_back({"self-move", 1,
+                     [](const PeepholeContext &, const Window &w, size_t,
+                        std::vector<Instruction> &) {
+                         return isRegisterMove(*w[0]) &&
+                                w[0]->dst == w[0]->lhs;
+                     }});
+
+    // push aX; pop aY  =>  aY := aX
+    table.push_back({"push-pop", 2,
+                     [](const PeepholeContext &, const Window &w, size_t,
+                        std::vector<Instruction> &out) {
+                         if (w[0]->kind != InstructionKind::PUSH ||
+                             w[1]->kind != InstructionKind::POP)
+                             return false;
+                         const Operand src =
+                             w[0]->lhs.isNone() ? Operand::reg(0) : w[0]->lhs;
+                         const Operand dst =
+                             w[1]->dst.isNone() ? Operand::reg(0) : w[1]->dst;
+                         if (src != dst)
+                             out.push_back(Instruction::makeAssign(dst, src));
+                         return true;
+                     }});
+
+    // push aX; <computation not writing aX>; pop aY  =>  <computation>;
+    // aY := aX
+    table.push_back(
+        {"push-op-pop", 3,
+         [](const PeepholeContext &, const Window &w, size_t,
+            std::vector<Instruction> &out) {
+             if (w[0]->kind != InstructionKind::PUSH ||
+                 w[2]->kind != InstructionKind::POP || !isComputation(*w[1]))
+                 return false;
+             const Operand src =
+                 w[0]->lhs.isNone() ? Operand::reg(0) : w[0]->lhs;
+             const Operand dst =
+                 w[2]->dst.isNone() ? Operand::reg(0) : w[2]->dst;
+             if (w[1]->writesRegister(static_cast<int>(src.value)))
+                 return false;
+             out.push_back(*w[1]);
+             if (src != dst)
+                 out.push_back(Instruction::makeAssign(dst, src));
+             return true;
+         }});
+
+    // p(n) := aX; aY := p(n)  =>  p(n) := aX; aY := aX
+    table.push_back(
+        {"store-load", 2,
+         [](const PeepholeContext &, const Window &w, size_t,
+            std::vector<Instruction> &out) {
+             if (w[0]->kind != InstructionKind::ASSIGN ||
+                 w[1]->kind != InstructionKind::ASSIGN ||
+                 !w[0]->dst.isMemory() || !w[0]->lhs.isRegister() ||
+                 !w[1]->dst.isRegister() || w[1]->lhs != w[0]->dst)
+                 return false;
+             out.push_back(*w[0]);
+             if (w[1]->dst != w[0]->lhs)
+                 out.push_back(Instruction::makeAssign(w[1]->dst, w[0]->lhs));
+             return true;
+         }});
+
+    // p(n) := x; p(n) := y  =>  p(n) := y   (y does not read p(n))
+    table.push_back({"dead-store", 2,
+                     [](const PeepholeContext &, const Window &w, size_t,
+                        std::vector<Instruction> &out) {
+                         if (!isComputation(*w[0]) || !isComputation(*w[1]) ||
+                             w[0]->dst.kind != OperandKind::MEMORY ||
+                             w[1]->dst != w[0]->dst ||
+                             readsMemoryCell(*w[1], w[0]->dst))
+                             return false;
+                         out.push_back(*w[1]);
+                         return true;
+                     }});
+
+    // aX := v; <use of aX>  =>  <use of v>, keeping aX := v while aX is live
+    table.push_back(
+        {"copy-propagation", 2,
+         [](const PeepholeContext &context, const Window &w, size_t windowEnd,
+            std::vector<Instruction> &out) {
+             if (w[0]->kind != InstructionKind::ASSIGN ||
+                 !w[0]->dst.isRegister() ||
+                 w[0]->lhs.kind == OperandKind::MEMORY_INDIRECT ||
+                 w[0]->lhs == w[0]->dst)
+                 return false;
+             const int reg = static_cast<int>(w[0]->dst.value);
+             if (!w[1]->readsRegister(reg) ||
+                 (w[0]->lhs.isRegister() && w[1]->writesRegister(static_cast<int>(w[0]->lhs.value))))
+                 return false;
+
+             Instruction rewritten = *w[1];
+             if (!substituteRegister(rewritten, reg, w[0]->lhs))
+                 return false;
+             // A branch also continues at its target
+             const bool dead =
+                 context.isRegisterDead(windowEnd, reg) &&
+                 (!rewritten.isJump() ||
+                  context.isRegisterDeadAt(rewritten.label, reg));
+             if (!rewritten.writesRegister(reg) && !dead)
+                 out.push_back(*w[0]);
+             out.push_back(rewritten);
+             return true;
+         }});
+
+    // aX := ... where aX is never read afterwards
+    table.push_back({"dead-definition", 1,
+                     [](const PeepholeContext &context, const Window &w,
+                        size_t windowEnd, std::vector<Instruction> &) {
+                         return isComputation(*w[0]) &&
+                                w[0]->dst.isRegister() &&
+                                context.isRegisterDead(
+                                    windowEnd,
+                                    static_cast<int>(w[0]->dst.value));
+                     }});
+
+    // goto L; L:  =>  L:
+    table.push_back(
+        {"jump-to-next", 1,
+         [](const PeepholeContext &context, const Window &w, size_t windowEnd,
+            std::vector<Instruction> &) {
+             if (!w[0]->isJump())
+                 return false;
+             const auto labels = context.labelsAfter(windowEnd - 1);
+             return std::find(labels.begin(), labels.end(), w[0]->label) !=
+                    labels.end();
+         }});
+
+    // if c then goto L1; goto L2; L1:  =>  if !c then goto L2; L1:
+    table.push_back(
+        {"branch-over-jump", 3,
+         [](const PeepholeContext &, const Window &w, size_t,
+            std::vector<Instruction> &out) {
+             if (w[0]->kind != InstructionKind::IF_GOTO ||
+                 w[1]->kind != InstructionKind::GOTO ||
+                 w[2]->kind != InstructionKind::LABEL ||
+                 w[2]->label != w[0]->label)
+                 return false;
+             Instruction inverted = *w[0];
+             inverted.op = invertAlphaComparison(w[0]->op);
+             inverted.label = w[1]->label;
+             out.push_back(inverted);
+             out.push_back(*w[2]);
+             return true;
+         }});
+
+    // Labels nothing jumps to
+    table.push_back({"unused-label", 1,
+                     [](const PeepholeContext &context, const Window &w,
+                        size_t, std::vector<Instruction> &) {
+                         return w[0]->kind == InstructionKind::LABEL &&
+                                !isEntryLabel(w[0]->label) &&
+                                !context.isLabelReferenced(w[0]->label);
+                     }});
+
+    return table;
+}
+
+// ============================================================================
+// PeepholeOptimizer Implementation
+// ============================================================================
+
+PeepholeOptimizer::PeepholeOptimizer(PeepholeOptions options)
+    : options(std::move(options)), rules(createDefaultRules()) {
+}
+
+std::vector<std::string> PeepholeOptimizer::getRuleNames() const {
+    std::vector<std::string> names;
+    for (const auto &rule : rules) {
+        names.push_back(rule.name);
+    }
+    return names;
+}
+
+bool PeepholeOptimizer::runPass(std::vector<Instruction> &program) {
+    bool changed = false;
+    // Label maps only change when a rule fires; rebuild lazily after that
+    std::optional<PeepholeContext> context;
+
+    for (size_t start = 0; start < program.size(); ++start) {
+        if (program[start].isTrivia())
+            continue;
+        if (!context)
+            context.emplace(program, options);
+
+        for (const auto &rule : rules) {
+            if (options.disabledRules.contains(rule.name))
+                continue;
+
+            // Collect the window of significant instructions
+            std::vector<size_t> indices;
+            for (size_t i = start;
+                 i < program.size() && indices.size() < rule.windowSize;
+                 ++i) {
+                if (!program[i].isTrivia())
+                    indices.push_back(i);
+            }
+            if (indices.size() < rule.windowSize)
+                continue;
+
+            Window window;
+            for (size_t index : indices) {
+                window.push_back(&program[index]);
+            }
+
+            std::vector<Instruction> replacement;
+            if (!rule.rewrite(*context, window, indices.back() + 1,
+                              replacement))
+                continue;
+
+            // Keep the comment of the first replaced instruction
+            if (!replacement.empty() && replacement.front().comment.empty())
+                replacement.front().comment = window.front()->comment;
+
+            for (auto it = indices.rbegin(); it != indices.rend(); ++it) {
+                program.erase(program.begin() +
+                              static_cast<std::ptrdiff_t>(*it));
+            }
+            program.insert(program.begin() + static_cast<std::ptrdiff_t>(start),
+                           replacement.begin(), replacement.end());
+            statistics[rule.name]++;
+            changed = true;
+            context.reset();
+
+            // Re-examine the current position with the rewritten code
+            if (start > 0)
+                --start;
+            break;
+        }
+    }
+    return changed;
+}
+
+void PeepholeOptimizer::optimize(std::vector<Instruction> &program) {
+    if (!options.enabled)
+        return;
+    for (int pass = 0; pass < options.maxPasses; ++pass) {
+        if (!runPass(program))
+            break;
+    }
+}
+
+std::string PeepholeOptimizer::optimize(const std::string &alphaCode) {
+    auto program = decodeAlphaProgram(alphaCode);
+    optimize(program);
+    return encodeAlphaProgram(program);
+}
+
+} // namespace calpha
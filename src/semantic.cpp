@@ -752,6 +752,17 @@ SemanticAnalyzer::visitBinaryExpression(const BinaryExpression *binExpr) {
         }
         return leftType->clone();
 
+    case TokenType::LOGICAL_AND:
+    case TokenType::LOGICAL_OR:
+        // Operands are truth values: any number or pointer, result is 0 or 1
+        if ((!leftType->isNumeric() && !leftType->isPointer()) ||
+            (!rightType->isNumeric() && !rightType->isPointer())) {
+            addError("Logical operators require numeric or pointer types",
+                     binExpr->line, binExpr->column);
+            return std::make_unique<BasicSemanticType>(SemanticTypeKind::ERROR);
+        }
+        return std::make_unique<BasicSemanticType>(SemanticTypeKind::INT);
+
     case TokenType::EQUAL:
     case TokenType::NOT_EQUAL:
     case TokenType::LESS_THAN:
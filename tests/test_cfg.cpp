@@ -0,0 +1,211 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include "cfg.hpp"
+#include "ir_passes.hpp"
+
+using namespace calpha;
+
+static int failures = 0;
+
+void expect(const std::string& testName, bool condition) {
+    std::cout << "\n=== " << testName << " ===" << std::endl;
+    if (!condition) {
+        std::cout << "✗ Failed" << std::endl;
+        failures++;
+        return;
+    }
+    std::cout << "✓ Passed" << std::endl;
+}
+
+std::string emit(const ControlFlowGraph& cfg) {
+    std::string text;
+    for (auto instr : emitAlphaProgram(cfg)) {
+        if (instr.isTrivia()) continue;
+        instr.comment.clear();
+        text += instr.toString() + "\n";
+    }
+    return text;
+}
+
+void expectPass(const std::string& testName, bool (*pass)(ControlFlowGraph&),
+                const std::string& before, const std::string& expected) {
+    std::cout << "\n=== " << testName << " ===" << std::endl;
+    ControlFlowGraph cfg(decodeAlphaProgram(before));
+    cfg.setDirectCells({10, 11});
+    pass(cfg);
+    const std::string actual = emit(cfg);
+    if (actual != expected) {
+        std::cout << "✗ Expected:\n" << expected << "Got:\n" << actual;
+        failures++;
+        return;
+    }
+    std::cout << "✓ Passed" << std::endl;
+}
+
+int main() {
+    std::cout << "Control Flow Graph Test" << std::endl;
+    std::cout << "=======================" << std::endl;
+
+    const std::string loop =
+        "global::main:\n"
+        "a0 := 0\n"
+        "global::main::loop_1:\n"
+        "a0 := a0 + 1\n"
+        "if a0 < 10 then goto global::main::loop_1\n"
+        "push\n"
+        "return\n"
+        "a0 := 99\n";
+    ControlFlowGraph cfg(decodeAlphaProgram(loop));
+    const auto& blocks = cfg.getBlocks();
+
+    expect("Blocks start at labels and after branches",
+           blocks.size() == 4 && blocks[1].labels() ==
+                                     std::vector<std::string>{
+                                         "global::main::loop_1"});
+
+    expect("Loop edges",
+           blocks[1].successors == std::vector<size_t>{1, 2} &&
+               blocks[1].predecessors == std::vector<size_t>{0, 1} &&
+               blocks[2].successors.empty());
+
+    auto reachable = cfg.reachableFrom("global::main");
+    expect("Code after return is unreachable",
+           reachable == std::vector<bool>{true, true, true, false});
+
+    expect("Emission uses Alpha_TUI labels",
+           emit(cfg) == "main:\na0 := 0\nmain_loop_1:\na0 := a0 + 1\n"
+                        "if a0 < 10 then goto main_loop_1\npush\nreturn\n"
+                        "a0 := 99\n");
+
+    {
+        ControlFlowGraph calls(decodeAlphaProgram(
+            "global::f:\nreturn\nglobal::g:\nreturn\n"
+            "global::main:\ncall global::g\ngoto END\n"));
+        auto fromMain = calls.reachableFrom("global::main");
+        expect("Call targets are reachable, other functions are not",
+               fromMain == std::vector<bool>{false, true, true});
+    }
+
+    {
+        ControlFlowGraph changed(decodeAlphaProgram(loop));
+        changed.getBlocks()[1].instructions.back() =
+            Instruction::makeJump(InstructionKind::GOTO, "global::main");
+        changed.rebuildEdges();
+        expect("Edges follow rewritten jumps",
+               changed.getBlocks()[1].successors == std::vector<size_t>{0} &&
+                   changed.getBlocks()[0].predecessors ==
+                       std::vector<size_t>{1});
+    }
+
+    // p(10) is 4 on the only path to the branch
+    expectPass("Constant conditions prune the arm they skip",
+               propagateConstants,
+               "main:\np(10) := 4\nif p(10) > 8 then goto big\n"
+               "a0 := p(10) * 2\npush\ngoto done\nbig:\na0 := 1\npush\n"
+               "done:\nreturn\n",
+               "main:\np(10) := 4\na0 := 8\npush\ngoto done\ndone:\n"
+               "return\n");
+
+    // p(10) meets 0 and a0 at the loop header, p(11) is 5 on both edges
+    expectPass("Values merged at a loop header",
+               propagateConstants,
+               "main:\np(10) := 0\np(11) := 5\na1 := 16\nloop:\n"
+               "a0 := p(10) + p(11)\np(10) := a0\np(a1) := a0\n"
+               "if 20 > a0 then goto loop\nreturn\n",
+               "main:\np(10) := 0\np(11) := 5\na1 := 16\nloop:\n"
+               "a0 := p(10) + 5\np(10) := a0\np(16) := a0\n"
+               "if a0 < 20 then goto loop\nreturn\n");
+
+    // f stores p(11) but leaves p(10) alone
+    expectPass("Calls forget the cells their callee stores",
+               propagateConstants,
+               "f:\np(11) := 1\nreturn\nmain:\np(10) := 2\np(11) := 3\n"
+               "call f\na0 := p(10) + p(11)\nreturn\n",
+               "f:\np(11) := 1\nreturn\nmain:\np(10) := 2\np(11) := 3\n"
+               "call f\na0 := p(11) + 2\nreturn\n");
+
+    // The same member address computed twice
+    expectPass("Repeated address and load are reused",
+               eliminateCommonSubexpressions,
+               "main:\na1 := p(10) + 1\na0 := p(a1)\npush\n"
+               "a2 := p(10) + 1\na0 := p(a2)\npush\nreturn\n",
+               "main:\na1 := p(10) + 1\na0 := p(a1)\npush\na2 := a1\n"
+               "push\nreturn\n");
+
+    // p(a2) may be p(a1); p(a1 + 1) is not, and no pointer reaches p(10)
+    expectPass("Stores only forget loads they may alias",
+               eliminateCommonSubexpressions,
+               "main:\na0 := p(a1)\np(10) := 4\np(a2) := 7\na3 := p(a1)\n"
+               "a5 := a1 + 1\np(a5) := 0\na6 := p(a1)\na4 := p(10)\n"
+               "return\n",
+               "main:\na0 := p(a1)\np(10) := 4\np(a2) := 7\na3 := p(a1)\n"
+               "a5 := a1 + 1\np(a5) := 0\na6 := a3\na4 := 4\nreturn\n");
+
+    // Execution starts at main, after the store
+    expectPass("Values do not flow into the program entry",
+               eliminateCommonSubexpressions,
+               "p(10) := 5\nglobal::main:\na0 := p(10)\nreturn\n",
+               "p(10) := 5\nmain:\na0 := p(10)\nreturn\n");
+
+    // Syscall arguments that stay the same in every iteration
+    expectPass("Invariant registers move before the loop",
+               hoistLoopInvariants,
+               "main:\nif p(10) <= 0 then goto done\nloop:\n"
+               "a0 := p(10) - 1\np(10) := a0\na0 := 1\na1 := 0\n"
+               "a2 := p(11)\na3 := 8\nsyscall\n"
+               "if p(10) > 0 then goto loop\ndone:\na0 := 0\nreturn\n",
+               "main:\nif p(10) <= 0 then goto done\na1 := 0\n"
+               "a2 := p(11)\na3 := 8\nloop:\na0 := p(10) - 1\n"
+               "p(10) := a0\na0 := 1\nsyscall\n"
+               "if p(10) > 0 then goto loop\ndone:\na0 := 0\nreturn\n");
+
+    // p(12) is not direct: the store through a0 may change it
+    expectPass("Loads that a store may change stay",
+               hoistLoopInvariants,
+               "main:\nloop:\na1 := p(12) + 1\np(a1) := 5\na0 := p(11)\n"
+               "p(a0) := 0\nif p(10) < 3 then goto loop\nreturn\n",
+               "main:\nloop:\na1 := p(12) + 1\np(a1) := 5\na0 := p(11)\n"
+               "p(a0) := 0\nif p(10) < 3 then goto loop\nreturn\n");
+
+    expectPass("Element address becomes a stepped register",
+               reduceInductionStrength,
+               "main:\nif p(10) >= 8 then goto done\nloop:\n"
+               "a0 := p(11) + p(10)\na0 := p(a0)\npush\n"
+               "a0 := p(10) + 1\np(10) := a0\n"
+               "if a0 < 8 then goto loop\ndone:\nreturn\n",
+               "main:\nif p(10) >= 8 then goto done\n"
+               "a7 := p(11) + p(10)\nloop:\na0 := a7\na0 := p(a0)\npush\n"
+               "a0 := p(10) + 1\np(10) := a0\na7 := a7 + 1\n"
+               "if a0 < 8 then goto loop\ndone:\nreturn\n");
+
+    // Execution starts at main; g is never called
+    expectPass("Blocks main can not reach are removed",
+               removeUnreachableBlocks,
+               "p(10) := 5\nglobal::main:\ncall global::f\nreturn\n"
+               "a0 := 1\nglobal::f:\nreturn\nglobal::g:\nreturn\n",
+               "main:\ncall f\nreturn\nf:\nreturn\n");
+
+    // Nothing is observable in memory once main returns
+    expectPass("Overwritten stores and unread registers are removed",
+               eliminateDeadStores,
+               "global::main:\np(10) := 0\na1 := 5\nloop:\n"
+               "p(10) := p(11)\na0 := p(10) + 1\np(11) := a0\n"
+               "if a0 < 9 then goto loop\na0 := p(11)\npush\nreturn\n",
+               "main:\nloop:\np(10) := p(11)\na0 := p(10) + 1\n"
+               "p(11) := a0\nif a0 < 9 then goto loop\na0 := p(11)\npush\n"
+               "return\n");
+
+    expectPass("Cells a caller reads stay stored",
+               eliminateDeadStores,
+               "global::f:\np(10) := 1\np(11) := 2\nreturn\n"
+               "global::main:\ncall global::f\na0 := p(10)\npush\nreturn\n",
+               "f:\np(10) := 1\nreturn\nmain:\ncall f\na0 := p(10)\npush\n"
+               "return\n");
+
+    std::cout << "\n"
+              << (failures == 0 ? "All control flow graph tests passed"
+                                : "Control flow graph tests failed")
+              << std::endl;
+    return failures == 0 ? 0 : 1;
+}
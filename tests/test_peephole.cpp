@@ -0,0 +1,186 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "lexer.hpp"
+#include "parser.hpp"
+#include "semantic.hpp"
+#include "codegen.hpp"
+#include "peephole.hpp"
+#include "alpha_vm.hpp"
+
+using namespace calpha;
+
+static int failures = 0;
+
+std::string compile(const std::string& code, bool optimize) {
+    Lexer lexer(code);
+    std::vector<Token> tokens = lexer.tokenize();
+    Parser parser(tokens);
+    auto program = parser.parseProgram();
+    SemanticAnalyzer analyzer;
+    if (!analyzer.analyze(program.get())) {
+        analyzer.printErrors();
+        throw std::runtime_error("semantic analysis failed");
+    }
+    CodeGenOptions options;
+    options.peephole.enabled = optimize;
+    options.ir.enabled = optimize;
+    CodeGenerator codeGen(&analyzer, options);
+    return codeGen.generate(program.get());
+}
+
+struct RunResult {
+    int64_t exitCode;
+    std::string output;
+    uint64_t instructions;
+};
+
+RunResult run(const std::string& alphaCode) {
+    std::istringstream input;
+    std::ostringstream output;
+    vm::VirtualMachine machine(input, output);
+    machine.setInstructionLimit(1000000);
+    machine.load(alphaCode);
+    int64_t exitCode = machine.run();
+    return {exitCode, output.str(), machine.getStatistics().instructions};
+}
+
+void expectRewrite(const std::string& testName, const std::string& before,
+                   const std::string& expected) {
+    std::cout << "\n=== " << testName << " ===" << std::endl;
+    PeepholeOptimizer optimizer;
+    auto program = decodeAlphaProgram(before);
+    optimizer.optimize(program);
+
+    std::string actual;
+    for (const auto& instr : program) {
+        if (instr.isTrivia()) continue;
+        actual += instr.toString() + "\n";
+    }
+    if (actual != expected) {
+        std::cout << "✗ Expected:\n" << expected << "Got:\n" << actual;
+        failures++;
+        return;
+    }
+    std::cout << "✓ Passed" << std::endl;
+}
+
+// Optimized code must behave exactly like the unoptimized code and execute
+// fewer instructions
+void expectEquivalent(const std::string& testName, const std::string& code) {
+    std::cout << "\n=== " << testName << " ===" << std::endl;
+    try {
+        RunResult plain = run(compile(code, false));
+        RunResult optimized = run(compile(code, true));
+
+        std::cout << "Exit code: " << plain.exitCode << ", instructions: "
+                  << plain.instructions << " -> " << optimized.instructions
+                  << std::endl;
+
+        if (plain.exitCode != optimized.exitCode ||
+            plain.output != optimized.output) {
+            std::cout << "✗ Optimized program behaves differently (exit "
+                      << optimized.exitCode << ")" << std::endl;
+            failures++;
+            return;
+        }
+        if (optimized.instructions >= plain.instructions) {
+            std::cout << "✗ No instructions saved" << std::endl;
+            failures++;
+            return;
+        }
+        std::cout << "✓ Passed" << std::endl;
+    } catch (const std::exception& e) {
+        std::cout << "✗ Exception: " << e.what() << std::endl;
+        failures++;
+    }
+}
+
+int main() {
+    std::cout << "Peephole Optimizer Test" << std::endl;
+    std::cout << "=======================" << std::endl;
+
+    expectRewrite("Push/pop pair becomes a move",
+                  "main:\na0 := 5\npush\npop a1\np(1) := a1\nreturn\n",
+                  "main:\np(1) := 5\nreturn\n");
+
+    expectRewrite("Store then load reuses the register",
+                  "main:\np(1) := a0\na0 := p(1)\npush\nreturn\n",
+                  "main:\np(1) := a0\npush\nreturn\n");
+
+    expectRewrite("Condition against a constant",
+                  "main:\npop\na1 := 0\nif a0 == a1 then goto skip\n"
+                  "a0 := 1\npush\nskip:\nreturn\n",
+                  "main:\npop\nif a0 == 0 then goto skip\n"
+                  "a0 := 1\npush\nskip:\nreturn\n");
+
+    expectRewrite("Branch over jump is inverted",
+                  "main:\nif a0 < a1 then goto L1\ngoto L2\nL1:\n"
+                  "a0 := 1\npush\nL2:\nreturn\n",
+                  "main:\nif a0 >= a1 then goto L2\n"
+                  "a0 := 1\npush\nL2:\nreturn\n");
+
+    expectRewrite("Jump to the next label is removed",
+                  "main:\ngoto next\nnext:\nreturn\n", "main:\nreturn\n");
+
+    expectRewrite("Register read at a branch target stays",
+                  "main:\na2 := 5\na1 := a2\nif a0 <= a1 then goto L\n"
+                  "return\nL:\npush a1\nreturn\n",
+                  "main:\na1 := 5\nif a0 <= 5 then goto L\nreturn\nL:\n"
+                  "push a1\nreturn\n");
+
+    // a2 may hold 1
+    expectRewrite("Store read through a pointer stays",
+                  "main:\np(1) := 4\np(1) := p(a2)\nreturn\n",
+                  "main:\np(1) := 4\np(1) := p(a2)\nreturn\n");
+
+    expectRewrite("Register read by a callee stays",
+                  "f:\npush a1\nreturn\nmain:\na1 := 3\ncall f\nreturn\n",
+                  "f:\npush a1\nreturn\nmain:\na1 := 3\ncall f\nreturn\n");
+
+    {
+        std::cout << "\n=== Disabled rules are skipped ===" << std::endl;
+        PeepholeOptions options;
+        options.disabledRules = {"push-pop"};
+        PeepholeOptimizer optimizer(options);
+        std::string out = optimizer.optimize("main:\npush\npop\nreturn\n");
+        if (out.find("push") == std::string::npos ||
+            optimizer.getStatistics().contains("push-pop")) {
+            std::cout << "✗ push-pop still applied" << std::endl;
+            failures++;
+        } else {
+            std::cout << "✓ Passed" << std::endl;
+        }
+    }
+
+    expectEquivalent("Arithmetic",
+                     "fn int main() { int x = 6; int y = 7; ret x * y + 1; };");
+
+    expectEquivalent("Loop and branch",
+                     "fn int main() {"
+                     "  int i = 0; int sum = 0;"
+                     "  while (i < 10) {"
+                     "    if (i != 5) { sum = sum + i; }"
+                     "    i = i + 1;"
+                     "  }"
+                     "  ret sum;"
+                     "};");
+
+    expectEquivalent("Function call",
+                     "fn int sub(int a, int b) { int c = a - b; ret c; };"
+                     "fn int main() { ret sub(44, 2); };");
+
+    expectEquivalent("Write syscall",
+                     "fn int main() {"
+                     "  ->char msg = \"Hi\\n\";"
+                     "  syscall(1, 1, msg, 3 * 8, 0, 0, 0);"
+                     "  ret 0;"
+                     "};");
+
+    std::cout << "\n"
+              << (failures == 0 ? "All peephole tests passed"
+                                : "Peephole tests failed")
+              << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,789 @@
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "lexer.hpp"
+#include "parser.hpp"
+#include "semantic.hpp"
+#include "codegen.hpp"
+#include "alpha_vm.hpp"
+
+using namespace calpha;
+
+static int failures = 0;
+
+std::string compile(const std::string& code) {
+    Lexer lexer(code);
+    std::vector<Token> tokens = lexer.tokenize();
+    Parser parser(tokens);
+    auto program = parser.parseProgram();
+    SemanticAnalyzer analyzer;
+    if (!analyzer.analyze(program.get())) {
+        analyzer.printErrors();
+        throw std::runtime_error("semantic analysis failed");
+    }
+    CodeGenerator codeGen(&analyzer);
+    return codeGen.generate(program.get());
+}
+
+// Output written through 8-byte cells contains NUL padding; strip it
+std::string printable(const std::string& raw) {
+    std::string text;
+    for (char c : raw) {
+        if (c != '\0') text += c;
+    }
+    return text;
+}
+
+void expectRun(const std::string& testName, const std::string& alphaCode,
+               int64_t expectedExit, const std::string& expectedOutput = "") {
+    std::cout << "\n=== " << testName << " ===" << std::endl;
+    try {
+        std::istringstream input;
+        std::ostringstream output;
+        vm::VirtualMachine machine(input, output);
+        machine.setInstructionLimit(1000000);
+        machine.load(alphaCode);
+        int64_t exitCode = machine.run();
+        std::string text = printable(output.str());
+
+        std::cout << "Exit code: " << exitCode << ", instructions executed: "
+                  << machine.getStatistics().instructions << std::endl;
+
+        if (exitCode != expectedExit || text != expectedOutput) {
+            std::cout << "✗ Expected exit " << expectedExit << " and output '"
+                      << expectedOutput << "', got exit " << exitCode
+                      << " and output '" << text << "'" << std::endl;
+            failures++;
+            return;
+        }
+        std::cout << "✓ Passed" << std::endl;
+    } catch (const std::exception& e) {
+        std::cout << "✗ Exception: " << e.what() << std::endl;
+        failures++;
+    }
+}
+
+void expectCompiledRun(const std::string& testName, const std::string& code,
+                       int64_t expectedExit,
+                       const std::string& expectedOutput = "") {
+    std::string alphaCode;
+    try {
+        alphaCode = compile(code);
+    } catch (const std::exception& e) {
+        std::cout << "✗ " << testName << ": compilation failed: " << e.what()
+                  << std::endl;
+        failures++;
+        return;
+    }
+    expectRun(testName, alphaCode, expectedExit, expectedOutput);
+}
+
+void testDecoder() {
+    std::cout << "\n=== Instruction decoding round trip ===" << std::endl;
+    const std::vector<std::string> lines = {
+        "a0 := p(3) // Load x", "p(a2) := a0", "a0 := a1 - a0",
+        "a0 := -5",             "a0 := ~a0",   "if a0 <= a1 then goto L1",
+        "push a3",              "pop",         "stack%",
+        "call namespace_io_puts", "return",    "main:"};
+    for (const auto& line : lines) {
+        std::string encoded = decodeInstruction(line).toString();
+        if (encoded != line) {
+            std::cout << "✗ '" << line << "' re-encoded as '" << encoded
+                      << "'" << std::endl;
+            failures++;
+        }
+    }
+
+    try {
+        (void)decodeInstruction("a0 := := 3");
+        std::cout << "✗ Malformed instruction was accepted" << std::endl;
+        failures++;
+    } catch (const AlphaSyntaxError&) {
+        std::cout << "✓ Malformed instruction rejected" << std::endl;
+    }
+}
+
+int main() {
+    std::cout << "Alpha_TUI Virtual Machine Test" << std::endl;
+    std::cout << "==============================" << std::endl;
+
+    testDecoder();
+
+    expectRun("Hand-written loop with call",
+              "sum:\n"
+              "pop\n"
+              "a1 := a0\n"
+              "pop\n"
+              "a0 := a0 + a1\n"
+              "push\n"
+              "return\n"
+              "main:\n"
+              "p(1) := 0\n"
+              "p(2) := 1\n"
+              "loop:\n"
+              "if p(2) > 10 then goto done\n"
+              "a0 := p(1)\n"
+              "push\n"
+              "a0 := p(2)\n"
+              "push\n"
+              "call sum\n"
+              "pop\n"
+              "p(1) := a0\n"
+              "p(2) := p(2) + 1\n"
+              "goto loop\n"
+              "done:\n"
+              "a0 := p(1)\n"
+              "push\n"
+              "goto END\n",
+              55);
+
+    expectRun("Stack arithmetic order",
+              "main:\na0 := 10\npush\na0 := 3\npush\nstack-\na0 := 4\npush\n"
+              "stack*\nreturn\n",
+              28);
+
+    expectRun("Exit syscall",
+              "main:\na0 := 60\na1 := 7\nsyscall\na0 := 1\npush\n", 7);
+
+    expectCompiledRun("Compiled arithmetic",
+                      "fn int main() { int x = 6; int y = 7; ret x * y; };",
+                      42);
+
+    expectCompiledRun("Compiled loop and branch",
+                      "fn int main() {"
+                      "  int i = 0; int sum = 0;"
+                      "  while (i < 10) {"
+                      "    if (i != 5) { sum = sum + i; }"
+                      "    i = i + 1;"
+                      "  }"
+                      "  ret sum;"
+                      "};",
+                      40);
+
+    expectCompiledRun("Compiled function call",
+                      "fn int add(int a, int b) { ret a - b; };"
+                      "fn int main() { ret add(44, 2); };",
+                      42);
+
+    expectCompiledRun("Compiled write syscall",
+                      "fn int main() {"
+                      "  ->char msg = \"Hi\\n\";"
+                      "  syscall(1, 1, msg, 3 * 8, 0, 0, 0);"
+                      "  ret 0;"
+                      "};",
+                      0, "Hi\n");
+
+    expectCompiledRun("Compiled nested and constant conditions",
+                      "fn int main() {"
+                      "  int i = 0; int hits = 0;"
+                      "  while (i < 6) {"
+                      "    if ((i < 3) == 0) { hits = hits + 10; }"
+                      "    if (1 != (i >= 5)) { hits = hits + 1; }"
+                      "    if (0) { hits = 100; }"
+                      "    i = i + 1;"
+                      "  }"
+                      "  ret hits;"
+                      "};",
+                      35);
+
+    {
+        std::cout << "\n=== Fused compare-and-branch ===" << std::endl;
+        std::string alphaCode = compile(
+            "fn int main() { int i = 0; while (i < 10) { i = i + 1; } ret i; };");
+        if (alphaCode.find("cmp_end") != std::string::npos) {
+            std::cout << "✗ Loop condition was materialized as 0/1" << std::endl;
+            failures++;
+        } else {
+            std::cout << "✓ Passed" << std::endl;
+        }
+    }
+
+    {
+        const std::string code =
+            "fn int main() {"
+            "  int i = 0; int total = 0; int never = 0;"
+            "  while (i < 4) {"
+            "    int j = i;"
+            "    while (j > 0) { total = total + j; j = j - 1; }"
+            "    i = i + 1;"
+            "  }"
+            "  while (i < 0) { never = never + 1; }"
+            "  ret total * 10 + never;"
+            "};";
+        expectCompiledRun("Compiled rotated loops", code, 100);
+        if (compile(code).find("Jump back to loop start") != std::string::npos) {
+            std::cout << "✗ Loop was not rotated" << std::endl;
+            failures++;
+        }
+    }
+
+    expectCompiledRun("Compiled short-circuit conditions",
+                      "fn int touch(->char msg) {"
+                      "  syscall(1, 1, msg, 8, 0, 0, 0);"
+                      "  ret 1;"
+                      "};"
+                      "fn int main() {"
+                      "  ->char msg = \"X\"; int zero = 0; int hits = 0;"
+                      "  if (zero != 0 && touch(msg) == 1) { hits = hits + 100; }"
+                      "  if (zero == 0 || touch(msg) == 1) { hits = hits + 1; }"
+                      "  if (zero == 0 && touch(msg) == 1) { hits = hits + 10; }"
+                      "  if ((zero > 0 || zero < 0) == 0) { hits = hits + 1000; }"
+                      "  ret hits;"
+                      "};",
+                      1011, "X");
+
+    expectCompiledRun("Compiled logical values",
+                      "fn int main() {"
+                      "  int a = 3; int b = 0;"
+                      "  int both = a > 0 && b > 0;"
+                      "  int either = a > 0 || b > 0;"
+                      "  ret both * 10 + either;"
+                      "};",
+                      1);
+
+    expectCompiledRun("Compiled register expressions",
+                      "fn int main() {"
+                      "  ->int values = ~int[3];"
+                      "  values[0] = 5; values[1] = 0 - 7; values[2] = 9;"
+                      "  int i = 1;"
+                      "  int x = (values[i] * -values[i + 1] + values[0]) % 11;"
+                      "  int c = <char>(x - 300);"
+                      "  ret x * 1000 + c + (x > c) * 100000;"
+                      "};",
+                      ((-7 * -9 + 5) % 11) * 1000 +
+                          (((-7 * -9 + 5) % 11 - 300) & 255));
+
+    {
+        // A full binary tree of depth 9 needs more than a0-a7
+        std::function<std::pair<std::string, int64_t>(int, int)> build =
+            [&](int depth, int leaf) -> std::pair<std::string, int64_t> {
+            if (depth == 0) {
+                static const std::pair<std::string, int64_t> leaves[] = {
+                    {"a", 3}, {"b", 2}, {"c", 7}};
+                return leaves[leaf % 3];
+            }
+            auto [lhs, lhsValue] = build(depth - 1, leaf * 2);
+            auto [rhs, rhsValue] = build(depth - 1, leaf * 2 + 1);
+            if (depth % 2 == 0)
+                return {"(" + lhs + " - " + rhs + ")", lhsValue - rhsValue};
+            return {"(" + lhs + " + " + rhs + ")", lhsValue + rhsValue};
+        };
+        auto [expression, value] = build(9, 0);
+        const std::string code = "fn int main() { int a = 3; int b = 2; int c = 7; ret " +
+                                 expression + "; };";
+        expectCompiledRun("Compiled register spill", code, value);
+        if (compile(code).find("Spill") == std::string::npos) {
+            std::cout << "✗ Expected a register spill" << std::endl;
+            failures++;
+        }
+    }
+
+    {
+        const std::string code =
+            "fn int main() {"
+            "  ->int buf = ~int[2 * 4 + 1];"
+            "  buf[8] = (256 * 8 + 4) / 4 - <char>(300) + ('a' < 'b');"
+            "  int x = buf[8];"
+            "  ret x * 1 + 0 - (0 - 3 * -2);"
+            "};";
+        expectCompiledRun("Compiled constant folding", code,
+                          (256 * 8 + 4) / 4 - (300 & 255) + 1 - 6);
+        const std::string alphaCode = compile(code);
+        if (alphaCode.find("dynamic") != std::string::npos ||
+            alphaCode.find("* 1") != std::string::npos ||
+            alphaCode.find("256") != std::string::npos) {
+            std::cout << "✗ Constant expressions were not folded" << std::endl;
+            failures++;
+        }
+    }
+
+    {
+        const std::string code =
+            "fn int unused(int a, int b) { ret a & b; };"
+            "fn int triangle(int n) {"
+            "  if (n == 0) { ret 0; }"
+            "  ret n + triangle(n - 1);"
+            "};"
+            "fn int main() { ret triangle(8) + 6; };";
+        expectCompiledRun("Compiled dead function elimination", code, 42);
+        const std::string alphaCode = compile(code);
+        if (alphaCode.find("unused:") != std::string::npos ||
+            alphaCode.find("runtime_bitwise") != std::string::npos ||
+            alphaCode.find("triangle:") == std::string::npos) {
+            std::cout << "✗ Unreachable function was emitted" << std::endl;
+            failures++;
+        }
+    }
+
+    {
+        const std::string code =
+            "fn int last_bit(int a) { ret a % 2; };"
+            "fn int clamp(int v, int limit) {"
+            "  int result = v;"
+            "  if (v > limit) { ret limit; }"
+            "  ret result;"
+            "};"
+            "fn int put(char c) {"
+            "  ->char buf = ~char[1];"
+            "  buf[0] = c;"
+            "  syscall(1, 1, buf, 8, 0, 0, 0);"
+            "};"
+            "fn int main() {"
+            "  int result = 0; int i = 0;"
+            "  while (i < 7) {"
+            "    result = result + last_bit(i) * clamp(i * 10, 45);"
+            "    i = i + 1;"
+            "  }"
+            "  put('o'); put('k');"
+            "  ret result;"
+            "};";
+        expectCompiledRun("Compiled inlined calls", code, 10 + 30 + 45,
+                          "ok");
+        if (compile(code).find("\ncall ") != std::string::npos) {
+            std::cout << "✗ Small leaf functions were not inlined" << std::endl;
+            failures++;
+        }
+    }
+
+    // Inlined bodies see the globals, not the caller's locals of that name
+    expectCompiledRun("Compiled inlined read of a shadowed global",
+                      "int g = 5;"
+                      "fn int getg() { ret g; };"
+                      "fn int main() { int g = 7; ret getg() * 10 + g; };",
+                      57);
+    expectCompiledRun("Compiled inlined write of a shadowed global",
+                      "int c = 1;"
+                      "fn int bump() { c = c + 1; ret c; };"
+                      "fn int main() {"
+                      "  int c = 50;"
+                      "  bump();"
+                      "  ret bump() * 100 + c;"
+                      "};",
+                      350);
+    expectCompiledRun("Compiled inlined global shadowed in a loop",
+                      "int g = 3;"
+                      "fn int getg() { ret g; };"
+                      "fn int main() {"
+                      "  int total = 0; int i = 0;"
+                      "  while (i < 3) {"
+                      "    int g = 10;"
+                      "    total = total + getg() * 5;"
+                      "    i = i + 1;"
+                      "  }"
+                      "  ret total;"
+                      "};",
+                      45);
+
+    expectCompiledRun("Compiled frames of nested calls",
+                      "fn int scale(int v) { ret v * 3; };"
+                      "fn int sum_to(int n) {"
+                      "  int s = 0; int i = 1;"
+                      "  while (i <= n) { s = s + i; i = i + 1; }"
+                      "  ret scale(s);"
+                      "};"
+                      "fn int main() {"
+                      "  int a = 5; int b = sum_to(4); int c = sum_to(a);"
+                      "  ret a * 10000 + b * 100 + c;"
+                      "};",
+                      5 * 10000 + 30 * 100 + 45);
+
+    expectCompiledRun("Compiled buffer outlives its function",
+                      "fn int id(int v) { ret v; };"
+                      "fn ->char make(int v) {"
+                      "  ->char buf = ~char[2];"
+                      "  buf[0] = <char>(id(v)); buf[1] = '\\0';"
+                      "  ret buf;"
+                      "};"
+                      "fn int churn(int n) {"
+                      "  int a = id(n); int b = a + 1; int c = b + 1; int d = c + 1;"
+                      "  ret a + b + c + d;"
+                      "};"
+                      "fn int main() {"
+                      "  ->char s = make(65); int x = churn(1);"
+                      "  ret s[0] * 100 + x;"
+                      "};",
+                      6510);
+
+    expectCompiledRun("Compiled uninitialized layout variable",
+                      "layout Pair { int left; int right; };"
+                      "fn int main() {"
+                      "  Pair p; int z = 7;"
+                      "  p.left = 4; p.right = 5;"
+                      "  ret p.left * 100 + p.right * 10 + z;"
+                      "};",
+                      457);
+
+    // Layout values are copies: of a returned layout, of another variable,
+    // and of a nested member
+    expectCompiledRun("Compiled layout copies",
+                      "layout Pair { int left; int right; };"
+                      "layout Box { int tag; Pair inner; };"
+                      "fn Pair make(int seed) {"
+                      "  Pair made = {seed, seed + 1}; ret made;"
+                      "};"
+                      "fn int main() {"
+                      "  Pair x = make(3); Pair y = make(7);"
+                      "  Pair c = x; c.left = 9;"
+                      "  x = y; y.right = 1;"
+                      "  Box box = {5, c}; c.right = 2;"
+                      "  ret x.left * 10000 + x.right * 1000 + c.left * 100"
+                      "      + box.inner.right * 10 + box.inner.left;"
+                      "};",
+                      78949);
+
+    {
+        // Compact layouts: one-member elements, pointers followed through
+        // dereference and no cell for the instance's own address
+        const std::string code =
+            "layout Cell { int v; };"
+            "layout Node { int value; ->Node next; };"
+            "fn int main() {"
+            "  ->Cell cells = ~Cell[3];"
+            "  cells[0].v = 4; cells[2].v = 6;"
+            "  ->Node first = ~Node[1]; ->Node second = ~Node[1];"
+            "  first.value = 10; first.next = second; second.value = 20;"
+            "  Node copy = <-first; first.value = 11;"
+            "  ret cells[0].v * 1000 + cells[2].v * 100 + copy.value"
+            "      + (<-(copy.next)).value;"
+            "};";
+        expectCompiledRun("Compiled compact layouts", code, 4630);
+        if (compile(code).find("Store base address") != std::string::npos) {
+            std::cout << "✗ Layout stores its own address" << std::endl;
+            failures++;
+        }
+    }
+
+    expectCompiledRun("Compiled recursion keeps locals",
+                      "fn int fib(int n) {"
+                      "  if (n < 2) { ret n; }"
+                      "  int a = fib(n - 1);"
+                      "  int b = fib(n - 2);"
+                      "  ret a + b;"
+                      "};"
+                      "fn int main() {"
+                      "  int i = 0; int total = 0;"
+                      "  while (i < 5) { total = total + fib(i); i = i + 1; }"
+                      "  ret fib(10) * 100 + total;"
+                      "};",
+                      5507);
+
+    {
+        const std::string code =
+            "fn int main() {"
+            "  int a = 3; int b = a * 2;"
+            "  int c = b + 1;"
+            "  int d = c * c;"
+            "  int i = 0; int sum = 0;"
+            "  while (i < 5) {"
+            "    int sq = i * i; int t = sq + 1;"
+            "    sum = sum + t; i = i + 1;"
+            "  }"
+            "  ret sum * 100 + d;"
+            "};";
+        expectCompiledRun("Compiled shared variable slots", code, 35 * 100 + 49);
+        // a, b, c, d share one cell, sq and t another; i and sum stay apart
+        if (compile(code).find("p(0) := 4 ") == std::string::npos) {
+            std::cout << "✗ Expected four variable cells" << std::endl;
+            failures++;
+        }
+    }
+
+    // Recursive so the calls stay calls; nine parameters, two on the stack
+    expectCompiledRun("Compiled register arguments",
+                      "fn int mix(int a, int b, int c, int d, int e, int f,"
+                      "           int g, int h, int n) {"
+                      "  if (n > 0) { ret mix(b, c, d, e, f, g, h, a, n - 1); }"
+                      "  ret a * 10000000 + b * 1000000 + c * 100000 + d * 10000"
+                      "      + e * 1000 + f * 100 + g * 10 + h;"
+                      "};"
+                      "fn int main() {"
+                      "  int x = 2;"
+                      "  ret mix(1, x, mix(3, 4, 5, 6, 7, 8, 9, 0, 0) % 100 / 10,"
+                      "          x + 2, 5, 6, 7, 8, 2);"
+                      "};",
+                      94567812);
+
+    expectCompiledRun("Compiled syscall with a call argument",
+                      "fn int bits(int n) {"
+                      "  if (n == 0) { ret 0; }"
+                      "  ret 8 + bits(n - 1);"
+                      "};"
+                      "fn int main() {"
+                      "  ->char msg = \"ok\";"
+                      "  syscall(1, 1, msg, bits(2), 0, 0, 0);"
+                      "  ret 0;"
+                      "};",
+                      0, "ok");
+
+    {
+        // count jumps back to its own entry and start jumps into count, so
+        // the recursion runs at constant call depth
+        const std::string code =
+            "fn int count(int n, int acc) {"
+            "  if (n == 0) { ret acc; }"
+            "  ret count(n - 1, acc + n);"
+            "};"
+            "fn int start(int n) { int base = n * 2; ret count(n, base); };"
+            "fn int main() { ret start(20000); };";
+        expectCompiledRun("Compiled tail calls", code, 200010000 + 40000);
+        if (compile(code).find("call count") != std::string::npos) {
+            std::cout << "✗ Tail calls still use call" << std::endl;
+            failures++;
+        }
+    }
+
+    {
+        // One pooled copy of "ab" serves all three uses
+        const std::string code =
+            "fn int main() {"
+            "  int i = 0;"
+            "  while (i < 3) {"
+            "    ->char msg = \"ab\";"
+            "    syscall(1, 1, msg, 16, 0, 0, 0);"
+            "    i = i + 1;"
+            "  }"
+            "  ->char again = \"ab\";"
+            "  ret <int>(again[1]);"
+            "};";
+        expectCompiledRun("Compiled pooled strings", code, 'b', "ababab");
+        const std::string alphaCode = compile(code);
+        if (alphaCode.find(":= 98") != alphaCode.rfind(":= 98")) {
+            std::cout << "✗ String literal stored more than once" << std::endl;
+            failures++;
+        }
+    }
+
+    {
+        // Every evaluation of "abc" starts over from the literal; "xy" is
+        // only read and stays pooled
+        const std::string code =
+            "fn int main() {"
+            "  int i = 0; int r = 0;"
+            "  while (i < 3) {"
+            "    ->char s = \"abc\";"
+            "    r = r * 1000 + <int>(s[0]);"
+            "    s[0] = 'z';"
+            "    i = i + 1;"
+            "  }"
+            "  ->char t = \"xy\";"
+            "  ret r + <int>(t[1]) - 121;"
+            "};";
+        expectCompiledRun("Compiled literal written through", code, 97097097);
+        const std::string alphaCode = compile(code);
+        if (alphaCode.find("String pool: 2 characters") == std::string::npos ||
+            alphaCode.find("String pool: 3 characters") != std::string::npos) {
+            std::cout << "✗ Written and read-only literals pooled alike"
+                      << std::endl;
+            failures++;
+        }
+    }
+
+    {
+        // The large buffer is zeroed by a loop on every iteration; the pair
+        // is filled right away and not zeroed at all
+        const std::string code =
+            "fn int main() {"
+            "  int i = 0; int total = 0;"
+            "  while (i < 3) {"
+            "    ->int buf = ~int[40];"
+            "    total = total + buf[39] + buf[0];"
+            "    buf[39] = 5; buf[0] = 7;"
+            "    i = i + 1;"
+            "  }"
+            "  ->int pair = ~int[2];"
+            "  pair[1] = total + 4;"
+            "  pair[0] = 3;"
+            "  ret pair[0] * 10 + pair[1];"
+            "};";
+        expectCompiledRun("Compiled array zeroing", code, 34);
+        const std::string alphaCode = compile(code);
+        if (alphaCode.find("Fill cell") != std::string::npos ||
+            alphaCode.find("fill") == std::string::npos) {
+            std::cout << "✗ Expected one zeroing loop and no stores"
+                      << std::endl;
+            failures++;
+        }
+    }
+
+    // Sizes known only at run time, larger than any fixed reservation
+    expectCompiledRun("Compiled dynamic arrays",
+                      "fn int fill(int n) {"
+                      "  ->int a = ~int[n]; ->int b = ~int[n];"
+                      "  int i = 0;"
+                      "  while (i < n) { a[i] = i; b[i] = 1000; i = i + 1; }"
+                      "  int sum = 0; i = 0;"
+                      "  while (i < n) { sum = sum + a[i]; i = i + 1; }"
+                      "  ret sum;"
+                      "};"
+                      "fn int main() { ret fill(500) * 10 + fill(3); };",
+                      1247500 + 3);
+
+    {
+        // Loop-invariant syscall arguments and element addresses stepped
+        // along with their index
+        const std::string code =
+            "layout Pt { int x; int y; };"
+            "fn int main() {"
+            "  ->Pt pts = ~Pt[5];"
+            "  int i = 0;"
+            "  while (i < 5) { pts[i].x = i; pts[i].y = i * 10; i = i + 1; }"
+            "  ->char msg = \"ab\";"
+            "  int k = 0; int total = 0;"
+            "  while (k < 3) {"
+            "    syscall(1, 1, msg, 2 * 8, 0, 0, 0);"
+            "    total = total + pts[k].y + pts[k + 1].x; k = k + 1;"
+            "  }"
+            "  ret total;"
+            "};";
+        expectCompiledRun("Compiled loop optimizations", code, 36, "ababab");
+        if (compile(code).find("Induction expression") == std::string::npos) {
+            std::cout << "✗ Expected a strength-reduced address"
+                      << std::endl;
+            failures++;
+        }
+    }
+
+    // Member chains that repeat the same base addresses
+    expectCompiledRun("Compiled member access chains",
+                      "layout Node { int size; ->Node parent; int v; };"
+                      "layout List { ->Node head; ->Node tail; int count; };"
+                      "fn int check(->Node node) {"
+                      "  if ((<-node).size <= (<-((<-node).parent)).size) {"
+                      "    ret 1;"
+                      "  }"
+                      "  ret 0;"
+                      "};"
+                      "fn int add(->List list, ->Node n) {"
+                      "  ->Node last = list.tail;"
+                      "  last.parent = n; list.tail = n;"
+                      "  list.count = list.count + 1;"
+                      "  ret list.count;"
+                      "};"
+                      "fn int main() {"
+                      "  ->Node first = ~Node[1]; ->Node second = ~Node[1];"
+                      "  first.size = 3; second.size = 5;"
+                      "  first.parent = second;"
+                      "  ->List nodes = ~List[1];"
+                      "  nodes.tail = first;"
+                      "  add(nodes, second);"
+                      "  ret check(first) * 100 + add(nodes, first) * 10"
+                      "      + nodes.count;"
+                      "};",
+                      122);
+
+    {
+        // Variables, elements and members used straight from memory, with
+        // constants on either side of commutative operators and comparisons
+        const std::string code =
+            "layout Pair { int x; int y; };"
+            "fn int main() {"
+            "  ->int values = ~int[8]; int i = 0; int total = 0;"
+            "  Pair pair; pair.x = 0; pair.y = 1;"
+            "  while (i < 8) { values[i] = 3 * i - 1; i = i + 1; }"
+            "  i = 0;"
+            "  while (7 >= i) {"
+            "    total = total + values[i] + -i;"
+            "    pair.x = pair.x + values[i] * 2;"
+            "    pair.y = 10 - pair.y * 3 + (i & 3);"
+            "    i = i + 1;"
+            "  }"
+            "  ret total * 100 + pair.x + pair.y;"
+            "};";
+        expectCompiledRun("Compiled memory operands", code, -4395);
+        if (compile(code).find("p(10) := p(10) + 1") == std::string::npos) {
+            std::cout << "✗ Expected the increment in a single instruction"
+                      << std::endl;
+            failures++;
+        }
+    }
+
+    {
+        // Settings assigned once decide branches at compile time
+        const std::string code =
+            "fn int main() {"
+            "  int steps = 4; int debug = 0; int total = 0; int i = 0;"
+            "  while (i < steps) {"
+            "    if (debug == 1) { total = total + 1000; }"
+            "    total = total + i * steps;"
+            "    i = i + 1;"
+            "  }"
+            "  if (steps > 10) { ret 1; }"
+            "  ret total;"
+            "};";
+        expectCompiledRun("Compiled constant propagation", code, 24);
+        if (compile(code).find("1000") != std::string::npos) {
+            std::cout << "✗ Expected the debug branch to be removed"
+                      << std::endl;
+            failures++;
+        }
+    }
+
+    {
+        // Running off the end of a body returns 0; pick() always returns
+        // before its default tail, and the loop overwrites `and` each time
+        const std::string code =
+            "fn int bits(int a, int b) {"
+            "  int result = 0; int place = 1; int and = 0;"
+            "  while (a > 0) {"
+            "    and = (a % 2 + b % 2) == 2;"
+            "    result = result + and * place;"
+            "    a = a / 2; b = b / 2; place = place * 2;"
+            "  }"
+            "  if (result > 1000000) { ret result; }"
+            "  if (result > 1000001) { ret result + 1; }"
+            "};"
+            "fn int pick(int n) {"
+            "  if (n > 5) { ret 10; } else { ret 20; }"
+            "};"
+            "fn int main() {"
+            "  ret bits(12, 10) + pick(7) + pick(1);"
+            "};";
+        expectCompiledRun("Compiled dead code", code, 30);
+        const std::string alphaCode = compile(code);
+        if (alphaCode.find("Initialize and") != std::string::npos ||
+            alphaCode.find("ends without explicit return") ==
+                std::string::npos) {
+            std::cout << "✗ Expected the dead store to go and one default "
+                         "return to stay"
+                      << std::endl;
+            failures++;
+        }
+    }
+
+    // The cells of the dropped function hold the OR table now; its stores
+    // are read through pointers
+    expectCompiledRun("Compiled runtime table over unused frames",
+                      "fn int unused(int x, int y, int z) { ret x + y + z; };"
+                      "fn int main() { int v = 0; ret v | 1; };",
+                      1);
+
+    // Execution starts at main; the globals are initialized before its body
+    expectCompiledRun("Compiled global initializers",
+                      "int g = 5;"
+                      "fn int twice(int x) { ret x * 2; };"
+                      "int h = twice(g);"
+                      "fn int main() { g = g + 1; ret g * 100 + h; };",
+                      610);
+
+    // Operands chosen to cover negative values and more than one nibble
+    const std::vector<std::pair<std::string, int64_t>> bitwiseCases = {
+        {"a & b", -12345 & 987654},   {"a | b", -12345 | 987654},
+        {"a ^ b", -12345 ^ 987654},   {"a & 255", -12345 & 255},
+        {"<char>(a)", -12345 & 255},  {"b & 7", 987654 & 7},
+        {"(a < b) | (b < a)", 1},     {"(a < b) ^ (b > a)", 0},
+        {"(a < b) & (b > a)", 1}};
+    for (const auto& [expression, expected] : bitwiseCases) {
+        expectCompiledRun("Compiled bitwise " + expression,
+                          "fn int main() {"
+                          "  int a = 0 - 12345; int b = 987654;"
+                          "  ret " + expression + ";"
+                          "};",
+                          expected);
+    }
+
+    std::cout << "\n" << (failures == 0 ? "All VM tests passed" : "VM tests failed")
+              << std::endl;
+    return failures == 0 ? 0 : 1;
+}
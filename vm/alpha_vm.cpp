@@ -0,0 +1,317 @@
+#include "alpha_vm.hpp"
+#include <algorithm>
+
+namespace calpha {
+namespace vm {
+
+namespace {
+
+// Upper bound for the cell array; addresses above this are treated as wild
+// pointers instead of silently allocating gigabytes
+constexpr int64_t kMemoryLimit = int64_t{1} << 24;
+
+} // namespace
+
+VirtualMachine::VirtualMachine(std::istream &input, std::ostream &output,
+                               std::ostream &error)
+    : input(input), output(output), error(error) {
+}
+
+void VirtualMachine::load(const std::string &source) {
+    load(decodeAlphaProgram(source));
+}
+
+void VirtualMachine::load(const std::vector<Instruction> &program) {
+    code.clear();
+    entryPoint = 0;
+
+    // Pass 1: drop labels and trivia, remember where each label points
+    std::unordered_map<std::string, size_t> labels;
+    int line = 0;
+    for (const auto &instruction : program) {
+        ++line;
+        if (instruction.isTrivia())
+            continue;
+        if (instruction.kind == InstructionKind::LABEL) {
+            if (labels.contains(instruction.label)) {
+                throw VMError("duplicate label '" + instruction.label + "'",
+                              line);
+            }
+            labels[instruction.label] = code.size();
+            continue;
+        }
+        code.push_back({instruction, 0, line});
+    }
+
+    // Pass 2: resolve jump and call targets to instruction indices.
+    // END is the conventional halt label and maps one past the last
+    // instruction unless the program defines it.
+    for (auto &decoded : code) {
+        const auto kind = decoded.instruction.kind;
+        if (kind != InstructionKind::CALL && !decoded.instruction.isJump())
+            continue;
+        const auto &target = decoded.instruction.label;
+        if (auto it = labels.find(target); it != labels.end()) {
+            decoded.target = it->second;
+        } else if (target == "END") {
+            decoded.target = code.size();
+        } else {
+            throw VMError("undefined label '" + target + "'",
+                          decoded.sourceLine);
+        }
+    }
+
+    if (auto it = labels.find("main"); it != labels.end()) {
+        entryPoint = it->second;
+    }
+    reset();
+}
+
+void VirtualMachine::reset() {
+    for (auto &reg : registers)
+        reg = 0;
+    memory.clear();
+    dataStack.clear();
+    callStack.clear();
+    statistics = Statistics{};
+}
+
+int64_t VirtualMachine::getRegister(int index) const {
+    if (index < 0 || index >= kRegisterCount)
+        throw VMError("invalid register a" + std::to_string(index), 0);
+    return registers[index];
+}
+
+int64_t VirtualMachine::getMemory(int64_t address) const {
+    if (address < 0 || address >= static_cast<int64_t>(memory.size()))
+        return 0;
+    return memory[address];
+}
+
+int64_t &VirtualMachine::cell(int64_t address, int line) {
+    if (address < 0 || address >= kMemoryLimit) {
+        throw VMError("memory access out of range: p(" +
+                          std::to_string(address) + ")",
+                      line);
+    }
+    if (address >= static_cast<int64_t>(memory.size())) {
+        memory.resize(address + 1, 0);
+        statistics.memoryCells = memory.size();
+    }
+    ++statistics.memoryAccesses;
+    return memory[address];
+}
+
+int64_t VirtualMachine::read(const Operand &operand, int line) {
+    switch (operand.kind) {
+    case OperandKind::REGISTER:
+        return getRegister(static_cast<int>(operand.value));
+    case OperandKind::IMMEDIATE:
+        return operand.value;
+    case OperandKind::MEMORY:
+        return cell(operand.value, line);
+    case OperandKind::MEMORY_INDIRECT:
+        return cell(getRegister(static_cast<int>(operand.value)), line);
+    default:
+        throw VMError("missing operand", line);
+    }
+}
+
+void VirtualMachine::write(const Operand &operand, int64_t value, int line) {
+    switch (operand.kind) {
+    case OperandKind::REGISTER:
+        if (operand.value < 0 || operand.value >= kRegisterCount) {
+            throw VMError("invalid register a" + std::to_string(operand.value),
+                          line);
+        }
+        registers[operand.value] = value;
+        break;
+    case OperandKind::MEMORY:
+        cell(operand.value, line) = value;
+        break;
+    case OperandKind::MEMORY_INDIRECT:
+        cell(getRegister(static_cast<int>(operand.value)), line) = value;
+        break;
+    default:
+        throw VMError("invalid assignment target", line);
+    }
+}
+
+void VirtualMachine::pushData(int64_t value) {
+    dataStack.push_back(value);
+    statistics.maxStackDepth =
+        std::max(statistics.maxStackDepth, dataStack.size());
+}
+
+int64_t VirtualMachine::popData(int line) {
+    if (dataStack.empty())
+        throw VMError("pop from empty stack", line);
+    const int64_t value = dataStack.back();
+    dataStack.pop_back();
+    return value;
+}
+
+int64_t VirtualMachine::evaluate(AlphaOperator op, int64_t lhs, int64_t rhs,
+                                 int line) {
+    if (auto value = foldAlphaOperation(op, lhs, rhs))
+        return *value;
+    if (op == AlphaOperator::DIV || op == AlphaOperator::MOD)
+        throw VMError("division by zero", line);
+    throw VMError("invalid arithmetic operator '" + alphaOperatorToString(op) +
+                      "'",
+                  line);
+}
+
+bool VirtualMachine::compare(AlphaOperator op, int64_t lhs, int64_t rhs) {
+    return foldAlphaComparison(op, lhs, rhs);
+}
+
+int64_t VirtualMachine::syscall(bool &halt, int line) {
+    ++statistics.syscalls;
+    const int64_t number = registers[0];
+
+    if (number == kSyscallExit) {
+        halt = true;
+        return registers[1];
+    }
+    if (number != kSyscallRead && number != kSyscallWrite) {
+        throw VMError("unsupported syscall " + std::to_string(number), line);
+    }
+
+    // read/write(fd = a1, buffer = a2, count = a3)
+    const int64_t fd = registers[1];
+    const int64_t buffer = registers[2];
+    const int64_t count = registers[3];
+    if (count < 0)
+        return -1;
+
+    auto byteAt = [&](int64_t offset) -> int64_t & {
+        return cell(buffer + offset / 8, line);
+    };
+
+    if (number == kSyscallWrite) {
+        std::ostream &stream = fd == 2 ? error : output;
+        for (int64_t i = 0; i < count; ++i) {
+            const auto cellValue = static_cast<uint64_t>(byteAt(i));
+            stream.put(static_cast<char>((cellValue >> (8 * (i % 8))) & 0xFF));
+        }
+        stream.flush();
+        return count;
+    }
+
+    // Reads behave like a terminal: at most one line per call
+    int64_t bytesRead = 0;
+    while (bytesRead < count) {
+        const int c = input.get();
+        if (c == std::char_traits<char>::eof())
+            break;
+        auto &target = byteAt(bytesRead);
+        const int shift = static_cast<int>(8 * (bytesRead % 8));
+        auto value = static_cast<uint64_t>(target);
+        value &= ~(uint64_t{0xFF} << shift);
+        value |= static_cast<uint64_t>(static_cast<unsigned char>(c)) << shift;
+        target = static_cast<int64_t>(value);
+        ++bytesRead;
+        if (c == '\n')
+            break;
+    }
+    return bytesRead;
+}
+
+int64_t VirtualMachine::run() {
+    reset();
+    size_t pc = entryPoint;
+    int64_t exitCode = 0;
+    bool exitRequested = false;
+
+    while (pc < code.size()) {
+        const DecodedInstruction &decoded = code[pc];
+        const Instruction &instr = decoded.instruction;
+        const int line = decoded.sourceLine;
+
+        if (instructionLimit != 0 &&
+            statistics.instructions >= instructionLimit) {
+            throw VMError("instruction limit of " +
+                              std::to_string(instructionLimit) + " exceeded",
+                          line);
+        }
+        ++statistics.instructions;
+        ++pc;
+
+        switch (instr.kind) {
+        case InstructionKind::ASSIGN:
+            write(instr.dst, read(instr.lhs, line), line);
+            break;
+        case InstructionKind::BINARY: {
+            const int64_t lhs = read(instr.lhs, line);
+            const int64_t rhs = read(instr.rhs, line);
+            write(instr.dst, evaluate(instr.op, lhs, rhs, line), line);
+            break;
+        }
+        case InstructionKind::UNARY:
+            write(instr.dst, ~read(instr.lhs, line), line);
+            break;
+        case InstructionKind::PUSH:
+            ++statistics.stackOperations;
+            pushData(read(instr.lhs.isNone() ? Operand::reg(0) : instr.lhs,
+                          line));
+            break;
+        case InstructionKind::POP:
+            ++statistics.stackOperations;
+            write(instr.dst.isNone() ? Operand::reg(0) : instr.dst,
+                  popData(line), line);
+            break;
+        case InstructionKind::STACK_OP: {
+            ++statistics.stackOperations;
+            const int64_t rhs = popData(line);
+            const int64_t lhs = popData(line);
+            pushData(evaluate(instr.op, lhs, rhs, line));
+            break;
+        }
+        case InstructionKind::CALL:
+            ++statistics.calls;
+            callStack.push_back(pc);
+            statistics.maxCallDepth =
+                std::max(statistics.maxCallDepth, callStack.size());
+            pc = decoded.target;
+            break;
+        case InstructionKind::RETURN:
+            if (callStack.empty()) {
+                pc = code.size(); // Returning from main ends the program
+            } else {
+                pc = callStack.back();
+                callStack.pop_back();
+            }
+            break;
+        case InstructionKind::GOTO:
+            pc = decoded.target;
+            break;
+        case InstructionKind::IF_GOTO:
+            if (compare(instr.op, read(instr.lhs, line),
+                        read(instr.rhs, line))) {
+                pc = decoded.target;
+            }
+            break;
+        case InstructionKind::SYSCALL: {
+            const int64_t result = syscall(exitRequested, line);
+            if (exitRequested) {
+                exitCode = result;
+                pc = code.size();
+            } else {
+                registers[0] = result;
+            }
+            break;
+        }
+        default:
+            break; // nop
+        }
+    }
+
+    if (!exitRequested && !dataStack.empty()) {
+        exitCode = dataStack.back();
+    }
+    return exitCode;
+}
+
+} // namespace vm
+} // namespace calpha
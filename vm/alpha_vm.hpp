@@ -0,0 +1,131 @@
+#pragma once
+
+#include "instruction.hpp"
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace calpha {
+namespace vm {
+
+// Reference executor for the Alpha_TUI code produced by CodeGenerator.
+//
+// The program text is decoded once into a flat instruction array; labels are
+// dropped and every call/jump target is resolved to an index, so execution
+// never touches strings. Memory cells, registers and both stacks hold 64-bit
+// integers. The data stack (push/pop/stack-ops) and the call stack
+// (call/return) are separate, matching Alpha_TUI.
+//
+// Execution starts at the "main" label when present (otherwise at the first
+// instruction) and ends on "goto END", on "return" with an empty call stack,
+// on the exit syscall or when running past the last instruction.
+//
+// Syscalls follow the Linux x86-64 numbering with the number in a0 and the
+// arguments in a1..a6. Buffer arguments are cell addresses; byte counts are
+// applied to the little-endian byte image of the cells (8 bytes per cell).
+class VirtualMachine {
+  public:
+    static constexpr int kRegisterCount = 8;
+    static constexpr int64_t kSyscallRead = 0;
+    static constexpr int64_t kSyscallWrite = 1;
+    static constexpr int64_t kSyscallExit = 60;
+
+    struct Statistics {
+        uint64_t instructions{0}; // Executed instructions (labels excluded)
+        uint64_t stackOperations{0}; // push, pop and stack+ ... stack%
+        uint64_t memoryAccesses{0};  // Reads and writes of p(..) cells
+        uint64_t calls{0};
+        uint64_t syscalls{0};
+        size_t maxStackDepth{0};
+        size_t maxCallDepth{0};
+        size_t memoryCells{0}; // Highest touched cell + 1
+    };
+
+    explicit VirtualMachine(std::istream &input = std::cin,
+                            std::ostream &output = std::cout,
+                            std::ostream &error = std::cerr);
+
+    // Decodes and links a program; throws AlphaSyntaxError or VMError
+    void load(const std::string &source);
+    void load(const std::vector<Instruction> &program);
+
+    // Runs until the program halts and returns its exit code: the exit
+    // syscall argument, or the value left on top of the data stack by main
+    int64_t run();
+
+    // Aborts execution with a VMError once this many instructions ran
+    // (0 = unlimited)
+    void setInstructionLimit(uint64_t limit) {
+        instructionLimit = limit;
+    }
+
+    [[nodiscard]] const Statistics &getStatistics() const {
+        return statistics;
+    }
+    [[nodiscard]] int64_t getRegister(int index) const;
+    [[nodiscard]] int64_t getMemory(int64_t address) const;
+    [[nodiscard]] const std::vector<int64_t> &getDataStack() const {
+        return dataStack;
+    }
+    // Number of decoded (executable) instructions
+    [[nodiscard]] size_t getProgramSize() const {
+        return code.size();
+    }
+
+    void reset();
+
+  private:
+    // Pre-decoded instruction: the original instruction plus its resolved
+    // jump target (index into code)
+    struct DecodedInstruction {
+        Instruction instruction;
+        size_t target{0};
+        int sourceLine{0};
+    };
+
+    std::istream &input;
+    std::ostream &output;
+    std::ostream &error;
+
+    std::vector<DecodedInstruction> code;
+    size_t entryPoint{0};
+
+    int64_t registers[kRegisterCount]{};
+    std::vector<int64_t> memory;
+    std::vector<int64_t> dataStack;
+    std::vector<size_t> callStack;
+
+    uint64_t instructionLimit{0};
+    Statistics statistics;
+
+    int64_t read(const Operand &operand, int line);
+    void write(const Operand &operand, int64_t value, int line);
+    int64_t &cell(int64_t address, int line);
+    int64_t popData(int line);
+    void pushData(int64_t value);
+    int64_t syscall(bool &halt, int line);
+
+    static int64_t evaluate(AlphaOperator op, int64_t lhs, int64_t rhs,
+                            int line);
+    static bool compare(AlphaOperator op, int64_t lhs, int64_t rhs);
+};
+
+class VMError final : public std::exception {
+  private:
+    std::string message;
+
+  public:
+    VMError(const std::string &msg, int line)
+        : message(line > 0 ? "line " + std::to_string(line) + ": " + msg
+                           : msg) {
+    }
+
+    [[nodiscard]] const char *what() const noexcept override {
+        return message.c_str();
+    }
+};
+
+} // namespace vm
+} // namespace calpha
@@ -0,0 +1,80 @@
+#include "alpha_vm.hpp"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+using namespace calpha::vm;
+
+// Args: 1. path/to/program.alpha
+//       --stats        print execution statistics to stderr
+//       --limit <n>    abort after n executed instructions
+
+int main(int argc, char *argv[]) {
+    std::string programPath;
+    bool printStats = false;
+    uint64_t limit = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--stats") == 0) {
+            printStats = true;
+        } else if (std::strcmp(argv[i], "--limit") == 0 && i + 1 < argc) {
+            limit = std::stoull(argv[++i]);
+        } else if (programPath.empty()) {
+            programPath = argv[i];
+        } else {
+            programPath.clear();
+            break;
+        }
+    }
+
+    if (programPath.empty()) {
+        std::cerr << "Usage: " << argv[0]
+                  << " <path/to/program.alpha> [--stats] [--limit <n>]"
+                  << std::endl;
+        return 1;
+    }
+
+    std::ifstream file(programPath);
+    if (!file) {
+        std::cerr << "Cannot open " << programPath << std::endl;
+        return 1;
+    }
+    std::stringstream source;
+    source << file.rdbuf();
+
+    VirtualMachine machine;
+    machine.setInstructionLimit(limit);
+
+    int64_t exitCode = 0;
+    try {
+        machine.load(source.str());
+        exitCode = machine.run();
+    } catch (const std::exception &e) {
+        std::cerr << "alpha_vm: " << e.what() << std::endl;
+        return 1;
+    }
+
+    const auto &stats = machine.getStatistics();
+    if (printStats) {
+        std::cerr << "=== EXECUTION STATISTICS ===" << '\n'
+                  << "Exit code:             " << exitCode << '\n'
+                  << "Program size:          " << machine.getProgramSize()
+                  << '\n'
+                  << "Instructions executed: " << stats.instructions << '\n'
+                  << "Stack operations:      " << stats.stackOperations << '\n'
+                  << "Memory accesses:       " << stats.memoryAccesses << '\n'
+                  << "Calls:                 " << stats.calls << '\n'
+                  << "Syscalls:              " << stats.syscalls << '\n'
+                  << "Max stack depth:       " << stats.maxStackDepth << '\n'
+                  << "Max call depth:        " << stats.maxCallDepth << '\n'
+                  << "Memory cells touched:  " << stats.memoryCells
+                  << std::endl;
+    } else {
+        std::cerr << "Instructions executed: " << stats.instructions
+                  << std::endl;
+    }
+
+    return static_cast<int>(exitCode & 0xFF);
+}